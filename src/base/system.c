@@ -614,6 +614,21 @@ int net_addr_comp(const NETADDR *a, const NETADDR *b)
 	return mem_comp(a, b, sizeof(NETADDR));
 }
 
+unsigned net_addr_hash(const NETADDR *addr, int add_port)
+{
+	/* fnv-1a over the address bytes in use */
+	unsigned hash = 2166136261u;
+	int i;
+	for(i = 0; i < (addr->type == NETTYPE_IPV4 ? 4 : 16); i++)
+		hash = (hash^addr->ip[i])*16777619u;
+	if(add_port)
+	{
+		hash = (hash^(addr->port&0xff))*16777619u;
+		hash = (hash^(addr->port>>8))*16777619u;
+	}
+	return (hash^addr->type)*16777619u;
+}
+
 void net_addr_str(const NETADDR *addr, char *string, int max_length, int add_port)
 {
 	if(addr->type == NETTYPE_IPV4)
@@ -781,7 +796,9 @@ int net_addr_from_str(NETADDR *addr, const char *string)
 				return -1;
 		}
 #else
-		if(inet_pton(AF_INET6, buf, &sa6) != 1)
+		mem_zero(&sa6, sizeof(sa6));
+		sa6.sin6_family = AF_INET6;
+		if(inet_pton(AF_INET6, buf, &sa6.sin6_addr) != 1)
 			return -1;
 #endif
 		sockaddr_to_netaddr((struct sockaddr *)&sa6, addr);
@@ -852,7 +869,7 @@ static int priv_net_close_all_sockets(NETSOCKET sock)
 	return 0;
 }
 
-static int priv_net_create_socket(int domain, int type, struct sockaddr *addr, int sockaddrlen)
+static int priv_net_create_socket(int domain, int type, struct sockaddr *addr, int sockaddrlen, int reuseport)
 {
 	int sock, e;
 
@@ -881,6 +898,15 @@ static int priv_net_create_socket(int domain, int type, struct sockaddr *addr, i
 	}
 #endif
 
+	/* let other sockets bind to the same port, the kernel spreads the packets over them */
+#if defined(CONF_PLATFORM_LINUX) && defined(SO_REUSEPORT)
+	if(reuseport)
+	{
+		int enable = 1;
+		setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (const char*)&enable, sizeof(enable));
+	}
+#endif
+
 	/* bind the socket */
 	e = bind(sock, addr, sockaddrlen);
 	if(e != 0)
@@ -902,7 +928,7 @@ static int priv_net_create_socket(int domain, int type, struct sockaddr *addr, i
 	return sock;
 }
 
-NETSOCKET net_udp_create(NETADDR bindaddr)
+static NETSOCKET priv_net_udp_create(NETADDR bindaddr, int reuseport)
 {
 	NETSOCKET sock = invalid_socket;
 	NETADDR tmpbindaddr = bindaddr;
@@ -917,7 +943,7 @@ NETSOCKET net_udp_create(NETADDR bindaddr)
 		/* bind, we should check for error */
 		tmpbindaddr.type = NETTYPE_IPV4;
 		netaddr_to_sockaddr_in(&tmpbindaddr, &addr);
-		socket = priv_net_create_socket(AF_INET, SOCK_DGRAM, (struct sockaddr *)&addr, sizeof(addr));
+		socket = priv_net_create_socket(AF_INET, SOCK_DGRAM, (struct sockaddr *)&addr, sizeof(addr), reuseport);
 		if(socket >= 0)
 		{
 			sock.type |= NETTYPE_IPV4;
@@ -939,7 +965,7 @@ NETSOCKET net_udp_create(NETADDR bindaddr)
 		/* bind, we should check for error */
 		tmpbindaddr.type = NETTYPE_IPV6;
 		netaddr_to_sockaddr_in6(&tmpbindaddr, &addr);
-		socket = priv_net_create_socket(AF_INET6, SOCK_DGRAM, (struct sockaddr *)&addr, sizeof(addr));
+		socket = priv_net_create_socket(AF_INET6, SOCK_DGRAM, (struct sockaddr *)&addr, sizeof(addr), reuseport);
 		if(socket >= 0)
 		{
 			sock.type |= NETTYPE_IPV6;
@@ -960,6 +986,21 @@ NETSOCKET net_udp_create(NETADDR bindaddr)
 	return sock;
 }
 
+NETSOCKET net_udp_create(NETADDR bindaddr)
+{
+	return priv_net_udp_create(bindaddr, 0);
+}
+
+NETSOCKET net_udp_create_reuseport(NETADDR bindaddr)
+{
+#if defined(CONF_PLATFORM_LINUX) && defined(SO_REUSEPORT)
+	return priv_net_udp_create(bindaddr, 1);
+#else
+	dbg_msg("net", "sharing a port between sockets is not supported on this platform");
+	return invalid_socket;
+#endif
+}
+
 int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size)
 {
 	int d = -1;
@@ -1076,7 +1117,7 @@ NETSOCKET net_tcp_create(NETADDR bindaddr)
 		/* bind, we should check for error */
 		tmpbindaddr.type = NETTYPE_IPV4;
 		netaddr_to_sockaddr_in(&tmpbindaddr, &addr);
-		socket = priv_net_create_socket(AF_INET, SOCK_STREAM, (struct sockaddr *)&addr, sizeof(addr));
+		socket = priv_net_create_socket(AF_INET, SOCK_STREAM, (struct sockaddr *)&addr, sizeof(addr), 0);
 		if(socket >= 0)
 		{
 			sock.type |= NETTYPE_IPV4;
@@ -1092,7 +1133,7 @@ NETSOCKET net_tcp_create(NETADDR bindaddr)
 		/* bind, we should check for error */
 		tmpbindaddr.type = NETTYPE_IPV6;
 		netaddr_to_sockaddr_in6(&tmpbindaddr, &addr);
-		socket = priv_net_create_socket(AF_INET6, SOCK_STREAM, (struct sockaddr *)&addr, sizeof(addr));
+		socket = priv_net_create_socket(AF_INET6, SOCK_STREAM, (struct sockaddr *)&addr, sizeof(addr), 0);
 		if(socket >= 0)
 		{
 			sock.type |= NETTYPE_IPV6;
@@ -529,6 +529,19 @@ int net_host_lookup(const char *hostname, NETADDR *addr, int types);
 */
 int net_addr_comp(const NETADDR *a, const NETADDR *b);
 
+/*
+	Function: net_addr_hash
+		Hashes a network address, equal addresses get equal hashes.
+
+	Parameters:
+		addr - Address to hash.
+		add_port - hash the port as well or not
+
+	Returns:
+		The hash, not reduced to any table size.
+*/
+unsigned net_addr_hash(const NETADDR *addr, int add_port);
+
 /*
 	Function: net_addr_str
 		Turns a network address into a representive string.
@@ -573,6 +586,21 @@ int net_addr_from_str(NETADDR *addr, const char *string);
 */
 NETSOCKET net_udp_create(NETADDR bindaddr);
 
+/*
+	Function: net_udp_create_reuseport
+		Creates a UDP socket and binds it to a port that other sockets
+		created this way can bind to as well. The system spreads the
+		incoming packets over them. Only supported on Linux.
+
+	Parameters:
+		bindaddr - Address to bind the socket to.
+
+	Returns:
+		On success it returns an handle to the socket. On failure it
+		returns NETSOCKET_INVALID.
+*/
+NETSOCKET net_udp_create_reuseport(NETADDR bindaddr);
+
 /*
 	Function: net_udp_send
 		Sends a packet over an UDP socket.
@@ -163,6 +163,7 @@ public:
 	virtual const char *Version() = 0;
 	virtual const char *NetVersion() = 0;
 
+	virtual int NumAssetsPending() const = 0;
 };
 
 extern IGameClient *CreateGameClient();
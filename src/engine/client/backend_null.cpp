@@ -0,0 +1,207 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <base/tl/threading.h>
+
+#include "backend_null.h"
+
+// ------------ CGraphicsBackend_Null
+
+CGraphicsBackend_Null::CGraphicsBackend_Null()
+{
+	mem_zero(&m_Stats, sizeof(m_Stats));
+	mem_zero(m_aTextureMemSize, sizeof(m_aTextureMemSize));
+	m_ScreenWidth = 0;
+	m_ScreenHeight = 0;
+	m_TextureMemoryUsage = 0;
+}
+
+int CGraphicsBackend_Null::TexFormatToPixelSize(int TexFormat)
+{
+	if(TexFormat == CCommandBuffer::TEXFORMAT_RGB) return 3;
+	if(TexFormat == CCommandBuffer::TEXFORMAT_ALPHA) return 1;
+	return 4;
+}
+
+void CGraphicsBackend_Null::Cmd_Texture_Create(const CCommandBuffer::SCommand_Texture_Create *pCommand)
+{
+	int Width = pCommand->m_Width;
+	int Height = pCommand->m_Height;
+	int PixelSize = TexFormatToPixelSize(pCommand->m_StoreFormat);
+
+	// calculate memory usage the same way a real driver would store it, including the mip chain
+	int MemSize = Width*Height*PixelSize;
+	if(!(pCommand->m_Flags&CCommandBuffer::TEXFLAG_NOMIPMAPS))
+	{
+		while(Width > 2 && Height > 2)
+		{
+			Width >>= 1;
+			Height >>= 1;
+			MemSize += Width*Height*PixelSize;
+		}
+	}
+
+	m_TextureMemoryUsage += MemSize - m_aTextureMemSize[pCommand->m_Slot];
+	m_aTextureMemSize[pCommand->m_Slot] = MemSize;
+
+	m_Stats.m_NumTextureCreates++;
+	m_Stats.m_TextureUploadBytes += pCommand->m_Width*pCommand->m_Height*TexFormatToPixelSize(pCommand->m_Format);
+	mem_free(pCommand->m_pData);
+}
+
+void CGraphicsBackend_Null::Cmd_Texture_Update(const CCommandBuffer::SCommand_Texture_Update *pCommand)
+{
+	m_Stats.m_NumTextureUpdates++;
+	m_Stats.m_TextureUploadBytes += pCommand->m_Width*pCommand->m_Height*TexFormatToPixelSize(pCommand->m_Format);
+	mem_free(pCommand->m_pData);
+}
+
+void CGraphicsBackend_Null::Cmd_Texture_Destroy(const CCommandBuffer::SCommand_Texture_Destroy *pCommand)
+{
+	m_TextureMemoryUsage -= m_aTextureMemSize[pCommand->m_Slot];
+	m_aTextureMemSize[pCommand->m_Slot] = 0;
+	m_Stats.m_NumTextureDestroys++;
+}
+
+void CGraphicsBackend_Null::Cmd_Render(const CCommandBuffer::SCommand_Render *pCommand)
+{
+	m_Stats.m_NumRenderCalls++;
+	m_Stats.m_NumPrimitives += pCommand->m_PrimCount;
+
+	switch(pCommand->m_PrimType)
+	{
+	case CCommandBuffer::PRIMTYPE_QUADS: m_Stats.m_NumVertices += pCommand->m_PrimCount*4; break;
+	case CCommandBuffer::PRIMTYPE_LINES: m_Stats.m_NumVertices += pCommand->m_PrimCount*2; break;
+	default:
+		dbg_msg("gfx", "unknown primtype %d", pCommand->m_PrimType);
+	};
+}
+
+void CGraphicsBackend_Null::Cmd_Screenshot(const CCommandBuffer::SCommand_Screenshot *pCommand)
+{
+	// there is no framebuffer to read back, hand out a black image of the right size
+	int w = m_ScreenWidth;
+	int h = m_ScreenHeight;
+	unsigned char *pPixelData = (unsigned char *)mem_alloc(w*h*3, 1);
+	mem_zero(pPixelData, w*h*3);
+
+	pCommand->m_pImage->m_Width = w;
+	pCommand->m_pImage->m_Height = h;
+	pCommand->m_pImage->m_Format = CImageInfo::FORMAT_RGB;
+	pCommand->m_pImage->m_pData = pPixelData;
+}
+
+void CGraphicsBackend_Null::Cmd_VideoModes(const CCommandBuffer::SCommand_VideoModes *pCommand)
+{
+	// only the mode we were initialized with is available
+	int NumModes = 0;
+	if(pCommand->m_MaxModes > 0)
+	{
+		pCommand->m_pModes[0].m_Width = m_ScreenWidth;
+		pCommand->m_pModes[0].m_Height = m_ScreenHeight;
+		pCommand->m_pModes[0].m_Red = 8;
+		pCommand->m_pModes[0].m_Green = 8;
+		pCommand->m_pModes[0].m_Blue = 8;
+		NumModes = 1;
+	}
+	*pCommand->m_pNumModes = NumModes;
+}
+
+void CGraphicsBackend_Null::RunBuffer(CCommandBuffer *pBuffer)
+{
+	m_Stats.m_NumBuffers++;
+	m_Stats.m_CommandBytes += pBuffer->m_CmdBuffer.DataUsed();
+	m_Stats.m_DataBytes += pBuffer->m_DataBuffer.DataUsed();
+
+	unsigned CmdIndex = 0;
+	while(1)
+	{
+		const CCommandBuffer::SCommand *pBaseCommand = pBuffer->GetCommand(&CmdIndex);
+		if(pBaseCommand == 0x0)
+			break;
+
+		m_Stats.m_NumCommands++;
+
+		switch(pBaseCommand->m_Cmd)
+		{
+		case CCommandBuffer::CMD_NOP: break;
+		case CCommandBuffer::CMD_RUNBUFFER: RunBuffer(static_cast<const CCommandBuffer::SCommand_RunBuffer *>(pBaseCommand)->m_pOtherBuffer); break;
+		case CCommandBuffer::CMD_SIGNAL: static_cast<const CCommandBuffer::SCommand_Signal *>(pBaseCommand)->m_pSemaphore->signal(); break;
+		case CCommandBuffer::CMD_TEXTURE_CREATE: Cmd_Texture_Create(static_cast<const CCommandBuffer::SCommand_Texture_Create *>(pBaseCommand)); break;
+		case CCommandBuffer::CMD_TEXTURE_DESTROY: Cmd_Texture_Destroy(static_cast<const CCommandBuffer::SCommand_Texture_Destroy *>(pBaseCommand)); break;
+		case CCommandBuffer::CMD_TEXTURE_UPDATE: Cmd_Texture_Update(static_cast<const CCommandBuffer::SCommand_Texture_Update *>(pBaseCommand)); break;
+		case CCommandBuffer::CMD_CLEAR: m_Stats.m_NumClears++; break;
+		case CCommandBuffer::CMD_RENDER: Cmd_Render(static_cast<const CCommandBuffer::SCommand_Render *>(pBaseCommand)); break;
+		case CCommandBuffer::CMD_SWAP: m_Stats.m_NumFrames++; break;
+		case CCommandBuffer::CMD_SCREENSHOT: Cmd_Screenshot(static_cast<const CCommandBuffer::SCommand_Screenshot *>(pBaseCommand)); break;
+		case CCommandBuffer::CMD_VIDEOMODES: Cmd_VideoModes(static_cast<const CCommandBuffer::SCommand_VideoModes *>(pBaseCommand)); break;
+		default:
+			dbg_msg("graphics", "unknown command %d", pBaseCommand->m_Cmd);
+		}
+	}
+}
+
+bool CGraphicsBackend_Null::IsIdle() const
+{
+	// buffers are consumed synchronously in RunBuffer
+	return true;
+}
+
+void CGraphicsBackend_Null::WaitForIdle()
+{
+}
+
+int CGraphicsBackend_Null::Init(const char *pName, int *Width, int *Height, int FsaaSamples, int Flags)
+{
+	// there is no desktop to take the resolution from
+	if(*Width == 0 || *Height == 0)
+	{
+		*Width = 1280;
+		*Height = 720;
+	}
+
+	m_ScreenWidth = *Width;
+	m_ScreenHeight = *Height;
+
+	dbg_msg("gfx", "using null backend, %dx%d", m_ScreenWidth, m_ScreenHeight);
+	return 0;
+}
+
+int CGraphicsBackend_Null::Shutdown()
+{
+	int64 Frames = max(m_Stats.m_NumFrames, (int64)1);
+	dbg_msg("gfx", "null backend: frames=%lld buffers=%lld commands=%lld renders=%lld clears=%lld",
+		m_Stats.m_NumFrames, m_Stats.m_NumBuffers, m_Stats.m_NumCommands, m_Stats.m_NumRenderCalls, m_Stats.m_NumClears);
+	dbg_msg("gfx", "null backend: primitives=%lld vertices=%lld cmdbytes=%lld databytes=%lld",
+		m_Stats.m_NumPrimitives, m_Stats.m_NumVertices, m_Stats.m_CommandBytes, m_Stats.m_DataBytes);
+	dbg_msg("gfx", "null backend: per frame commands=%lld renders=%lld vertices=%lld databytes=%lld",
+		m_Stats.m_NumCommands/Frames, m_Stats.m_NumRenderCalls/Frames, m_Stats.m_NumVertices/Frames, m_Stats.m_DataBytes/Frames);
+	dbg_msg("gfx", "null backend: textures created=%lld updated=%lld destroyed=%lld uploaded=%lld bytes",
+		m_Stats.m_NumTextureCreates, m_Stats.m_NumTextureUpdates, m_Stats.m_NumTextureDestroys, m_Stats.m_TextureUploadBytes);
+	return 0;
+}
+
+int CGraphicsBackend_Null::MemoryUsage() const
+{
+	return m_TextureMemoryUsage;
+}
+
+void CGraphicsBackend_Null::Minimize()
+{
+}
+
+void CGraphicsBackend_Null::Maximize()
+{
+}
+
+int CGraphicsBackend_Null::WindowActive()
+{
+	return 1;
+}
+
+int CGraphicsBackend_Null::WindowOpen()
+{
+	return 1;
+}
+
+
+IGraphicsBackend *CreateGraphicsBackendNull() { return new CGraphicsBackend_Null; }
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "graphics_threaded.h"
+
+// consumes command buffers without talking to any video driver, only
+// records what would have been sent to the gpu. used to profile and
+// regression test the cpu side of the render path on headless machines
+class CGraphicsBackend_Null : public IGraphicsBackend
+{
+public:
+	struct CStats
+	{
+		int64 m_NumFrames;
+		int64 m_NumBuffers;
+		int64 m_NumCommands;
+		int64 m_NumRenderCalls;
+		int64 m_NumPrimitives;
+		int64 m_NumVertices;
+		int64 m_NumClears;
+		int64 m_NumTextureCreates;
+		int64 m_NumTextureUpdates;
+		int64 m_NumTextureDestroys;
+		int64 m_TextureUploadBytes;
+		int64 m_CommandBytes;
+		int64 m_DataBytes;
+	};
+
+	CGraphicsBackend_Null();
+
+	virtual int Init(const char *pName, int *Width, int *Height, int FsaaSamples, int Flags);
+	virtual int Shutdown();
+
+	virtual int MemoryUsage() const;
+
+	virtual void Minimize();
+	virtual void Maximize();
+	virtual int WindowActive();
+	virtual int WindowOpen();
+
+	virtual void RunBuffer(CCommandBuffer *pBuffer);
+	virtual bool IsIdle() const;
+	virtual void WaitForIdle();
+
+	const CStats *Stats() const { return &m_Stats; }
+
+private:
+	CStats m_Stats;
+	int m_ScreenWidth;
+	int m_ScreenHeight;
+	int m_TextureMemoryUsage;
+	int m_aTextureMemSize[CCommandBuffer::MAX_TEXTURES];
+
+	static int TexFormatToPixelSize(int TexFormat);
+
+	void Cmd_Texture_Create(const CCommandBuffer::SCommand_Texture_Create *pCommand);
+	void Cmd_Texture_Update(const CCommandBuffer::SCommand_Texture_Update *pCommand);
+	void Cmd_Texture_Destroy(const CCommandBuffer::SCommand_Texture_Destroy *pCommand);
+	void Cmd_Render(const CCommandBuffer::SCommand_Render *pCommand);
+	void Cmd_Screenshot(const CCommandBuffer::SCommand_Screenshot *pCommand);
+	void Cmd_VideoModes(const CCommandBuffer::SCommand_VideoModes *pCommand);
+};
+
+extern IGraphicsBackend *CreateGraphicsBackendNull();
@@ -471,6 +471,13 @@ void CCommandProcessor_SDL_OpenGL::RunBuffer(CCommandBuffer *pBuffer)
 		const CCommandBuffer::SCommand *pBaseCommand = pBuffer->GetCommand(&CmdIndex);
 		if(pBaseCommand == 0x0)
 			break;
+
+		// recorded buffers get played back in place
+		if(pBaseCommand->m_Cmd == CCommandBuffer::CMD_RUNBUFFER)
+		{
+			RunBuffer(static_cast<const CCommandBuffer::SCommand_RunBuffer *>(pBaseCommand)->m_pOtherBuffer);
+			continue;
+		}
 		
 		if(m_OpenGL.RunCommand(pBaseCommand))
 			continue;
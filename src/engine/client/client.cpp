@@ -268,6 +268,15 @@ CClient::CClient() : m_DemoPlayer(&m_SnapshotDelta), m_DemoRecorder(&m_SnapshotD
 	m_CurrentRecvTick = 0;
 	m_RconAuthed = 0;
 
+	m_Benchmark = false;
+	m_pBenchmarkFrameTimes = 0;
+	m_NumBenchmarkFrames = 0;
+	m_MaxBenchmarkFrames = 0;
+
+	m_StartupBenchmark = false;
+	m_InitDoneTime = 0;
+	m_FirstFrameTime = 0;
+
 	// version-checking
 	m_aVersionStr[0] = '0';
 	m_aVersionStr[1] = 0;
@@ -958,6 +967,13 @@ void CClient::ProcessConnlessPacket(CNetChunk *pPacket)
 		}
 	}
 
+	// changes to the server list from master server
+	if(pPacket->m_DataSize >= (int)sizeof(SERVERBROWSE_LIST_DELTA) &&
+		mem_comp(pPacket->m_pData, SERVERBROWSE_LIST_DELTA, sizeof(SERVERBROWSE_LIST_DELTA)) == 0)
+	{
+		m_ServerBrowser.SetListDelta(pPacket->m_Address, pPacket->m_pData, pPacket->m_DataSize);
+	}
+
 	// server info
 	if(pPacket->m_DataSize >= (int)sizeof(SERVERBROWSE_INFO) && mem_comp(pPacket->m_pData, SERVERBROWSE_INFO, sizeof(SERVERBROWSE_INFO)) == 0)
 	{
@@ -1525,9 +1541,22 @@ void CClient::Update()
 			m_PrevGameTick = pInfo->m_PreviousTick;
 			m_GameIntraTick = pInfo->m_IntraTick;
 			m_GameTickTime = pInfo->m_TickTime;
+
+			// the player pauses at the end of the demo, a running benchmark is done then
+			if(m_Benchmark && pInfo->m_Info.m_Paused)
+			{
+				BenchmarkReport();
+				Quit();
+			}
 		}
 		else
 		{
+			if(m_Benchmark)
+			{
+				BenchmarkReport();
+				Quit();
+			}
+
 			// disconnect on error
 			Disconnect();
 		}
@@ -1726,7 +1755,8 @@ void CClient::Run()
 
 	// init graphics
 	{
-		if(g_Config.m_GfxThreaded)
+		// the null backend only exists for the threaded graphics
+		if(g_Config.m_GfxThreaded || str_comp_nocase(g_Config.m_GfxBackend, "null") == 0)
 			m_pGraphics = CreateEngineGraphicsThreaded();
 		else
 			m_pGraphics = CreateEngineGraphics();
@@ -1783,6 +1813,7 @@ void CClient::Run()
 		return;
 
 	GameClient()->OnInit();
+	m_InitDoneTime = time_get();
 
 	char aBuf[256];
 	str_format(aBuf, sizeof(aBuf), "version %s", GameClient()->NetVersion());
@@ -1907,6 +1938,9 @@ void CClient::Run()
 					m_RenderFrameTimeHigh = m_RenderFrameTime;
 				m_FpsGraph.Add(1.0f/m_RenderFrameTime, 1,1,1);
 
+				if(m_Benchmark && State() == IClient::STATE_DEMOPLAYBACK)
+					BenchmarkAddFrame(m_RenderFrameTime);
+
 				m_LastRenderTime = Now;
 
 				if(g_Config.m_DbgStress)
@@ -1934,6 +1968,9 @@ void CClient::Run()
 					}
 					m_pGraphics->Swap();
 				}
+
+				if(m_StartupBenchmark)
+					StartupBenchmarkFrame();
 			}
 		}
 
@@ -2137,6 +2174,125 @@ void CClient::Con_Play(IConsole::IResult *pResult, void *pUserData)
 	pSelf->DemoPlayer_Play(pResult->GetString(0), IStorage::TYPE_ALL);
 }
 
+void CClient::Con_BenchmarkDemo(IConsole::IResult *pResult, void *pUserData)
+{
+	CClient *pSelf = (CClient *)pUserData;
+	const char *pError = pSelf->DemoPlayer_Play(pResult->GetString(0), IStorage::TYPE_ALL);
+	if(pError)
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "failed to start benchmark: %s", pError);
+		pSelf->m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "benchmark", aBuf);
+		pSelf->Quit();
+		return;
+	}
+
+	pSelf->m_Benchmark = true;
+	pSelf->m_NumBenchmarkFrames = 0;
+
+	// don't count the time it took to load the demo as a frame
+	pSelf->m_LastRenderTime = time_get();
+}
+
+void CClient::Con_BenchmarkSound(IConsole::IResult *pResult, void *pUserData)
+{
+	CClient *pSelf = (CClient *)pUserData;
+	int NumVoices = pResult->NumArguments() > 0 ? clamp(pResult->GetInteger(0), 1, 1024) : 64;
+	int Seconds = pResult->NumArguments() > 1 ? clamp(pResult->GetInteger(1), 1, 3600) : 10;
+	pSelf->m_pSound->Benchmark(NumVoices, Seconds);
+	pSelf->Quit();
+}
+
+void CClient::Con_BenchmarkStartup(IConsole::IResult *pResult, void *pUserData)
+{
+	CClient *pSelf = (CClient *)pUserData;
+	pSelf->m_StartupBenchmark = true;
+	pSelf->m_FirstFrameTime = 0;
+}
+
+void CClient::StartupBenchmarkFrame()
+{
+	int64 Now = time_get();
+	if(!m_FirstFrameTime)
+		m_FirstFrameTime = Now;
+
+	if(GameClient()->NumAssetsPending())
+		return;
+
+	m_StartupBenchmark = false;
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "init %.2fms, first frame %.2fms, all assets %.2fms",
+		(m_InitDoneTime-m_LocalStartTime)*1000.0f/time_freq(), (m_FirstFrameTime-m_LocalStartTime)*1000.0f/time_freq(),
+		(Now-m_LocalStartTime)*1000.0f/time_freq());
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "benchmark", aBuf);
+	Quit();
+}
+
+void CClient::BenchmarkAddFrame(float FrameTime)
+{
+	if(m_NumBenchmarkFrames == m_MaxBenchmarkFrames)
+	{
+		int NewMax = max(m_MaxBenchmarkFrames*2, 4096);
+		float *pNewFrameTimes = (float *)mem_alloc(NewMax*sizeof(float), 1);
+		if(m_pBenchmarkFrameTimes)
+		{
+			mem_copy(pNewFrameTimes, m_pBenchmarkFrameTimes, m_NumBenchmarkFrames*sizeof(float));
+			mem_free(m_pBenchmarkFrameTimes);
+		}
+		m_pBenchmarkFrameTimes = pNewFrameTimes;
+		m_MaxBenchmarkFrames = NewMax;
+	}
+
+	m_pBenchmarkFrameTimes[m_NumBenchmarkFrames++] = FrameTime;
+}
+
+static int CompareFrameTime(const void *pA, const void *pB)
+{
+	float A = *(const float *)pA;
+	float B = *(const float *)pB;
+	return A < B ? -1 : A > B ? 1 : 0;
+}
+
+void CClient::BenchmarkReport()
+{
+	char aBuf[256];
+	m_Benchmark = false;
+
+	if(m_NumBenchmarkFrames == 0)
+	{
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "benchmark", "no frames were rendered");
+		return;
+	}
+
+	float Total = 0.0f;
+	for(int i = 0; i < m_NumBenchmarkFrames; i++)
+		Total += m_pBenchmarkFrameTimes[i];
+
+	qsort(m_pBenchmarkFrameTimes, m_NumBenchmarkFrames, sizeof(float), CompareFrameTime);
+
+	static const float s_aPercentiles[] = {50.0f, 90.0f, 95.0f, 99.0f, 99.9f};
+	float aValues[sizeof(s_aPercentiles)/sizeof(s_aPercentiles[0])];
+	for(unsigned i = 0; i < sizeof(s_aPercentiles)/sizeof(s_aPercentiles[0]); i++)
+	{
+		int Index = clamp((int)(s_aPercentiles[i]/100.0f*m_NumBenchmarkFrames), 0, m_NumBenchmarkFrames-1);
+		aValues[i] = m_pBenchmarkFrameTimes[Index]*1000.0f;
+	}
+
+	str_format(aBuf, sizeof(aBuf), "frames=%d time=%.2fs avg=%.3fms (%.1f fps) min=%.3fms max=%.3fms",
+		m_NumBenchmarkFrames, Total, Total/m_NumBenchmarkFrames*1000.0f, m_NumBenchmarkFrames/Total,
+		m_pBenchmarkFrameTimes[0]*1000.0f, m_pBenchmarkFrameTimes[m_NumBenchmarkFrames-1]*1000.0f);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "benchmark", aBuf);
+	str_format(aBuf, sizeof(aBuf), "frame time p50=%.3fms p90=%.3fms p95=%.3fms p99=%.3fms p99.9=%.3fms",
+		aValues[0], aValues[1], aValues[2], aValues[3], aValues[4]);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "benchmark", aBuf);
+
+	mem_free(m_pBenchmarkFrameTimes);
+	m_pBenchmarkFrameTimes = 0;
+	m_NumBenchmarkFrames = 0;
+	m_MaxBenchmarkFrames = 0;
+}
+
 void CClient::DemoRecorder_Start(const char *pFilename, bool WithTimestamp)
 {
 	if(State() != IClient::STATE_ONLINE)
@@ -2238,6 +2394,9 @@ void CClient::RegisterCommands()
 	m_pConsole->Register("rcon", "r", CFGFLAG_CLIENT, Con_Rcon, this, "Send specified command to rcon");
 	m_pConsole->Register("rcon_auth", "s", CFGFLAG_CLIENT, Con_RconAuth, this, "Authenticate to rcon");
 	m_pConsole->Register("play", "r", CFGFLAG_CLIENT|CFGFLAG_STORE, Con_Play, this, "Play the file specified");
+	m_pConsole->Register("benchmark_demo", "r", CFGFLAG_CLIENT|CFGFLAG_STORE, Con_BenchmarkDemo, this, "Play the file specified, report frame time percentiles and quit");
+	m_pConsole->Register("benchmark_startup", "", CFGFLAG_CLIENT|CFGFLAG_STORE, Con_BenchmarkStartup, this, "Report the time it took until the first frame and until all images and sounds were loaded and quit");
+	m_pConsole->Register("benchmark_sound", "?i?i", CFGFLAG_CLIENT|CFGFLAG_STORE, Con_BenchmarkSound, this, "Mix the given number of voices for the given number of seconds of audio, report the time it took and quit");
 	m_pConsole->Register("record", "?s", CFGFLAG_CLIENT, Con_Record, this, "Record to the file");
 	m_pConsole->Register("stoprecord", "", CFGFLAG_CLIENT, Con_StopRecord, this, "Stop recording");
 	m_pConsole->Register("add_demomarker", "", CFGFLAG_CLIENT, Con_AddDemoMarker, this, "Add demo timeline marker");
@@ -175,6 +175,22 @@ class CClient : public IClient, public CDemoPlayer::IListner
 		class CHostLookup m_VersionServeraddr;
 	} m_VersionInfo;
 
+	// demo benchmark
+	bool m_Benchmark;
+	float *m_pBenchmarkFrameTimes;
+	int m_NumBenchmarkFrames;
+	int m_MaxBenchmarkFrames;
+
+	void BenchmarkAddFrame(float FrameTime);
+	void BenchmarkReport();
+
+	// startup benchmark
+	bool m_StartupBenchmark;
+	int64 m_InitDoneTime;
+	int64 m_FirstFrameTime;
+
+	void StartupBenchmarkFrame();
+
 	volatile int m_GfxState;
 	static void GraphicsThreadProxy(void *pThis) { ((CClient*)pThis)->GraphicsThread(); }
 	void GraphicsThread();
@@ -285,6 +301,9 @@ public:
 	static void Con_AddFavorite(IConsole::IResult *pResult, void *pUserData);
 	static void Con_RemoveFavorite(IConsole::IResult *pResult, void *pUserData);
 	static void Con_Play(IConsole::IResult *pResult, void *pUserData);
+	static void Con_BenchmarkDemo(IConsole::IResult *pResult, void *pUserData);
+	static void Con_BenchmarkSound(IConsole::IResult *pResult, void *pUserData);
+	static void Con_BenchmarkStartup(IConsole::IResult *pResult, void *pUserData);
 	static void Con_Record(IConsole::IResult *pResult, void *pUserData);
 	static void Con_StopRecord(IConsole::IResult *pResult, void *pUserData);
 	static void Con_AddDemoMarker(IConsole::IResult *pResult, void *pUserData);
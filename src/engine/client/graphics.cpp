@@ -700,6 +700,36 @@ void CGraphics_OpenGL::QuadsDrawFreeform(const CFreeformItem *pArray, int Num)
 	AddVertices(4*Num);
 }
 
+void CGraphics_OpenGL::QuadsDrawVertices(const CQuadVertex *pArray, int Num)
+{
+	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsDrawVertices without begin");
+
+	while(Num > 0)
+	{
+		// fill up the vertex buffer, flush it when it runs full
+		int Count = min(Num, (MAX_VERTICES-m_NumVertices)/4);
+		if(Count == 0)
+		{
+			Flush();
+			continue;
+		}
+
+		CVertex *pVertex = &m_aVertices[m_NumVertices];
+		for(int i = 0; i < 4*Count; i++, pVertex++)
+		{
+			pVertex->m_Pos.x = pArray[i].m_X;
+			pVertex->m_Pos.y = pArray[i].m_Y;
+			pVertex->m_Tex.u = pArray[i].m_U;
+			pVertex->m_Tex.v = pArray[i].m_V;
+			pVertex->m_Color = m_aColor[i&3];
+		}
+
+		pArray += 4*Count;
+		Num -= Count;
+		AddVertices(4*Count);
+	}
+}
+
 void CGraphics_OpenGL::QuadsText(float x, float y, float Size, const char *pText)
 {
 	float StartX = x;
@@ -119,6 +119,7 @@ public:
 	virtual void QuadsDraw(CQuadItem *pArray, int Num);
 	virtual void QuadsDrawTL(const CQuadItem *pArray, int Num);
 	virtual void QuadsDrawFreeform(const CFreeformItem *pArray, int Num);
+	virtual void QuadsDrawVertices(const CQuadVertex *pArray, int Num);
 	virtual void QuadsText(float x, float y, float Size, const char *pText);
 
 	virtual int Init();
@@ -145,6 +146,11 @@ public:
 	virtual void TakeScreenshot(const char *pFilename);
 	virtual void Swap();
 
+	virtual IGraphics *CreateRecorder() { return 0; }
+	virtual void DestroyRecorder(IGraphics *pRecorder) {}
+	virtual void RecorderBegin(IGraphics *pRecorder) {}
+	virtual void RecorderPlay(IGraphics *pRecorder) {}
+
 	virtual int GetVideoModes(CVideoMode *pModes, int MaxModes);
 
 	// syncronization
@@ -146,6 +146,10 @@ CGraphics_Threaded::CGraphics_Threaded()
 	m_apCommandBuffers[0] = 0x0;
 	m_apCommandBuffers[1] = 0x0;
 
+	m_pPrimary = 0x0;
+	mem_zero(m_aapRecordBuffers, sizeof(m_aapRecordBuffers));
+	m_NumRecordBuffers = 0;
+
 	m_NumVertices = 0;
 
 	m_ScreenWidth = -1;
@@ -267,6 +271,8 @@ void CGraphics_Threaded::LinesDraw(const CLineItem *pArray, int Num)
 
 int CGraphics_Threaded::UnloadTexture(int Index)
 {
+	dbg_assert(m_pPrimary == 0x0, "textures can't be changed from a recorder");
+
 	if(Index == m_InvalidTexture)
 		return 0;
 
@@ -303,6 +309,8 @@ static int ImageFormatToPixelSize(int Format)
 
 int CGraphics_Threaded::LoadTextureRawSub(int TextureID, int x, int y, int Width, int Height, int Format, const void *pData)
 {
+	dbg_assert(m_pPrimary == 0x0, "textures can't be changed from a recorder");
+
 	CCommandBuffer::SCommand_Texture_Update Cmd;
 	Cmd.m_Slot = TextureID;
 	Cmd.m_X = x;
@@ -326,6 +334,8 @@ int CGraphics_Threaded::LoadTextureRawSub(int TextureID, int x, int y, int Width
 
 int CGraphics_Threaded::LoadTextureRaw(int Width, int Height, int Format, const void *pData, int StoreFormat, int Flags)
 {
+	dbg_assert(m_pPrimary == 0x0, "textures can't be changed from a recorder");
+
 	// don't waste memory on texture if we are stress testing
 	if(g_Config.m_DbgStress)
 		return m_InvalidTexture;
@@ -438,6 +448,13 @@ int CGraphics_Threaded::LoadPNG(CImageInfo *pImg, const char *pFilename, int Sto
 
 void CGraphics_Threaded::KickCommandBuffer()
 {
+	// recorders can't submit anything, they continue in the next buffer of the chain
+	if(m_pPrimary)
+	{
+		NextRecordBuffer();
+		return;
+	}
+
 	m_pBackend->RunBuffer(m_pCommandBuffer);
 
 	// swap buffer
@@ -648,6 +665,36 @@ void CGraphics_Threaded::QuadsDrawFreeform(const CFreeformItem *pArray, int Num)
 	AddVertices(4*Num);
 }
 
+void CGraphics_Threaded::QuadsDrawVertices(const CQuadVertex *pArray, int Num)
+{
+	dbg_assert(m_Drawing == DRAWING_QUADS, "called Graphics()->QuadsDrawVertices without begin");
+
+	while(Num > 0)
+	{
+		// fill up the vertex buffer, flush it when it runs full
+		int Count = min(Num, (MAX_VERTICES-m_NumVertices)/4);
+		if(Count == 0)
+		{
+			FlushVertices();
+			continue;
+		}
+
+		CCommandBuffer::SVertex *pVertex = &m_aVertices[m_NumVertices];
+		for(int i = 0; i < 4*Count; i++, pVertex++)
+		{
+			pVertex->m_Pos.x = pArray[i].m_X;
+			pVertex->m_Pos.y = pArray[i].m_Y;
+			pVertex->m_Tex.u = pArray[i].m_U;
+			pVertex->m_Tex.v = pArray[i].m_V;
+			pVertex->m_Color = m_aColor[i&3];
+		}
+
+		pArray += 4*Count;
+		Num -= Count;
+		AddVertices(4*Count);
+	}
+}
+
 void CGraphics_Threaded::QuadsText(float x, float y, float Size, const char *pText)
 {
 	float StartX = x;
@@ -745,7 +792,10 @@ int CGraphics_Threaded::Init()
 		m_aTextureIndices[i] = i+1;
 	m_aTextureIndices[MAX_TEXTURES-1] = -1;
 
-	m_pBackend = CreateGraphicsBackend();
+	if(str_comp_nocase(g_Config.m_GfxBackend, "null") == 0)
+		m_pBackend = CreateGraphicsBackendNull();
+	else
+		m_pBackend = CreateGraphicsBackend();
 	if(InitWindow() != 0)
 		return -1;
 
@@ -815,6 +865,8 @@ void CGraphics_Threaded::TakeScreenshot(const char *pFilename)
 
 void CGraphics_Threaded::Swap()
 {
+	dbg_assert(m_pPrimary == 0x0, "called Graphics()->Swap on a recorder");
+
 	// TODO: screenshot support
 	if(m_DoScreenshot)
 	{
@@ -832,6 +884,84 @@ void CGraphics_Threaded::Swap()
 	KickCommandBuffer();
 }
 
+bool CGraphics_Threaded::NextRecordBuffer()
+{
+	int Set = m_CurrentCommandBuffer;
+	if(m_NumRecordBuffers == MAX_RECORD_BUFFERS)
+	{
+		dbg_msg("graphics", "recorder ran out of command buffers");
+		m_pCommandBuffer->Reset();
+		return false;
+	}
+
+	if(!m_aapRecordBuffers[Set][m_NumRecordBuffers])
+		m_aapRecordBuffers[Set][m_NumRecordBuffers] = new CCommandBuffer(32*1024, 512*1024);
+	m_pCommandBuffer = m_aapRecordBuffers[Set][m_NumRecordBuffers++];
+	m_pCommandBuffer->Reset();
+	return true;
+}
+
+IGraphics *CGraphics_Threaded::CreateRecorder()
+{
+	CGraphics_Threaded *pRecorder = new CGraphics_Threaded();
+	pRecorder->m_pPrimary = this;
+	for(int i = 0; i < MAX_VERTICES; i++)
+		pRecorder->m_aVertices[i].m_Pos.z = -5.0f;
+	return pRecorder;
+}
+
+void CGraphics_Threaded::DestroyRecorder(IGraphics *pRecorder)
+{
+	CGraphics_Threaded *pRec = static_cast<CGraphics_Threaded *>(pRecorder);
+	dbg_assert(pRec->m_pPrimary == this, "recorder belongs to another graphics");
+
+	// the backend might still play back the last recording
+	WaitForIdle();
+	for(int s = 0; s < NUM_CMDBUFFERS; s++)
+		for(int i = 0; i < MAX_RECORD_BUFFERS; i++)
+			delete pRec->m_aapRecordBuffers[s][i];
+	delete pRec;
+}
+
+void CGraphics_Threaded::RecorderBegin(IGraphics *pRecorder)
+{
+	CGraphics_Threaded *pRec = static_cast<CGraphics_Threaded *>(pRecorder);
+	dbg_assert(pRec->m_pPrimary == this, "recorder belongs to another graphics");
+	dbg_assert(m_Drawing == 0, "called Graphics()->RecorderBegin within begin");
+
+	// switch to the other set, the backend is done with it since the last swap
+	pRec->m_CurrentCommandBuffer ^= 1;
+	pRec->m_NumRecordBuffers = 0;
+	pRec->NextRecordBuffer();
+
+	// start out from the current state
+	pRec->m_State = m_State;
+	pRec->m_ScreenWidth = m_ScreenWidth;
+	pRec->m_ScreenHeight = m_ScreenHeight;
+	pRec->m_NumVertices = 0;
+	pRec->m_Drawing = 0;
+	pRec->m_Rotation = 0;
+}
+
+void CGraphics_Threaded::RecorderPlay(IGraphics *pRecorder)
+{
+	CGraphics_Threaded *pRec = static_cast<CGraphics_Threaded *>(pRecorder);
+	dbg_assert(pRec->m_pPrimary == this, "recorder belongs to another graphics");
+	dbg_assert(m_Drawing == 0 && pRec->m_Drawing == 0, "called Graphics()->RecorderPlay within begin");
+
+	for(int i = 0; i < pRec->m_NumRecordBuffers; i++)
+	{
+		CCommandBuffer::SCommand_RunBuffer Cmd;
+		Cmd.m_pOtherBuffer = pRec->m_aapRecordBuffers[pRec->m_CurrentCommandBuffer][i];
+		if(!m_pCommandBuffer->AddCommand(Cmd))
+		{
+			KickCommandBuffer();
+			m_pCommandBuffer->AddCommand(Cmd);
+		}
+	}
+	pRec->m_NumRecordBuffers = 0;
+}
+
 // syncronization
 void CGraphics_Threaded::InsertSignal(semaphore *pSemaphore)
 {
@@ -322,6 +322,7 @@ class CGraphics_Threaded : public IEngineGraphics
 	enum
 	{
 		NUM_CMDBUFFERS = 2,
+		MAX_RECORD_BUFFERS = 16,
 
 		MAX_VERTICES = 32*1024,
 		MAX_TEXTURES = 1024*4,
@@ -337,6 +338,12 @@ class CGraphics_Threaded : public IEngineGraphics
 	CCommandBuffer *m_pCommandBuffer;
 	unsigned m_CurrentCommandBuffer;
 
+	// set when this is a recorder. recorders fill a chain of buffers instead of kicking them,
+	// two sets so the backend can still run the last frame's recording while the next one starts
+	CGraphics_Threaded *m_pPrimary;
+	CCommandBuffer *m_aapRecordBuffers[NUM_CMDBUFFERS][MAX_RECORD_BUFFERS];
+	int m_NumRecordBuffers;
+
 	//
 	class IStorage *m_pStorage;
 	class IConsole *m_pConsole;
@@ -365,6 +372,7 @@ class CGraphics_Threaded : public IEngineGraphics
 	void Rotate4(const CCommandBuffer::SPoint &rCenter, CCommandBuffer::SVertex *pPoints);
 
 	void KickCommandBuffer();
+	bool NextRecordBuffer();
 
 	int IssueInit();
 	int InitWindow();
@@ -419,6 +427,7 @@ public:
 	virtual void QuadsDraw(CQuadItem *pArray, int Num);
 	virtual void QuadsDrawTL(const CQuadItem *pArray, int Num);
 	virtual void QuadsDrawFreeform(const CFreeformItem *pArray, int Num);
+	virtual void QuadsDrawVertices(const CQuadVertex *pArray, int Num);
 	virtual void QuadsText(float x, float y, float Size, const char *pText);
 
 	virtual void Minimize();
@@ -433,6 +442,11 @@ public:
 	virtual void TakeScreenshot(const char *pFilename);
 	virtual void Swap();
 
+	virtual IGraphics *CreateRecorder();
+	virtual void DestroyRecorder(IGraphics *pRecorder);
+	virtual void RecorderBegin(IGraphics *pRecorder);
+	virtual void RecorderPlay(IGraphics *pRecorder);
+
 	virtual int GetVideoModes(CVideoMode *pModes, int MaxModes);
 
 	// syncronization
@@ -442,3 +456,4 @@ public:
 };
 
 extern IGraphicsBackend *CreateGraphicsBackend();
+extern IGraphicsBackend *CreateGraphicsBackendNull();
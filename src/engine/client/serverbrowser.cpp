@@ -26,7 +26,22 @@ class SortWrap
 	CServerBrowser *m_pThis;
 public:
 	SortWrap(CServerBrowser *t, SortFunc f) : m_pfnSort(f), m_pThis(t) {}
-	bool operator()(int a, int b) { return (g_Config.m_BrSortOrder ? (m_pThis->*m_pfnSort)(b, a) : (m_pThis->*m_pfnSort)(a, b)); }
+	bool operator()(int a, int b)
+	{
+		if(g_Config.m_BrSortOrder ? (m_pThis->*m_pfnSort)(b, a) : (m_pThis->*m_pfnSort)(a, b))
+			return true;
+		if(g_Config.m_BrSortOrder ? (m_pThis->*m_pfnSort)(a, b) : (m_pThis->*m_pfnSort)(b, a))
+			return false;
+
+		// equal entries stay in list order, so a single entry can be put where a full sort would put it
+		return a < b;
+	}
+};
+
+enum
+{
+	SORTHASH_SORTBITS=0xf|(1<<9), // m_BrSort and m_BrSortOrder, changing them doesn't need a new filter pass
+	MIN_PROBE_RATE=20,
 };
 
 CServerBrowser::CServerBrowser()
@@ -37,14 +52,28 @@ CServerBrowser::CServerBrowser()
 
 	m_NumFavoriteServers = 0;
 
-	mem_zero(m_aServerlistIp, sizeof(m_aServerlistIp));
+	m_ppServerTable = 0;
+	m_ServerTableSize = 0;
 
 	m_pFirstReqServer = 0; // request list
 	m_pLastReqServer = 0;
 	m_NumRequests = 0;
 
+	m_ProbeTokens = 0;
+	m_ProbeRate = 0;
+	m_LastProbeTime = 0;
+	m_ProbeRtt = 0;
+	m_ProbeStartTime = 0;
+	m_LastProbeBackoff = 0;
+	m_NumProbesSent = 0;
+	m_NumProbeReplies = 0;
+	m_NumProbeRetries = 0;
+	m_NumProbeTimeouts = 0;
+
 	m_NeedRefresh = 0;
 
+	mem_zero(m_aMasterLists, sizeof(m_aMasterLists));
+
 	m_NumSortedServers = 0;
 	m_NumSortedServersCapacity = 0;
 	m_NumServers = 0;
@@ -125,134 +154,145 @@ bool CServerBrowser::SortCompareNumClients(int Index1, int Index2) const
 	return a->m_Info.m_NumClients < b->m_Info.m_NumClients;
 }
 
-void CServerBrowser::Filter()
+void CServerBrowser::Filter(CServerEntry *pEntry)
 {
-	int i = 0, p = 0;
-	m_NumSortedServers = 0;
-
-	// allocate the sorted list
-	if(m_NumSortedServersCapacity < m_NumServers)
+	int p = 0;
+	int Filtered = 0;
+
+	if(g_Config.m_BrFilterEmpty && ((g_Config.m_BrFilterSpectators && pEntry->m_Info.m_NumPlayers == 0) || pEntry->m_Info.m_NumClients == 0))
+		Filtered = 1;
+	else if(g_Config.m_BrFilterFull && ((g_Config.m_BrFilterSpectators && pEntry->m_Info.m_NumPlayers == pEntry->m_Info.m_MaxPlayers) ||
+			pEntry->m_Info.m_NumClients == pEntry->m_Info.m_MaxClients))
+		Filtered = 1;
+	else if(g_Config.m_BrFilterPw && pEntry->m_Info.m_Flags&SERVER_FLAG_PASSWORD)
+		Filtered = 1;
+	else if(g_Config.m_BrFilterPure &&
+		(str_comp(pEntry->m_Info.m_aGameType, "DM") != 0 &&
+		str_comp(pEntry->m_Info.m_aGameType, "TDM") != 0 &&
+		str_comp(pEntry->m_Info.m_aGameType, "CTF") != 0))
 	{
-		if(m_pSortedServerlist)
-			mem_free(m_pSortedServerlist);
-		m_NumSortedServersCapacity = m_NumServers;
-		m_pSortedServerlist = (int *)mem_alloc(m_NumSortedServersCapacity*sizeof(int), 1);
+		Filtered = 1;
 	}
-
-	// filter the servers
-	for(i = 0; i < m_NumServers; i++)
+	else if(g_Config.m_BrFilterPureMap &&
+		!(str_comp(pEntry->m_Info.m_aMap, "dm1") == 0 ||
+		str_comp(pEntry->m_Info.m_aMap, "dm2") == 0 ||
+		str_comp(pEntry->m_Info.m_aMap, "dm6") == 0 ||
+		str_comp(pEntry->m_Info.m_aMap, "dm7") == 0 ||
+		str_comp(pEntry->m_Info.m_aMap, "dm8") == 0 ||
+		str_comp(pEntry->m_Info.m_aMap, "dm9") == 0 ||
+		str_comp(pEntry->m_Info.m_aMap, "ctf1") == 0 ||
+		str_comp(pEntry->m_Info.m_aMap, "ctf2") == 0 ||
+		str_comp(pEntry->m_Info.m_aMap, "ctf3") == 0 ||
+		str_comp(pEntry->m_Info.m_aMap, "ctf4") == 0 ||
+		str_comp(pEntry->m_Info.m_aMap, "ctf5") == 0 ||
+		str_comp(pEntry->m_Info.m_aMap, "ctf6") == 0 ||
+		str_comp(pEntry->m_Info.m_aMap, "ctf7") == 0)
+	)
 	{
-		int Filtered = 0;
-
-		if(g_Config.m_BrFilterEmpty && ((g_Config.m_BrFilterSpectators && m_ppServerlist[i]->m_Info.m_NumPlayers == 0) || m_ppServerlist[i]->m_Info.m_NumClients == 0))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterFull && ((g_Config.m_BrFilterSpectators && m_ppServerlist[i]->m_Info.m_NumPlayers == m_ppServerlist[i]->m_Info.m_MaxPlayers) ||
-				m_ppServerlist[i]->m_Info.m_NumClients == m_ppServerlist[i]->m_Info.m_MaxClients))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterPw && m_ppServerlist[i]->m_Info.m_Flags&SERVER_FLAG_PASSWORD)
-			Filtered = 1;
-		else if(g_Config.m_BrFilterPure &&
-			(str_comp(m_ppServerlist[i]->m_Info.m_aGameType, "DM") != 0 &&
-			str_comp(m_ppServerlist[i]->m_Info.m_aGameType, "TDM") != 0 &&
-			str_comp(m_ppServerlist[i]->m_Info.m_aGameType, "CTF") != 0))
-		{
-			Filtered = 1;
-		}
-		else if(g_Config.m_BrFilterPureMap &&
-			!(str_comp(m_ppServerlist[i]->m_Info.m_aMap, "dm1") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "dm2") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "dm6") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "dm7") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "dm8") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "dm9") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "ctf1") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "ctf2") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "ctf3") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "ctf4") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "ctf5") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "ctf6") == 0 ||
-			str_comp(m_ppServerlist[i]->m_Info.m_aMap, "ctf7") == 0)
-		)
+		Filtered = 1;
+	}
+	else if(g_Config.m_BrFilterPing < pEntry->m_Info.m_Latency)
+		Filtered = 1;
+	else if(g_Config.m_BrFilterCompatversion && str_comp_num(pEntry->m_Info.m_aVersion, m_aNetVersion, 3) != 0)
+		Filtered = 1;
+	else if(g_Config.m_BrFilterServerAddress[0] && !str_find_nocase(pEntry->m_Info.m_aAddress, g_Config.m_BrFilterServerAddress))
+		Filtered = 1;
+	else if(g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && str_comp_nocase(pEntry->m_Info.m_aGameType, g_Config.m_BrFilterGametype))
+		Filtered = 1;
+	else if(!g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && !str_find_nocase(pEntry->m_Info.m_aGameType, g_Config.m_BrFilterGametype))
+		Filtered = 1;
+	else
+	{
+		if(g_Config.m_BrFilterCountry)
 		{
 			Filtered = 1;
-		}
-		else if(g_Config.m_BrFilterPing < m_ppServerlist[i]->m_Info.m_Latency)
-			Filtered = 1;
-		else if(g_Config.m_BrFilterCompatversion && str_comp_num(m_ppServerlist[i]->m_Info.m_aVersion, m_aNetVersion, 3) != 0)
-			Filtered = 1;
-		else if(g_Config.m_BrFilterServerAddress[0] && !str_find_nocase(m_ppServerlist[i]->m_Info.m_aAddress, g_Config.m_BrFilterServerAddress))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && str_comp_nocase(m_ppServerlist[i]->m_Info.m_aGameType, g_Config.m_BrFilterGametype))
-			Filtered = 1;
-		else if(!g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && !str_find_nocase(m_ppServerlist[i]->m_Info.m_aGameType, g_Config.m_BrFilterGametype))
-			Filtered = 1;
-		else
-		{
-			if(g_Config.m_BrFilterCountry)
+			// match against player country
+			for(p = 0; p < pEntry->m_Info.m_NumClients; p++)
 			{
-				Filtered = 1;
-				// match against player country
-				for(p = 0; p < m_ppServerlist[i]->m_Info.m_NumClients; p++)
+				if(pEntry->m_Info.m_aClients[p].m_Country == g_Config.m_BrFilterCountryIndex)
 				{
-					if(m_ppServerlist[i]->m_Info.m_aClients[p].m_Country == g_Config.m_BrFilterCountryIndex)
-					{
-						Filtered = 0;
-						break;
-					}
+					Filtered = 0;
+					break;
 				}
 			}
+		}
 
-			if(!Filtered && g_Config.m_BrFilterString[0] != 0)
-			{
-				int MatchFound = 0;
-
-				m_ppServerlist[i]->m_Info.m_QuickSearchHit = 0;
+		if(!Filtered && g_Config.m_BrFilterString[0] != 0)
+		{
+			int MatchFound = 0;
 
-				// match against server name
-				if(str_find_nocase(m_ppServerlist[i]->m_Info.m_aName, g_Config.m_BrFilterString))
-				{
-					MatchFound = 1;
-					m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
-				}
+			pEntry->m_Info.m_QuickSearchHit = 0;
 
-				// match against players
-				for(p = 0; p < m_ppServerlist[i]->m_Info.m_NumClients; p++)
-				{
-					if(str_find_nocase(m_ppServerlist[i]->m_Info.m_aClients[p].m_aName, g_Config.m_BrFilterString) ||
-						str_find_nocase(m_ppServerlist[i]->m_Info.m_aClients[p].m_aClan, g_Config.m_BrFilterString))
-					{
-						MatchFound = 1;
-						m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_PLAYER;
-						break;
-					}
-				}
+			// match against server name
+			if(str_find_nocase(pEntry->m_Info.m_aName, g_Config.m_BrFilterString))
+			{
+				MatchFound = 1;
+				pEntry->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
+			}
 
-				// match against map
-				if(str_find_nocase(m_ppServerlist[i]->m_Info.m_aMap, g_Config.m_BrFilterString))
+			// match against players
+			for(p = 0; p < pEntry->m_Info.m_NumClients; p++)
+			{
+				if(str_find_nocase(pEntry->m_Info.m_aClients[p].m_aName, g_Config.m_BrFilterString) ||
+					str_find_nocase(pEntry->m_Info.m_aClients[p].m_aClan, g_Config.m_BrFilterString))
 				{
 					MatchFound = 1;
-					m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
+					pEntry->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_PLAYER;
+					break;
 				}
-
-				if(!MatchFound)
-					Filtered = 1;
 			}
-		}
 
-		if(Filtered == 0)
-		{
-			// check for friend
-			m_ppServerlist[i]->m_Info.m_FriendState = IFriends::FRIEND_NO;
-			for(p = 0; p < m_ppServerlist[i]->m_Info.m_NumClients; p++)
+			// match against map
+			if(str_find_nocase(pEntry->m_Info.m_aMap, g_Config.m_BrFilterString))
 			{
-				m_ppServerlist[i]->m_Info.m_aClients[p].m_FriendState = m_pFriends->GetFriendState(m_ppServerlist[i]->m_Info.m_aClients[p].m_aName,
-					m_ppServerlist[i]->m_Info.m_aClients[p].m_aClan);
-				m_ppServerlist[i]->m_Info.m_FriendState = max(m_ppServerlist[i]->m_Info.m_FriendState, m_ppServerlist[i]->m_Info.m_aClients[p].m_FriendState);
+				MatchFound = 1;
+				pEntry->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
 			}
 
-			if(!g_Config.m_BrFilterFriends || m_ppServerlist[i]->m_Info.m_FriendState != IFriends::FRIEND_NO)
-				m_pSortedServerlist[m_NumSortedServers++] = i;
+			if(!MatchFound)
+				Filtered = 1;
+		}
+	}
+
+	if(Filtered == 0)
+	{
+		// check for friend
+		pEntry->m_Info.m_FriendState = IFriends::FRIEND_NO;
+		for(p = 0; p < pEntry->m_Info.m_NumClients; p++)
+		{
+			pEntry->m_Info.m_aClients[p].m_FriendState = m_pFriends->GetFriendState(pEntry->m_Info.m_aClients[p].m_aName,
+				pEntry->m_Info.m_aClients[p].m_aClan);
+			pEntry->m_Info.m_FriendState = max(pEntry->m_Info.m_FriendState, pEntry->m_Info.m_aClients[p].m_FriendState);
 		}
+
+		if(g_Config.m_BrFilterFriends && pEntry->m_Info.m_FriendState == IFriends::FRIEND_NO)
+			Filtered = 1;
+	}
+
+	pEntry->m_Filtered = Filtered;
+}
+
+void CServerBrowser::Filter()
+{
+	m_NumSortedServers = 0;
+
+	// allocate the sorted list
+	if(m_NumSortedServersCapacity < m_NumServers)
+	{
+		if(m_pSortedServerlist)
+			mem_free(m_pSortedServerlist);
+		m_NumSortedServersCapacity = m_NumServers;
+		m_pSortedServerlist = (int *)mem_alloc(m_NumSortedServersCapacity*sizeof(int), 1);
+	}
+
+	// filter the servers
+	for(int i = 0; i < m_NumServers; i++)
+	{
+		Filter(m_ppServerlist[i]);
+		if(!m_ppServerlist[i]->m_Filtered)
+			m_pSortedServerlist[m_NumSortedServers++] = i;
+		else
+			m_ppServerlist[i]->m_Info.m_SortedIndex = -1;
 	}
 }
 
@@ -274,33 +314,84 @@ int CServerBrowser::SortHash() const
 	return i;
 }
 
-void CServerBrowser::Sort()
+CServerBrowser::SortFunc CServerBrowser::CurrentSortFunc() const
 {
-	int i;
-
-	// create filtered list
-	Filter();
-
-	// sort
-	if(g_Config.m_BrSort == IServerBrowser::SORT_NAME)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareName));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_PING)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this, &CServerBrowser::SortComparePing));
+	if(g_Config.m_BrSort == IServerBrowser::SORT_PING)
+		return &CServerBrowser::SortComparePing;
 	else if(g_Config.m_BrSort == IServerBrowser::SORT_MAP)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareMap));
+		return &CServerBrowser::SortCompareMap;
 	else if(g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this,
-					g_Config.m_BrFilterSpectators ? &CServerBrowser::SortCompareNumPlayers : &CServerBrowser::SortCompareNumClients));
+		return g_Config.m_BrFilterSpectators ? &CServerBrowser::SortCompareNumPlayers : &CServerBrowser::SortCompareNumClients;
 	else if(g_Config.m_BrSort == IServerBrowser::SORT_GAMETYPE)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareGametype));
+		return &CServerBrowser::SortCompareGametype;
+	return &CServerBrowser::SortCompareName;
+}
+
+void CServerBrowser::SortList()
+{
+	int i;
+
+	// sort
+	std::sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this, CurrentSortFunc()));
 
 	// set indexes
 	for(i = 0; i < m_NumSortedServers; i++)
 		m_ppServerlist[m_pSortedServerlist[i]]->m_Info.m_SortedIndex = i;
 
+	m_Sorthash = SortHash();
+}
+
+void CServerBrowser::Sort()
+{
+	// create filtered list
+	Filter();
+	SortList();
+
 	str_copy(m_aFilterGametypeString, g_Config.m_BrFilterGametype, sizeof(m_aFilterGametypeString));
 	str_copy(m_aFilterString, g_Config.m_BrFilterString, sizeof(m_aFilterString));
-	m_Sorthash = SortHash();
+}
+
+void CServerBrowser::SortEntry(CServerEntry *pEntry)
+{
+	int Index = pEntry->m_Info.m_ServerIndex;
+	int OldPos = pEntry->m_Info.m_SortedIndex;
+	int NewPos = -1;
+
+	// take it out of the sorted list
+	if(OldPos >= 0)
+	{
+		mem_move(&m_pSortedServerlist[OldPos], &m_pSortedServerlist[OldPos+1], (m_NumSortedServers-OldPos-1)*sizeof(int));
+		m_NumSortedServers--;
+		pEntry->m_Info.m_SortedIndex = -1;
+	}
+
+	// and put it back where it belongs now
+	Filter(pEntry);
+	if(!pEntry->m_Filtered)
+	{
+		if(m_NumSortedServersCapacity < m_NumServers)
+		{
+			int *pNewList = (int *)mem_alloc(m_NumServers*sizeof(int), 1);
+			mem_copy(pNewList, m_pSortedServerlist, m_NumSortedServers*sizeof(int));
+			mem_free(m_pSortedServerlist);
+			m_pSortedServerlist = pNewList;
+			m_NumSortedServersCapacity = m_NumServers;
+		}
+
+		int *pPos = std::lower_bound(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, Index, SortWrap(this, CurrentSortFunc()));
+		NewPos = pPos-m_pSortedServerlist;
+		mem_move(pPos+1, pPos, (m_NumSortedServers-NewPos)*sizeof(int));
+		*pPos = Index;
+		m_NumSortedServers++;
+	}
+
+	// only the entries between the old and the new place moved
+	int First = OldPos < 0 ? NewPos : NewPos < 0 ? OldPos : min(OldPos, NewPos);
+	int Last = OldPos < 0 || NewPos < 0 ? m_NumSortedServers-1 : max(OldPos, NewPos);
+	if(First < 0)
+		return;
+	for(int i = First; i <= Last; i++)
+		m_ppServerlist[m_pSortedServerlist[i]]->m_Info.m_SortedIndex = i;
 }
 
 void CServerBrowser::RemoveRequest(CServerEntry *pEntry)
@@ -325,12 +416,13 @@ void CServerBrowser::RemoveRequest(CServerEntry *pEntry)
 
 CServerBrowser::CServerEntry *CServerBrowser::Find(const NETADDR &Addr)
 {
-	CServerEntry *pEntry = m_aServerlistIp[Addr.ip[0]];
+	if(!m_ServerTableSize)
+		return (CServerEntry*)0;
 
-	for(; pEntry; pEntry = pEntry->m_pNextIp)
+	for(unsigned i = net_addr_hash(&Addr, true)&(m_ServerTableSize-1); m_ppServerTable[i]; i = (i+1)&(m_ServerTableSize-1))
 	{
-		if(net_addr_comp(&pEntry->m_Addr, &Addr) == 0)
-			return pEntry;
+		if(net_addr_comp(&m_ppServerTable[i]->m_Addr, &Addr) == 0)
+			return m_ppServerTable[i];
 	}
 	return (CServerEntry*)0;
 }
@@ -351,9 +443,13 @@ void CServerBrowser::QueueRequest(CServerEntry *pEntry)
 void CServerBrowser::SetInfo(CServerEntry *pEntry, const CServerInfo &Info)
 {
 	int Fav = pEntry->m_Info.m_Favorite;
+	int ServerIndex = pEntry->m_Info.m_ServerIndex;
+	int SortedIndex = pEntry->m_Info.m_SortedIndex;
 	pEntry->m_Info = Info;
 	pEntry->m_Info.m_Favorite = Fav;
 	pEntry->m_Info.m_NetAddr = pEntry->m_Addr;
+	pEntry->m_Info.m_ServerIndex = ServerIndex;
+	pEntry->m_Info.m_SortedIndex = SortedIndex;
 
 	// all these are just for nice compability
 	if(pEntry->m_Info.m_aGameType[0] == '0' && pEntry->m_Info.m_aGameType[1] == 0)
@@ -374,7 +470,6 @@ void CServerBrowser::SetInfo(CServerEntry *pEntry, const CServerInfo &Info)
 
 CServerBrowser::CServerEntry *CServerBrowser::Add(const NETADDR &Addr)
 {
-	int Hash = Addr.ip[0];
 	CServerEntry *pEntry = 0;
 	int i;
 
@@ -387,6 +482,7 @@ CServerBrowser::CServerEntry *CServerBrowser::Add(const NETADDR &Addr)
 	pEntry->m_Info.m_NetAddr = Addr;
 
 	pEntry->m_Info.m_Latency = 999;
+	pEntry->m_Info.m_SortedIndex = -1;
 	net_addr_str(&Addr, pEntry->m_Info.m_aAddress, sizeof(pEntry->m_Info.m_aAddress), true);
 	str_copy(pEntry->m_Info.m_aName, pEntry->m_Info.m_aAddress, sizeof(pEntry->m_Info.m_aName));
 
@@ -397,9 +493,29 @@ CServerBrowser::CServerEntry *CServerBrowser::Add(const NETADDR &Addr)
 			pEntry->m_Info.m_Favorite = 1;
 	}
 
-	// add to the hash list
-	pEntry->m_pNextIp = m_aServerlistIp[Hash];
-	m_aServerlistIp[Hash] = pEntry;
+	// add to the address table, grow it first so it stays at most half full
+	if((m_NumServers+1)*2 > m_ServerTableSize)
+	{
+		int OldSize = m_ServerTableSize;
+		CServerEntry **ppOldTable = m_ppServerTable;
+		m_ServerTableSize = max(OldSize*2, 1024);
+		m_ppServerTable = (CServerEntry **)mem_alloc(m_ServerTableSize*sizeof(CServerEntry*), 1);
+		mem_zero(m_ppServerTable, m_ServerTableSize*sizeof(CServerEntry*));
+		for(int j = 0; j < OldSize; j++)
+		{
+			if(!ppOldTable[j])
+				continue;
+			unsigned Slot = net_addr_hash(&ppOldTable[j]->m_Addr, true)&(m_ServerTableSize-1);
+			while(m_ppServerTable[Slot])
+				Slot = (Slot+1)&(m_ServerTableSize-1);
+			m_ppServerTable[Slot] = ppOldTable[j];
+		}
+		mem_free(ppOldTable);
+	}
+	unsigned Slot = net_addr_hash(&Addr, true)&(m_ServerTableSize-1);
+	while(m_ppServerTable[Slot])
+		Slot = (Slot+1)&(m_ServerTableSize-1);
+	m_ppServerTable[Slot] = pEntry;
 
 	if(m_NumServers == m_NumServerCapacity)
 	{
@@ -459,11 +575,26 @@ void CServerBrowser::Set(const NETADDR &Addr, int Type, int Token, const CServer
 				pEntry->m_Info.m_Latency = min(static_cast<int>((time_get()-m_BroadcastTime)*1000/time_freq()), 999);
 			else
 				pEntry->m_Info.m_Latency = min(static_cast<int>((time_get()-pEntry->m_RequestTime)*1000/time_freq()), 999);
+
+			// a reply to one of our requests, speed up again
+			if(pEntry->m_RequestTime && (pEntry->m_pPrevReq || pEntry->m_pNextReq || m_pFirstReqServer == pEntry))
+			{
+				int64 Rtt = time_get()-pEntry->m_RequestTime;
+				m_ProbeRtt = m_ProbeRtt ? (m_ProbeRtt*7+Rtt)/8 : Rtt;
+				m_ProbeRate = min(m_ProbeRate+g_Config.m_BrProbeRate/50.0f, (float)g_Config.m_BrProbeRate);
+				m_NumProbeReplies++;
+			}
 			RemoveRequest(pEntry);
 		}
 	}
 
-	Sort();
+	// only move the entry that changed, unless the filters changed since the last full sort
+	if(!pEntry)
+		return;
+	if(m_Sorthash != SortHash())
+		Sort();
+	else
+		SortEntry(pEntry);
 }
 
 void CServerBrowser::Refresh(int Type)
@@ -472,11 +603,22 @@ void CServerBrowser::Refresh(int Type)
 	m_ServerlistHeap.Reset();
 	m_NumServers = 0;
 	m_NumSortedServers = 0;
-	mem_zero(m_aServerlistIp, sizeof(m_aServerlistIp));
+	if(m_ppServerTable)
+		mem_zero(m_ppServerTable, m_ServerTableSize*sizeof(CServerEntry*));
 	m_pFirstReqServer = 0;
 	m_pLastReqServer = 0;
 	m_NumRequests = 0;
 
+	m_ProbeRate = (float)g_Config.m_BrProbeRate;
+	m_ProbeTokens = 1.0f;
+	m_LastProbeTime = time_get();
+	m_ProbeStartTime = 0;
+	m_LastProbeBackoff = 0;
+	m_NumProbesSent = 0;
+	m_NumProbeReplies = 0;
+	m_NumProbeRetries = 0;
+	m_NumProbeTimeouts = 0;
+
 	// next token
 	m_CurrentToken = (m_CurrentToken+1)&0xff;
 
@@ -554,42 +696,247 @@ void CServerBrowser::Request(const NETADDR &Addr) const
 }
 
 
-void CServerBrowser::Update(bool ForceResort)
+void CServerBrowser::RequestList(const NETADDR &Addr) const
 {
-	int64 Timeout = time_freq();
-	int64 Now = time_get();
-	int Count;
-	CServerEntry *pEntry, *pNext;
+	CNetChunk Packet;
+	mem_zero(&Packet, sizeof(Packet));
+	Packet.m_ClientID = -1;
+	Packet.m_Address = Addr;
+	Packet.m_Flags = NETSENDFLAG_CONNLESS;
+	Packet.m_DataSize = sizeof(SERVERBROWSE_GETLIST);
+	Packet.m_pData = SERVERBROWSE_GETLIST;
+	m_pNetClient->Send(&Packet);
+}
 
-	// do server list requests
-	if(m_NeedRefresh && !m_pMasterServer->IsRefreshing())
+void CServerBrowser::RequestMasterList(int Index)
+{
+	CMasterList *pList = &m_aMasterLists[Index];
+	NETADDR Addr = m_pMasterServer->GetAddr(Index);
+
+	// a different master now, forget what the old one sent
+	if(net_addr_comp(&pList->m_Addr, &Addr) != 0)
 	{
-		NETADDR Addr;
-		CNetChunk Packet;
-		int i;
+		pList->m_Addr = Addr;
+		pList->m_Version = 0;
+		pList->m_NumServers = 0;
+		pList->m_DeltaSupported = false;
+	}
 
-		m_NeedRefresh = 0;
+	if(!g_Config.m_BrMasterDelta)
+	{
+		RequestList(Addr);
+		return;
+	}
 
-		mem_zero(&Packet, sizeof(Packet));
-		Packet.m_ClientID = -1;
-		Packet.m_Flags = NETSENDFLAG_CONNLESS;
-		Packet.m_DataSize = sizeof(SERVERBROWSE_GETLIST);
-		Packet.m_pData = SERVERBROWSE_GETLIST;
+	unsigned char aBuffer[sizeof(SERVERBROWSE_GETLIST_DELTA)+4];
+	mem_copy(aBuffer, SERVERBROWSE_GETLIST_DELTA, sizeof(SERVERBROWSE_GETLIST_DELTA));
+	aBuffer[sizeof(SERVERBROWSE_GETLIST_DELTA)] = (pList->m_Version>>24)&0xff;
+	aBuffer[sizeof(SERVERBROWSE_GETLIST_DELTA)+1] = (pList->m_Version>>16)&0xff;
+	aBuffer[sizeof(SERVERBROWSE_GETLIST_DELTA)+2] = (pList->m_Version>>8)&0xff;
+	aBuffer[sizeof(SERVERBROWSE_GETLIST_DELTA)+3] = pList->m_Version&0xff;
+
+	CNetChunk Packet;
+	mem_zero(&Packet, sizeof(Packet));
+	Packet.m_ClientID = -1;
+	Packet.m_Address = Addr;
+	Packet.m_Flags = NETSENDFLAG_CONNLESS;
+	Packet.m_DataSize = sizeof(aBuffer);
+	Packet.m_pData = aBuffer;
+	m_pNetClient->Send(&Packet);
+
+	pList->m_RequestTime = time_get();
+	pList->m_NumAnswerPackets = 0;
+	pList->m_NumAnswerReceived = 0;
+
+	// masters that didn't answer one yet might not know delta requests, don't wait for them to find out
+	pList->m_PlainRequested = !pList->m_DeltaSupported;
+	if(pList->m_PlainRequested)
+		RequestList(Addr);
+}
 
-		for(i = 0; i < IMasterServer::MAX_MASTERSERVERS; i++)
+void CServerBrowser::SetListDelta(const NETADDR &Addr, const void *pData, int DataSize)
+{
+	// only from a master we asked
+	CMasterList *pList = 0;
+	for(int i = 0; i < IMasterServer::MAX_MASTERSERVERS; i++)
+	{
+		if(m_aMasterLists[i].m_RequestTime && net_addr_comp(&m_aMasterLists[i].m_Addr, &Addr) == 0)
 		{
-			if(!m_pMasterServer->IsValid(i))
-				continue;
+			pList = &m_aMasterLists[i];
+			break;
+		}
+	}
+	if(!pList || DataSize < (int)(sizeof(SERVERBROWSE_LIST_DELTA)+sizeof(CMastersrvListDelta)))
+		return;
 
-			Addr = m_pMasterServer->GetAddr(i);
-			Packet.m_Address = Addr;
-			m_pNetClient->Send(&Packet);
+	const CMastersrvListDelta *pInfo = (const CMastersrvListDelta *)((const char *)pData+sizeof(SERVERBROWSE_LIST_DELTA));
+	const CMastersrvDeltaAddr *pAddrs = (const CMastersrvDeltaAddr *)(pInfo+1);
+	unsigned BaseVersion = (pInfo->m_aBaseVersion[0]<<24) | (pInfo->m_aBaseVersion[1]<<16) | (pInfo->m_aBaseVersion[2]<<8) | pInfo->m_aBaseVersion[3];
+	unsigned Version = (pInfo->m_aVersion[0]<<24) | (pInfo->m_aVersion[1]<<16) | (pInfo->m_aVersion[2]<<8) | pInfo->m_aVersion[3];
+	int NumPackets = (pInfo->m_aNumPackets[0]<<8) | pInfo->m_aNumPackets[1];
+	int Packet = (pInfo->m_aPacket[0]<<8) | pInfo->m_aPacket[1];
+	int Num = (DataSize-sizeof(SERVERBROWSE_LIST_DELTA)-sizeof(CMastersrvListDelta))/sizeof(CMastersrvDeltaAddr);
+	if(Packet >= NumPackets || NumPackets > MAX_DELTA_PACKETS || Num > MAX_SERVERS_PER_DELTA_PACKET)
+		return;
+
+	pList->m_DeltaSupported = true;
+
+	// changes to a list we don't have
+	if(BaseVersion && BaseVersion != pList->m_Version)
+		return;
+
+	// first packet of an answer, make room for all of it
+	if(NumPackets != pList->m_NumAnswerPackets || BaseVersion != pList->m_AnswerBaseVersion || Version != pList->m_AnswerVersion)
+	{
+		mem_free(pList->m_pAnswerSizes);
+		mem_free(pList->m_pAnswer);
+		pList->m_pAnswerSizes = (int *)mem_alloc(NumPackets*sizeof(int), 1);
+		pList->m_pAnswer = (CMastersrvDeltaAddr *)mem_alloc(NumPackets*MAX_SERVERS_PER_DELTA_PACKET*sizeof(CMastersrvDeltaAddr), 1);
+		for(int i = 0; i < NumPackets; i++)
+			pList->m_pAnswerSizes[i] = -1;
+		pList->m_AnswerBaseVersion = BaseVersion;
+		pList->m_AnswerVersion = Version;
+		pList->m_NumAnswerPackets = NumPackets;
+		pList->m_NumAnswerReceived = 0;
+	}
+
+	if(pList->m_pAnswerSizes[Packet] != -1)
+		return;
+	mem_copy(&pList->m_pAnswer[Packet*MAX_SERVERS_PER_DELTA_PACKET], pAddrs, Num*sizeof(CMastersrvDeltaAddr));
+	pList->m_pAnswerSizes[Packet] = Num;
+	if(++pList->m_NumAnswerReceived == NumPackets)
+		ApplyListDelta(pList);
+}
+
+static void ReadMasterAddr(const CMastersrvAddr *pAddr, NETADDR *pOut)
+{
+	static const unsigned char IPV4Mapping[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF };
+
+	mem_zero(pOut, sizeof(*pOut));
+	if(!mem_comp(IPV4Mapping, pAddr->m_aIp, sizeof(IPV4Mapping)))
+	{
+		pOut->type = NETTYPE_IPV4;
+		pOut->ip[0] = pAddr->m_aIp[12];
+		pOut->ip[1] = pAddr->m_aIp[13];
+		pOut->ip[2] = pAddr->m_aIp[14];
+		pOut->ip[3] = pAddr->m_aIp[15];
+	}
+	else
+	{
+		pOut->type = NETTYPE_IPV6;
+		mem_copy(pOut->ip, pAddr->m_aIp, sizeof(pOut->ip));
+	}
+	pOut->port = (pAddr->m_aPort[0]<<8) | pAddr->m_aPort[1];
+}
+
+struct CListChange
+{
+	NETADDR m_Addr;
+	bool m_Removed;
+
+	bool operator<(const CListChange &Other) const { return net_addr_comp(&m_Addr, &Other.m_Addr) < 0; }
+};
+
+static bool ListChangeFind(const CListChange *pChanges, int Num, const NETADDR &Addr)
+{
+	CListChange Key;
+	Key.m_Addr = Addr;
+	return std::binary_search(pChanges, pChanges+Num, Key);
+}
+
+void CServerBrowser::ApplyListDelta(CMasterList *pList)
+{
+	int NumChanges = 0;
+	for(int i = 0; i < pList->m_NumAnswerPackets; i++)
+		NumChanges += pList->m_pAnswerSizes[i];
+
+	// only the last change to every server counts
+	CListChange *pChanges = (CListChange *)mem_alloc(max(NumChanges, 1)*sizeof(CListChange), 1);
+	int NumUnique = 0;
+	for(int i = 0; i < pList->m_NumAnswerPackets; i++)
+	{
+		for(int j = 0; j < pList->m_pAnswerSizes[i]; j++)
+		{
+			const CMastersrvDeltaAddr *pAddr = &pList->m_pAnswer[i*MAX_SERVERS_PER_DELTA_PACKET+j];
+			ReadMasterAddr(&pAddr->m_Addr, &pChanges[NumUnique].m_Addr);
+			pChanges[NumUnique].m_Removed = pAddr->m_Removed != 0;
+			NumUnique++;
 		}
+	}
+	std::stable_sort(pChanges, pChanges+NumUnique);
+	int NumLast = 0;
+	for(int i = 0; i < NumUnique; i++)
+	{
+		if(i+1 < NumUnique && net_addr_comp(&pChanges[i].m_Addr, &pChanges[i+1].m_Addr) == 0)
+			continue;
+		pChanges[NumLast++] = pChanges[i];
+	}
 
-		if(g_Config.m_Debug)
-			m_pConsole->Print(IConsole::OUTPUT_LEVEL_DEBUG, "client_srvbrowse", "requesting server list");
+	// drop every changed server from the old list, the ones still there get added again below
+	int NumServers = 0;
+	if(pList->m_AnswerBaseVersion)
+	{
+		for(int i = 0; i < pList->m_NumServers; i++)
+		{
+			if(!ListChangeFind(pChanges, NumLast, pList->m_pServers[i]))
+				pList->m_pServers[NumServers++] = pList->m_pServers[i];
+		}
 	}
 
+	int NumAdded = 0;
+	for(int i = 0; i < NumLast; i++)
+		NumAdded += !pChanges[i].m_Removed;
+	if(NumServers+NumAdded > pList->m_ServerCapacity)
+	{
+		pList->m_ServerCapacity = max(pList->m_ServerCapacity*2, NumServers+NumAdded);
+		NETADDR *pNewServers = (NETADDR *)mem_alloc(pList->m_ServerCapacity*sizeof(NETADDR), 1);
+		if(NumServers)
+			mem_copy(pNewServers, pList->m_pServers, NumServers*sizeof(NETADDR));
+		mem_free(pList->m_pServers);
+		pList->m_pServers = pNewServers;
+	}
+	for(int i = 0; i < NumLast; i++)
+	{
+		if(!pChanges[i].m_Removed)
+			pList->m_pServers[NumServers++] = pChanges[i].m_Addr;
+	}
+	pList->m_NumServers = NumServers;
+	pList->m_Version = pList->m_AnswerVersion;
+	mem_free(pChanges);
+
+	pList->m_RequestTime = 0;
+	mem_free(pList->m_pAnswerSizes);
+	mem_free(pList->m_pAnswer);
+	pList->m_pAnswerSizes = 0;
+	pList->m_pAnswer = 0;
+	pList->m_NumAnswerPackets = 0;
+
+	for(int i = 0; i < pList->m_NumServers; i++)
+		Set(pList->m_pServers[i], IServerBrowser::SET_MASTER_ADD, -1, 0);
+
+	char aAddrStr[NETADDR_MAXSTRSIZE];
+	net_addr_str(&pList->m_Addr, aAddrStr, sizeof(aAddrStr), true);
+	char aBuf[256];
+	if(pList->m_AnswerBaseVersion)
+		str_format(aBuf, sizeof(aBuf), "%d servers from %s, %d changed since the last refresh", pList->m_NumServers, aAddrStr, NumChanges);
+	else
+		str_format(aBuf, sizeof(aBuf), "%d servers from %s", pList->m_NumServers, aAddrStr);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "client_srvbrowse", aBuf);
+}
+
+int64 CServerBrowser::ProbeTimeout(int NumProbes) const
+{
+	// a few round trips, but never less than half a second, and longer with every retry
+	int64 Timeout = m_ProbeRtt ? clamp(m_ProbeRtt*3, time_freq()/2, time_freq()*2) : time_freq();
+	return Timeout*NumProbes;
+}
+
+void CServerBrowser::UpdateProbes()
+{
+	int64 Now = time_get();
+	CServerEntry *pEntry, *pNext;
+	int Count;
+
 	// do timeouts
 	pEntry = m_pFirstReqServer;
 	while(1)
@@ -599,16 +946,39 @@ void CServerBrowser::Update(bool ForceResort)
 
 		pNext = pEntry->m_pNextReq;
 
-		if(pEntry->m_RequestTime && pEntry->m_RequestTime+Timeout < Now)
+		if(pEntry->m_RequestTime && pEntry->m_RequestTime+ProbeTimeout(pEntry->m_NumProbes) < Now)
 		{
-			// timeout
-			RemoveRequest(pEntry);
+			if(pEntry->m_NumProbes <= g_Config.m_BrProbeRetries)
+			{
+				// retry at the end of the queue, lost requests mostly mean we are sending too fast
+				RemoveRequest(pEntry);
+				pEntry->m_RequestTime = 0;
+				QueueRequest(pEntry);
+				m_NumProbeRetries++;
+			}
+			else
+			{
+				// timeout
+				RemoveRequest(pEntry);
+				m_NumProbeTimeouts++;
+			}
+
+			// back off once per timeout period, a list full of dead servers shouldn't stall the rest
+			if(m_LastProbeBackoff+ProbeTimeout(1) < Now)
+			{
+				m_ProbeRate = max(m_ProbeRate*0.75f, (float)MIN_PROBE_RATE);
+				m_LastProbeBackoff = Now;
+			}
 		}
 
 		pEntry = pNext;
 	}
 
-	// do timeouts
+	// refill the token bucket, it holds at most 50ms worth of requests
+	m_ProbeTokens = min(m_ProbeTokens+(Now-m_LastProbeTime)*m_ProbeRate/time_freq(), max(m_ProbeRate/20.0f, 1.0f));
+	m_LastProbeTime = Now;
+
+	// send new requests
 	pEntry = m_pFirstReqServer;
 	Count = 0;
 	while(1)
@@ -616,20 +986,76 @@ void CServerBrowser::Update(bool ForceResort)
 		if(!pEntry) // no more entries
 			break;
 
-		// no more then 10 concurrent requests
+		// no more then br_max_requests concurrent requests
 		if(Count == g_Config.m_BrMaxRequests)
 			break;
 
 		if(pEntry->m_RequestTime == 0)
+		{
+			if(m_ProbeTokens < 1.0f)
+				break;
+			m_ProbeTokens -= 1.0f;
+
+			if(!m_ProbeStartTime)
+				m_ProbeStartTime = Now;
 			RequestImpl(pEntry->m_Addr, pEntry);
+			pEntry->m_NumProbes++;
+			m_NumProbesSent++;
+		}
 
 		Count++;
 		pEntry = pEntry->m_pNextReq;
 	}
 
+	// report how the refresh went once every server answered or gave up
+	if(m_ProbeStartTime && !m_pFirstReqServer)
+	{
+		float Seconds = (Now-m_ProbeStartTime)/(float)time_freq();
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "probed %d servers in %.2fs (%.0f requests/s), %d replies, %d retries, %d timeouts, rtt %dms",
+			m_NumProbeReplies+m_NumProbeTimeouts, Seconds, m_NumProbesSent/max(Seconds, 0.001f), m_NumProbeReplies, m_NumProbeRetries,
+			m_NumProbeTimeouts, (int)(m_ProbeRtt*1000/time_freq()));
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "client_srvbrowse", aBuf);
+		m_ProbeStartTime = 0;
+	}
+}
+
+void CServerBrowser::Update(bool ForceResort)
+{
+	// do server list requests
+	if(m_NeedRefresh && !m_pMasterServer->IsRefreshing())
+	{
+		m_NeedRefresh = 0;
+
+		for(int i = 0; i < IMasterServer::MAX_MASTERSERVERS; i++)
+		{
+			if(m_pMasterServer->IsValid(i))
+				RequestMasterList(i);
+		}
+
+		if(g_Config.m_Debug)
+			m_pConsole->Print(IConsole::OUTPUT_LEVEL_DEBUG, "client_srvbrowse", "requesting server list");
+	}
+
+	// fall back to the plain list when a master doesn't answer the delta request in time, the next refresh tries delta again
+	for(int i = 0; i < IMasterServer::MAX_MASTERSERVERS; i++)
+	{
+		CMasterList *pList = &m_aMasterLists[i];
+		if(!pList->m_RequestTime || pList->m_RequestTime+time_freq()*2 > time_get())
+			continue;
+
+		pList->m_RequestTime = 0;
+		if(!pList->m_PlainRequested)
+			RequestList(pList->m_Addr);
+	}
+
+	UpdateProbes();
+
 	// check if we need to resort
-	if(m_Sorthash != SortHash() || ForceResort)
+	if(ForceResort || (m_Sorthash^SortHash())&~SORTHASH_SORTBITS)
 		Sort();
+	else if(m_Sorthash != SortHash())
+		SortList();
 }
 
 
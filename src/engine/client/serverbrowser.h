@@ -3,6 +3,7 @@
 #ifndef ENGINE_CLIENT_SERVERBROWSER_H
 #define ENGINE_CLIENT_SERVERBROWSER_H
 
+#include <engine/masterserver.h>
 #include <engine/serverbrowser.h>
 
 class CServerBrowser : public IServerBrowser
@@ -13,11 +14,11 @@ public:
 	public:
 		NETADDR m_Addr;
 		int64 m_RequestTime;
+		int m_NumProbes; // info requests sent to it this refresh
 		int m_GotInfo;
+		int m_Filtered; // result of the filters for the current info, kept until the info or the filters change
 		CServerInfo m_Info;
 
-		CServerEntry *m_pNextIp; // ip hashed list
-
 		CServerEntry *m_pPrevReq; // request list
 		CServerEntry *m_pNextReq;
 	};
@@ -48,6 +49,7 @@ public:
 	void Update(bool ForceResort);
 	void Set(const NETADDR &Addr, int Type, int Token, const CServerInfo *pInfo);
 	void Request(const NETADDR &Addr) const;
+	void SetListDelta(const NETADDR &Addr, const void *pData, int DataSize);
 
 	void SetBaseInfo(class CNetClient *pClient, const char *pNetVersion);
 
@@ -65,14 +67,49 @@ private:
 	NETADDR m_aFavoriteServers[MAX_FAVORITES];
 	int m_NumFavoriteServers;
 
-	CServerEntry *m_aServerlistIp[256]; // ip hash list
+	CServerEntry **m_ppServerTable; // open addressed, always at most half full
+	int m_ServerTableSize;
 
 	CServerEntry *m_pFirstReqServer; // request list
 	CServerEntry *m_pLastReqServer;
 	int m_NumRequests;
 
+	// info request pacing
+	float m_ProbeTokens;
+	float m_ProbeRate; // requests per second, backs off when requests time out
+	int64 m_LastProbeTime;
+	int64 m_ProbeRtt; // smoothed round trip time, 0 until the first reply
+	int64 m_ProbeStartTime;
+	int64 m_LastProbeBackoff;
+	int m_NumProbesSent;
+	int m_NumProbeReplies;
+	int m_NumProbeRetries;
+	int m_NumProbeTimeouts;
+
 	int m_NeedRefresh;
 
+	// the last list every master sent, refreshing only asks for what changed since
+	struct CMasterList
+	{
+		NETADDR m_Addr;
+		unsigned m_Version; // 0 if we have no list
+		NETADDR *m_pServers;
+		int m_NumServers;
+		int m_ServerCapacity;
+		bool m_DeltaSupported; // answered a delta request before, until then the plain list gets asked for as well
+		bool m_PlainRequested;
+
+		// the answer that is coming in
+		int64 m_RequestTime; // 0 if none is expected
+		unsigned m_AnswerBaseVersion;
+		unsigned m_AnswerVersion;
+		int m_NumAnswerPackets;
+		int m_NumAnswerReceived;
+		int *m_pAnswerSizes; // -1 for the packets that didn't arrive yet
+		struct CMastersrvDeltaAddr *m_pAnswer;
+	};
+	CMasterList m_aMasterLists[IMasterServer::MAX_MASTERSERVERS];
+
 	int m_NumSortedServers;
 	int m_NumSortedServersCapacity;
 	int m_NumServers;
@@ -89,6 +126,8 @@ private:
 	int64 m_BroadcastTime;
 
 	// sorting criterions
+	typedef bool (CServerBrowser::*SortFunc)(int, int) const;
+	SortFunc CurrentSortFunc() const;
 	bool SortCompareName(int Index1, int Index2) const;
 	bool SortCompareMap(int Index1, int Index2) const;
 	bool SortComparePing(int Index1, int Index2) const;
@@ -97,8 +136,11 @@ private:
 	bool SortCompareNumClients(int Index1, int Index2) const;
 
 	//
+	void Filter(CServerEntry *pEntry);
 	void Filter();
+	void SortList();
 	void Sort();
+	void SortEntry(CServerEntry *pEntry);
 	int SortHash() const;
 
 	CServerEntry *Find(const NETADDR &Addr);
@@ -106,8 +148,13 @@ private:
 
 	void RemoveRequest(CServerEntry *pEntry);
 	void QueueRequest(CServerEntry *pEntry);
+	int64 ProbeTimeout(int NumProbes) const;
+	void UpdateProbes();
 
 	void RequestImpl(const NETADDR &Addr, CServerEntry *pEntry) const;
+	void RequestList(const NETADDR &Addr) const;
+	void RequestMasterList(int Index);
+	void ApplyListDelta(CMasterList *pList);
 
 	void SetInfo(CServerEntry *pEntry, const CServerInfo &Info);
 
@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <base/math.h>
 #include <base/system.h>
+#include <base/tl/threading.h>
 
 #include <engine/graphics.h>
 #include <engine/storage.h>
@@ -9,6 +10,7 @@
 #include <engine/shared/config.h>
 
 #include "SDL.h"
+#include <zlib.h>
 
 #include "sound.h"
 
@@ -17,11 +19,17 @@ extern "C" { // wavpack
 }
 #include <math.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define CONF_SOUND_SSE2 1
+	#include <emmintrin.h>
+#endif
+
 enum
 {
 	NUM_SAMPLES = 512,
 	NUM_VOICES = 64,
 	NUM_CHANNELS = 16,
+	NUM_COMMANDS = 256,
 };
 
 struct CSample
@@ -35,6 +43,26 @@ struct CSample
 	int m_PausedAt;
 };
 
+// header of the files in soundcache/, followed by the sample data
+struct CSampleCacheHeader
+{
+	char m_aMagic[4];
+	int m_Version;
+	unsigned m_Crc;
+	int m_FileSize;
+	int m_Rate;
+	int m_Channels;
+	int m_NumFrames;
+};
+
+static const char gs_aSampleCacheMagic[4] = {'T', 'W', 'S', 'C'};
+
+enum
+{
+	SAMPLECACHE_VERSION = 1,
+	DECODE_CHUNK_FRAMES = 4096,
+};
+
 struct CChannel
 {
 	int m_Vol;
@@ -51,11 +79,35 @@ struct CVoice
 	int m_X, m_Y;
 } ;
 
+struct CSoundCommand
+{
+	enum
+	{
+		CMD_PLAY=0,
+		CMD_STOP,
+		CMD_STOPALL,
+	};
+
+	int m_Cmd;
+	int m_VoiceID;
+	int m_SampleID;
+	int m_ChannelID;
+	int m_Flags;
+	int m_X, m_Y;
+};
+
 static CSample m_aSamples[NUM_SAMPLES] = { {0} };
-static CVoice m_aVoices[NUM_VOICES] = { {0} };
+static CVoice m_aVoices[NUM_VOICES] = { {0} };	// only touched by the mixer
 static CChannel m_aChannels[NUM_CHANNELS] = { {255, 0} };
 
-static LOCK m_SoundLock = 0;
+// set by the game thread when it hands out a voice, cleared by the mixer when the voice is done
+static volatile int m_aVoiceBusy[NUM_VOICES] = {0};
+
+// commands from the game thread to the mixer. there is exactly one writer and one reader,
+// so the ring needs no lock and the audio callback never waits for the game thread
+static CSoundCommand m_aCommands[NUM_COMMANDS];
+static volatile unsigned m_CommandWrite = 0;
+static volatile unsigned m_CommandRead = 0;
 
 static int m_CenterX = 0;
 static int m_CenterY = 0;
@@ -64,6 +116,7 @@ static int m_MixingRate = 48000;
 static volatile int m_SoundVolume = 100;
 
 static int m_NextVoice = 0;
+static LOCK m_LoadLock = 0;	// taken while a sample gets decoded, LoadWV can be called from several threads
 static int *m_pMixBuffer = 0;	// buffer only used by the thread callback function
 static unsigned m_MaxFrames = 0;
 
@@ -84,109 +137,216 @@ static int IntAbs(int i)
 	return i;
 }
 
-static void Mix(short *pFinalOut, unsigned Frames)
+static bool PushCommand(const CSoundCommand *pCmd)
 {
-	int MasterVol;
-	mem_zero(m_pMixBuffer, m_MaxFrames*2*sizeof(int));
-	Frames = min(Frames, m_MaxFrames);
+	if(m_CommandWrite-m_CommandRead == NUM_COMMANDS)
+		return false;
 
-	// aquire lock while we are mixing
-	lock_wait(m_SoundLock);
+	m_aCommands[m_CommandWrite%NUM_COMMANDS] = *pCmd;
+	sync_barrier(); // the command must be complete before the mixer can see it
+	m_CommandWrite = m_CommandWrite+1;
+	return true;
+}
 
-	MasterVol = m_SoundVolume;
+static void StopVoice(CVoice *v)
+{
+	if(v->m_Flags&ISound::FLAG_LOOP)
+		v->m_pSample->m_PausedAt = v->m_Tick;
+	else
+		v->m_pSample->m_PausedAt = 0;
+	v->m_pSample = 0;
+}
 
-	for(unsigned i = 0; i < NUM_VOICES; i++)
+static void ProcessCommands()
+{
+	unsigned Write = m_CommandWrite;
+	sync_barrier();
+
+	while(m_CommandRead != Write)
 	{
-		if(m_aVoices[i].m_pSample)
+		const CSoundCommand *pCmd = &m_aCommands[m_CommandRead%NUM_COMMANDS];
+		if(pCmd->m_Cmd == CSoundCommand::CMD_PLAY)
+		{
+			CVoice *v = &m_aVoices[pCmd->m_VoiceID];
+			v->m_pSample = &m_aSamples[pCmd->m_SampleID];
+			v->m_pChannel = &m_aChannels[pCmd->m_ChannelID];
+			if(pCmd->m_Flags&ISound::FLAG_LOOP)
+				v->m_Tick = v->m_pSample->m_PausedAt;
+			else
+				v->m_Tick = 0;
+			v->m_Vol = 255;
+			v->m_Flags = pCmd->m_Flags;
+			v->m_X = pCmd->m_X;
+			v->m_Y = pCmd->m_Y;
+		}
+		else
 		{
-			// mix voice
-			CVoice *v = &m_aVoices[i];
-			int *pOut = m_pMixBuffer;
+			CSample *pSample = pCmd->m_Cmd == CSoundCommand::CMD_STOP ? &m_aSamples[pCmd->m_SampleID] : 0;
+			for(int i = 0; i < NUM_VOICES; i++)
+			{
+				if(m_aVoices[i].m_pSample && (!pSample || m_aVoices[i].m_pSample == pSample))
+				{
+					StopVoice(&m_aVoices[i]);
+					m_aVoiceBusy[i] = 0;
+				}
+			}
+		}
+
+		sync_barrier(); // done with the slot before it is handed back
+		m_CommandRead = m_CommandRead+1;
+	}
+}
 
-			int Step = v->m_pSample->m_Channels; // setup input sources
-			short *pInL = &v->m_pSample->m_pData[v->m_Tick*Step];
-			short *pInR = &v->m_pSample->m_pData[v->m_Tick*Step+1];
+#if defined(CONF_SOUND_SSE2)
+// adds four stereo frames times the volumes to the mix buffer
+static inline void MixFrames4(__m128i In, __m128i Vol, int *pOut)
+{
+	// the products need 32 bits, put them together from the low and high halves
+	__m128i Lo = _mm_mullo_epi16(In, Vol);
+	__m128i Hi = _mm_mulhi_epi16(In, Vol);
+	__m128i *pDst = (__m128i *)pOut;
+	_mm_storeu_si128(pDst, _mm_add_epi32(_mm_loadu_si128(pDst), _mm_unpacklo_epi16(Lo, Hi)));
+	_mm_storeu_si128(pDst+1, _mm_add_epi32(_mm_loadu_si128(pDst+1), _mm_unpackhi_epi16(Lo, Hi)));
+}
+#endif
 
-			unsigned End = v->m_pSample->m_NumFrames-v->m_Tick;
+// mixes a voice into the buffer, returns false when it has played to the end
+static bool MixVoice(CVoice *v, int *pOut, unsigned Frames)
+{
+	int Step = v->m_pSample->m_Channels; // setup input sources
+	const short *pIn = &v->m_pSample->m_pData[v->m_Tick*Step];
 
-			int Rvol = v->m_pChannel->m_Vol;
-			int Lvol = v->m_pChannel->m_Vol;
+	unsigned End = v->m_pSample->m_NumFrames-v->m_Tick;
 
-			// make sure that we don't go outside the sound data
-			if(Frames < End)
-				End = Frames;
+	int Rvol = v->m_pChannel->m_Vol;
+	int Lvol = v->m_pChannel->m_Vol;
 
-			// check if we have a mono sound
-			if(v->m_pSample->m_Channels == 1)
-				pInR = pInL;
+	// make sure that we don't go outside the sound data
+	if(Frames < End)
+		End = Frames;
 
-			// volume calculation
-			if(v->m_Flags&ISound::FLAG_POS && v->m_pChannel->m_Pan)
+	// volume calculation
+	if(v->m_Flags&ISound::FLAG_POS && v->m_pChannel->m_Pan)
+	{
+		// TODO: we should respect the channel panning value
+		const int Range = 1500; // magic value, remove
+		int dx = v->m_X - m_CenterX;
+		int dy = v->m_Y - m_CenterY;
+		int Dist = (int)sqrtf((float)dx*dx+dy*dy); // float here. nasty
+		int p = IntAbs(dx);
+		if(Dist >= 0 && Dist < Range)
+		{
+			// panning
+			if(dx > 0)
+				Lvol = ((Range-p)*Lvol)/Range;
+			else
+				Rvol = ((Range-p)*Rvol)/Range;
+
+			// falloff
+			Lvol = (Lvol*(Range-Dist))/Range;
+			Rvol = (Rvol*(Range-Dist))/Range;
+		}
+		else
+		{
+			Lvol = 0;
+			Rvol = 0;
+		}
+	}
+
+	// process all frames, four at a time when we can
+	unsigned s = 0;
+	if(Lvol || Rvol)
+	{
+#if defined(CONF_SOUND_SSE2)
+		__m128i Vol = _mm_setr_epi16(Lvol, Rvol, Lvol, Rvol, Lvol, Rvol, Lvol, Rvol);
+		if(Step == 2)
+		{
+			for(; s+4 <= End; s += 4)
+				MixFrames4(_mm_loadu_si128((const __m128i *)(pIn+s*2)), Vol, pOut+s*2);
+		}
+		else
+		{
+			for(; s+4 <= End; s += 4)
 			{
-				// TODO: we should respect the channel panning value
-				const int Range = 1500; // magic value, remove
-				int dx = v->m_X - m_CenterX;
-				int dy = v->m_Y - m_CenterY;
-				int Dist = (int)sqrtf((float)dx*dx+dy*dy); // float here. nasty
-				int p = IntAbs(dx);
-				if(Dist >= 0 && Dist < Range)
-				{
-					// panning
-					if(dx > 0)
-						Lvol = ((Range-p)*Lvol)/Range;
-					else
-						Rvol = ((Range-p)*Rvol)/Range;
-
-					// falloff
-					Lvol = (Lvol*(Range-Dist))/Range;
-					Rvol = (Rvol*(Range-Dist))/Range;
-				}
-				else
-				{
-					Lvol = 0;
-					Rvol = 0;
-				}
+				// mono, feed every sample to both sides
+				__m128i In = _mm_loadl_epi64((const __m128i *)(pIn+s));
+				MixFrames4(_mm_unpacklo_epi16(In, In), Vol, pOut+s*2);
 			}
+		}
+#endif
 
-			// process all frames
-			for(unsigned s = 0; s < End; s++)
+		if(Step == 2)
+		{
+			for(; s < End; s++)
 			{
-				*pOut++ += (*pInL)*Lvol;
-				*pOut++ += (*pInR)*Rvol;
-				pInL += Step;
-				pInR += Step;
-				v->m_Tick++;
+				pOut[s*2] += pIn[s*2]*Lvol;
+				pOut[s*2+1] += pIn[s*2+1]*Rvol;
 			}
-
-			// free voice if not used any more
-			if(v->m_Tick == v->m_pSample->m_NumFrames)
+		}
+		else
+		{
+			for(; s < End; s++)
 			{
-				if(v->m_Flags&ISound::FLAG_LOOP)
-					v->m_Tick = 0;
-				else
-					v->m_pSample = 0;
+				pOut[s*2] += pIn[s]*Lvol;
+				pOut[s*2+1] += pIn[s]*Rvol;
 			}
 		}
 	}
+	v->m_Tick += End;
 
+	// loop or be done
+	if(v->m_Tick == v->m_pSample->m_NumFrames)
+	{
+		if(!(v->m_Flags&ISound::FLAG_LOOP))
+			return false;
+		v->m_Tick = 0;
+	}
+	return true;
+}
+
+// applies the master volume and clamps the accumulated values
+static void ClampMix(const int *pMix, short *pFinalOut, unsigned Frames, int MasterVol)
+{
+	// same as ((v*MasterVol)/101)>>8 but the products can't overflow in float
+	float Scale = MasterVol/(101.0f*256.0f);
+	unsigned Num = Frames*2;
+	unsigned i = 0;
+
+#if defined(CONF_SOUND_SSE2)
+	__m128 ScaleV = _mm_set1_ps(Scale);
+	__m128i MinV = _mm_set1_epi16(-0x7fff);
+	for(; i+8 <= Num; i += 8)
+	{
+		__m128i A = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(pMix+i))), ScaleV));
+		__m128i B = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(pMix+i+4))), ScaleV));
+		_mm_storeu_si128((__m128i *)(pFinalOut+i), _mm_max_epi16(_mm_packs_epi32(A, B), MinV));
+	}
+#endif
+
+	for(; i < Num; i++)
+		pFinalOut[i] = Int2Short((int)(pMix[i]*Scale));
+}
+
+static void Mix(short *pFinalOut, unsigned Frames)
+{
+	mem_zero(m_pMixBuffer, m_MaxFrames*2*sizeof(int));
+	Frames = min(Frames, m_MaxFrames);
 
-	// release the lock
-	lock_release(m_SoundLock);
+	// pick up what the game thread asked for since the last time
+	ProcessCommands();
 
+	for(unsigned i = 0; i < NUM_VOICES; i++)
 	{
-		// clamp accumulated values
-		// TODO: this seams slow
-		for(unsigned i = 0; i < Frames; i++)
+		if(m_aVoices[i].m_pSample && !MixVoice(&m_aVoices[i], m_pMixBuffer, Frames))
 		{
-			int j = i<<1;
-			int vl = ((m_pMixBuffer[j]*MasterVol)/101)>>8;
-			int vr = ((m_pMixBuffer[j+1]*MasterVol)/101)>>8;
-
-			pFinalOut[j] = Int2Short(vl);
-			pFinalOut[j+1] = Int2Short(vr);
+			// free voice if not used any more
+			m_aVoices[i].m_pSample = 0;
+			m_aVoiceBusy[i] = 0;
 		}
 	}
 
+	ClampMix(m_pMixBuffer, pFinalOut, Frames, m_SoundVolume);
+
 #if defined(CONF_ARCH_ENDIAN_BIG)
 	swap_endian(pFinalOut, sizeof(short), Frames * 2);
 #endif
@@ -207,7 +367,7 @@ int CSound::Init()
 
 	SDL_AudioSpec Format;
 
-	m_SoundLock = lock_create();
+	m_LoadLock = lock_create();
 
 	if(!g_Config.m_SndEnable)
 		return 0;
@@ -256,11 +416,7 @@ int CSound::Update()
 		WantedVolume = 0;
 
 	if(WantedVolume != m_SoundVolume)
-	{
-		lock_wait(m_SoundLock);
 		m_SoundVolume = WantedVolume;
-		lock_release(m_SoundLock);
-	}
 
 	return 0;
 }
@@ -269,7 +425,7 @@ int CSound::Shutdown()
 {
 	SDL_CloseAudio();
 	SDL_QuitSubSystem(SDL_INIT_AUDIO);
-	lock_destroy(m_SoundLock);
+	lock_destroy(m_LoadLock);
 	if(m_pMixBuffer)
 	{
 		mem_free(m_pMixBuffer);
@@ -290,9 +446,8 @@ int CSound::AllocID()
 	return -1;
 }
 
-void CSound::RateConvert(int SampleID)
+void CSound::RateConvert(CSample *pSample)
 {
-	CSample *pSample = &m_aSamples[SampleID];
 	int NumFrames = 0;
 	short *pNewData = 0;
 
@@ -326,20 +481,150 @@ void CSound::RateConvert(int SampleID)
 	mem_free(pSample->m_pData);
 	pSample->m_pData = pNewData;
 	pSample->m_NumFrames = NumFrames;
+	pSample->m_Rate = m_MixingRate;
 }
 
 int CSound::ReadData(void *pBuffer, int Size)
 {
-	return io_read(ms_File, pBuffer, Size);
+	int Read = min(Size, ms_ReadSize-ms_ReadPos);
+	mem_copy(pBuffer, ms_pReadData+ms_ReadPos, Read);
+	ms_ReadPos += Read;
+	return Read;
 }
 
-int CSound::LoadWV(const char *pFilename)
+bool CSound::DecodeWV(const char *pFilename, const unsigned char *pData, int DataSize, CSample *pSample, bool *pComplete)
 {
-	CSample *pSample;
-	int SampleID = -1;
+	*pComplete = false;
 	char aError[100];
 	WavpackContext *pContext;
 
+	ms_pReadData = pData;
+	ms_ReadSize = DataSize;
+	ms_ReadPos = 0;
+
+	pContext = WavpackOpenFileInput(ReadData, aError);
+	if(!pContext)
+	{
+		dbg_msg("sound/wv", "failed to open %s: %s", pFilename, aError);
+		return false;
+	}
+
+	int NumSamples = WavpackGetNumSamples(pContext);
+	int BitsPerSample = WavpackGetBitsPerSample(pContext);
+	unsigned int SampleRate = WavpackGetSampleRate(pContext);
+	int NumChannels = WavpackGetNumChannels(pContext);
+
+	if(NumChannels > 2)
+	{
+		dbg_msg("sound/wv", "file is not mono or stereo. filename='%s'", pFilename);
+		return false;
+	}
+
+	/*
+	if(snd->rate != 44100)
+	{
+		dbg_msg("sound/wv", "file is %d Hz, not 44100 Hz. filename='%s'", snd->rate, filename);
+		return -1;
+	}*/
+
+	if(BitsPerSample != 16)
+	{
+		dbg_msg("sound/wv", "bps is %d, not 16, filname='%s'", BitsPerSample, pFilename);
+		return false;
+	}
+
+	pSample->m_Channels = NumChannels;
+	pSample->m_Rate = SampleRate;
+	pSample->m_pData = (short *)mem_alloc(2*NumSamples*NumChannels, 1);
+
+	// unpack in chunks so the 32 bit samples never exist for the whole file at once
+	static int s_aDecoded[DECODE_CHUNK_FRAMES*2];
+	short *pDst = pSample->m_pData;
+	int Done = 0;
+	while(Done < NumSamples)
+	{
+		int Unpacked = WavpackUnpackSamples(pContext, s_aDecoded, min(NumSamples-Done, (int)DECODE_CHUNK_FRAMES));
+		if(Unpacked <= 0)
+			break;
+		for(int i = 0; i < Unpacked*NumChannels; i++)
+			*pDst++ = (short)s_aDecoded[i];
+		Done += Unpacked;
+	}
+
+	if(Done <= 0)
+	{
+		dbg_msg("sound/wv", "failed to decode %s", pFilename);
+		mem_free(pSample->m_pData);
+		pSample->m_pData = 0;
+		return false;
+	}
+
+	// keep what was decoded, but never let the uninitialized rest be played or cached
+	if(Done < NumSamples)
+		dbg_msg("sound/wv", "decoded only %d of %d samples. filename='%s'", Done, NumSamples, pFilename);
+	pSample->m_NumFrames = Done;
+	*pComplete = Done == NumSamples;
+	return true;
+}
+
+bool CSound::LoadSampleCache(unsigned Crc, int FileSize, CSample *pSample)
+{
+	char aCacheName[64];
+	str_format(aCacheName, sizeof(aCacheName), "soundcache/%08x_%d.pcm", Crc, m_MixingRate);
+	IOHANDLE File = m_pStorage->OpenFile(aCacheName, IOFLAG_READ, IStorage::TYPE_SAVE);
+	if(!File)
+		return false;
+
+	// anything that doesn't match gets decoded again and overwritten
+	CSampleCacheHeader Header;
+	int DataSize = (int)io_length(File)-(int)sizeof(Header);
+	if(io_read(File, &Header, sizeof(Header)) != sizeof(Header) || mem_comp(Header.m_aMagic, gs_aSampleCacheMagic, sizeof(Header.m_aMagic)) != 0 ||
+		Header.m_Version != SAMPLECACHE_VERSION || Header.m_Crc != Crc || Header.m_FileSize != FileSize || Header.m_Rate != m_MixingRate ||
+		Header.m_Channels < 1 || Header.m_Channels > 2 || Header.m_NumFrames <= 0 || DataSize != Header.m_NumFrames*Header.m_Channels*(int)sizeof(short))
+	{
+		io_close(File);
+		return false;
+	}
+
+	pSample->m_pData = (short *)mem_alloc(DataSize, 1);
+	if(io_read(File, pSample->m_pData, DataSize) != (unsigned)DataSize)
+	{
+		io_close(File);
+		mem_free(pSample->m_pData);
+		pSample->m_pData = 0;
+		return false;
+	}
+	io_close(File);
+
+	pSample->m_Channels = Header.m_Channels;
+	pSample->m_Rate = Header.m_Rate;
+	pSample->m_NumFrames = Header.m_NumFrames;
+	return true;
+}
+
+void CSound::SaveSampleCache(unsigned Crc, int FileSize, const CSample *pSample)
+{
+	char aCacheName[64];
+	str_format(aCacheName, sizeof(aCacheName), "soundcache/%08x_%d.pcm", Crc, m_MixingRate);
+	IOHANDLE File = m_pStorage->OpenFile(aCacheName, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+		return;
+
+	CSampleCacheHeader Header;
+	mem_copy(Header.m_aMagic, gs_aSampleCacheMagic, sizeof(Header.m_aMagic));
+	Header.m_Version = SAMPLECACHE_VERSION;
+	Header.m_Crc = Crc;
+	Header.m_FileSize = FileSize;
+	Header.m_Rate = pSample->m_Rate;
+	Header.m_Channels = pSample->m_Channels;
+	Header.m_NumFrames = pSample->m_NumFrames;
+	io_write(File, &Header, sizeof(Header));
+	io_write(File, pSample->m_pData, pSample->m_NumFrames*pSample->m_Channels*sizeof(short));
+	io_close(File);
+}
+
+int CSound::LoadWV(const char *pFilename)
+{
 	// don't waste memory on sound when we are stress testing
 	if(g_Config.m_DbgStress)
 		return -1;
@@ -351,81 +636,62 @@ int CSound::LoadWV(const char *pFilename)
 	if(!m_pStorage)
 		return -1;
 
-	ms_File = m_pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
-	if(!ms_File)
+	// read the whole file first, several threads can do that at once
+	IOHANDLE File = m_pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!File)
 	{
 		dbg_msg("sound/wv", "failed to open file. filename='%s'", pFilename);
 		return -1;
 	}
 
-	SampleID = AllocID();
-	if(SampleID < 0)
-		return -1;
-	pSample = &m_aSamples[SampleID];
+	int FileSize = (int)io_length(File);
+	unsigned char *pFileData = (unsigned char *)mem_alloc(max(FileSize, 1), 1);
+	FileSize = io_read(File, pFileData, FileSize);
+	io_close(File);
 
-	pContext = WavpackOpenFileInput(ReadData, aError);
-	if (pContext)
+	CSample Sample;
+	mem_zero(&Sample, sizeof(Sample));
+	unsigned Crc = crc32(0, pFileData, FileSize); // ignore_convention
+	bool Cached = g_Config.m_SndCache && LoadSampleCache(Crc, FileSize, &Sample);
+	if(!Cached)
 	{
-		int m_aSamples = WavpackGetNumSamples(pContext);
-		int BitsPerSample = WavpackGetBitsPerSample(pContext);
-		unsigned int SampleRate = WavpackGetSampleRate(pContext);
-		int m_aChannels = WavpackGetNumChannels(pContext);
-		int *pData;
-		int *pSrc;
-		short *pDst;
-		int i;
-
-		pSample->m_Channels = m_aChannels;
-		pSample->m_Rate = SampleRate;
-
-		if(pSample->m_Channels > 2)
-		{
-			dbg_msg("sound/wv", "file is not mono or stereo. filename='%s'", pFilename);
-			return -1;
-		}
-
-		/*
-		if(snd->rate != 44100)
+		// the wavpack decoder keeps its state in globals, so only one decodes at a time
+		lock_wait(m_LoadLock);
+		bool Complete;
+		bool Decoded = DecodeWV(pFilename, pFileData, FileSize, &Sample, &Complete);
+		lock_release(m_LoadLock);
+		if(!Decoded)
 		{
-			dbg_msg("sound/wv", "file is %d Hz, not 44100 Hz. filename='%s'", snd->rate, filename);
-			return -1;
-		}*/
-
-		if(BitsPerSample != 16)
-		{
-			dbg_msg("sound/wv", "bps is %d, not 16, filname='%s'", BitsPerSample, pFilename);
+			mem_free(pFileData);
 			return -1;
 		}
 
-		pData = (int *)mem_alloc(4*m_aSamples*m_aChannels, 1);
-		WavpackUnpackSamples(pContext, pData, m_aSamples); // TODO: check return value
-		pSrc = pData;
-
-		pSample->m_pData = (short *)mem_alloc(2*m_aSamples*m_aChannels, 1);
-		pDst = pSample->m_pData;
-
-		for (i = 0; i < m_aSamples*m_aChannels; i++)
-			*pDst++ = (short)*pSrc++;
-
-		mem_free(pData);
-
-		pSample->m_NumFrames = m_aSamples;
-		pSample->m_LoopStart = -1;
-		pSample->m_LoopEnd = -1;
-		pSample->m_PausedAt = 0;
+		RateConvert(&Sample);
+		if(g_Config.m_SndCache && Complete)
+			SaveSampleCache(Crc, FileSize, &Sample);
 	}
-	else
+	mem_free(pFileData);
+
+	lock_wait(m_LoadLock);
+	int SampleID = AllocID();
+	if(SampleID >= 0)
 	{
-		dbg_msg("sound/wv", "failed to open %s: %s", pFilename, aError);
+		Sample.m_LoopStart = -1;
+		Sample.m_LoopEnd = -1;
+		Sample.m_PausedAt = 0;
+		m_aSamples[SampleID] = Sample;
 	}
+	lock_release(m_LoadLock);
 
-	io_close(ms_File);
-	ms_File = NULL;
+	if(SampleID < 0)
+	{
+		mem_free(Sample.m_pData);
+		return -1;
+	}
 
 	if(g_Config.m_Debug)
-		dbg_msg("sound/wv", "loaded %s", pFilename);
+		dbg_msg("sound/wv", "loaded %s%s", pFilename, Cached ? " from cache" : "");
 
-	RateConvert(SampleID);
 	return SampleID;
 }
 
@@ -447,13 +713,15 @@ int CSound::Play(int ChannelID, int SampleID, int Flags, float x, float y)
 	int VoiceID = -1;
 	int i;
 
-	lock_wait(m_SoundLock);
+	// nobody would pick up the command
+	if(!m_SoundEnabled)
+		return -1;
 
 	// search for voice
 	for(i = 0; i < NUM_VOICES; i++)
 	{
 		int id = (m_NextVoice + i) % NUM_VOICES;
-		if(!m_aVoices[id].m_pSample)
+		if(!m_aVoiceBusy[id])
 		{
 			VoiceID = id;
 			m_NextVoice = id+1;
@@ -464,19 +732,24 @@ int CSound::Play(int ChannelID, int SampleID, int Flags, float x, float y)
 	// voice found, use it
 	if(VoiceID != -1)
 	{
-		m_aVoices[VoiceID].m_pSample = &m_aSamples[SampleID];
-		m_aVoices[VoiceID].m_pChannel = &m_aChannels[ChannelID];
-		if(Flags & FLAG_LOOP)
-			m_aVoices[VoiceID].m_Tick = m_aSamples[SampleID].m_PausedAt;
-		else
-			m_aVoices[VoiceID].m_Tick = 0;
-		m_aVoices[VoiceID].m_Vol = 255;
-		m_aVoices[VoiceID].m_Flags = Flags;
-		m_aVoices[VoiceID].m_X = (int)x;
-		m_aVoices[VoiceID].m_Y = (int)y;
+		CSoundCommand Cmd;
+		Cmd.m_Cmd = CSoundCommand::CMD_PLAY;
+		Cmd.m_VoiceID = VoiceID;
+		Cmd.m_SampleID = SampleID;
+		Cmd.m_ChannelID = ChannelID;
+		Cmd.m_Flags = Flags;
+		Cmd.m_X = (int)x;
+		Cmd.m_Y = (int)y;
+
+		m_aVoiceBusy[VoiceID] = 1;
+		if(!PushCommand(&Cmd))
+		{
+			// rather drop the sound than wait for the mixer
+			m_aVoiceBusy[VoiceID] = 0;
+			VoiceID = -1;
+		}
 	}
 
-	lock_release(m_SoundLock);
 	return VoiceID;
 }
 
@@ -492,42 +765,94 @@ int CSound::Play(int ChannelID, int SampleID, int Flags)
 
 void CSound::Stop(int SampleID)
 {
+	if(!m_SoundEnabled)
+		return;
+
 	// TODO: a nice fade out
-	lock_wait(m_SoundLock);
-	CSample *pSample = &m_aSamples[SampleID];
-	for(int i = 0; i < NUM_VOICES; i++)
-	{
-		if(m_aVoices[i].m_pSample == pSample)
-		{
-			if(m_aVoices[i].m_Flags & FLAG_LOOP)
-				m_aVoices[i].m_pSample->m_PausedAt = m_aVoices[i].m_Tick;
-			else
-				m_aVoices[i].m_pSample->m_PausedAt = 0;
-			m_aVoices[i].m_pSample = 0;
-		}
-	}
-	lock_release(m_SoundLock);
+	CSoundCommand Cmd;
+	Cmd.m_Cmd = CSoundCommand::CMD_STOP;
+	Cmd.m_SampleID = SampleID;
+
+	// stopping can't be dropped, the mixer frees a slot within one buffer
+	while(!PushCommand(&Cmd))
+		thread_yield();
 }
 
 void CSound::StopAll()
 {
+	if(!m_SoundEnabled)
+		return;
+
 	// TODO: a nice fade out
-	lock_wait(m_SoundLock);
-	for(int i = 0; i < NUM_VOICES; i++)
+	CSoundCommand Cmd;
+	Cmd.m_Cmd = CSoundCommand::CMD_STOPALL;
+
+	while(!PushCommand(&Cmd))
+		thread_yield();
+}
+
+void CSound::Benchmark(int NumVoices, int Seconds)
+{
+	// made up sounds, so this neither needs an audio device nor loaded samples
+	int Rate = g_Config.m_SndRate;
+	int BufferFrames = g_Config.m_SndBufferSize;
+	CSample aSamples[2];
+	for(int c = 0; c < 2; c++)
 	{
-		if(m_aVoices[i].m_pSample)
-		{
-			if(m_aVoices[i].m_Flags & FLAG_LOOP)
-				m_aVoices[i].m_pSample->m_PausedAt = m_aVoices[i].m_Tick;
-			else
-				m_aVoices[i].m_pSample->m_PausedAt = 0;
-		}
-		m_aVoices[i].m_pSample = 0;
+		aSamples[c].m_Channels = c+1;
+		aSamples[c].m_NumFrames = Rate;
+		aSamples[c].m_Rate = Rate;
+		aSamples[c].m_pData = (short *)mem_alloc(Rate*(c+1)*sizeof(short), 1);
+		for(int i = 0; i < Rate*(c+1); i++)
+			aSamples[c].m_pData[i] = (short)(sinf(i*(0.05f+c*0.01f))*20000.0f);
+	}
+
+	CChannel Channel = {255, 255};
+	CVoice *pVoices = (CVoice *)mem_alloc(NumVoices*sizeof(CVoice), 1);
+	for(int i = 0; i < NumVoices; i++)
+	{
+		pVoices[i].m_pSample = &aSamples[i%2];
+		pVoices[i].m_pChannel = &Channel;
+		pVoices[i].m_Tick = (i*997)%Rate;
+		pVoices[i].m_Vol = 255;
+		pVoices[i].m_Flags = i%3 ? FLAG_LOOP|FLAG_POS : FLAG_LOOP;
+		pVoices[i].m_X = m_CenterX+(i%7-3)*200;
+		pVoices[i].m_Y = m_CenterY+(i%5-2)*200;
 	}
-	lock_release(m_SoundLock);
+
+	int *pMix = (int *)mem_alloc(BufferFrames*2*sizeof(int), 1);
+	short *pOut = (short *)mem_alloc(BufferFrames*2*sizeof(short), 1);
+	int NumBuffers = (int)((int64)Seconds*Rate/BufferFrames);
+
+	int64 Start = time_get();
+	for(int b = 0; b < NumBuffers; b++)
+	{
+		mem_zero(pMix, BufferFrames*2*sizeof(int));
+		for(int i = 0; i < NumVoices; i++)
+			MixVoice(&pVoices[i], pMix, BufferFrames);
+		ClampMix(pMix, pOut, BufferFrames, 100);
+	}
+	double Time = (time_get()-Start)/(double)time_freq();
+
+	dbg_msg("sound", "benchmark: %d voices, %d buffers of %d frames in %.3fs, %.2fus per buffer, %.0fx realtime (%s)",
+		NumVoices, NumBuffers, BufferFrames, Time, NumBuffers ? Time*1000000.0/NumBuffers : 0.0, Time > 0.0 ? Seconds/Time : 0.0,
+#if defined(CONF_SOUND_SSE2)
+		"sse2"
+#else
+		"scalar"
+#endif
+		);
+
+	mem_free(pOut);
+	mem_free(pMix);
+	mem_free(pVoices);
+	mem_free(aSamples[0].m_pData);
+	mem_free(aSamples[1].m_pData);
 }
 
-IOHANDLE CSound::ms_File = 0;
+const unsigned char *CSound::ms_pReadData = 0;
+int CSound::ms_ReadSize = 0;
+int CSound::ms_ReadPos = 0;
 
 IEngineSound *CreateEngineSound() { return new CSound; }
 
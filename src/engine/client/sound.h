@@ -19,11 +19,20 @@ public:
 	int Shutdown();
 	int AllocID();
 
-	static void RateConvert(int SampleID);
+	virtual void Benchmark(int NumVoices, int Seconds);
+
+	static void RateConvert(struct CSample *pSample);
 
 	// TODO: Refactor: clean this mess up
-	static IOHANDLE ms_File;
+	static const unsigned char *ms_pReadData;
+	static int ms_ReadSize;
+	static int ms_ReadPos;
 	static int ReadData(void *pBuffer, int Size);
+	bool DecodeWV(const char *pFilename, const unsigned char *pData, int DataSize, struct CSample *pSample, bool *pComplete);
+
+	// decoded samples at the mixing rate, keyed by the crc of the .wv file
+	bool LoadSampleCache(unsigned Crc, int FileSize, struct CSample *pSample);
+	void SaveSampleCache(unsigned Crc, int FileSize, const struct CSample *pSample);
 
 	virtual bool IsSoundEnabled() { return m_SoundEnabled != 0; }
 
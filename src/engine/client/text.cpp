@@ -17,6 +17,14 @@
 enum
 {
 	MAX_CHARACTERS = 64,
+	MAX_GLYPHS = MAX_CHARACTERS*MAX_CHARACTERS,
+	GLYPH_HASH_SIZE = 1024,
+	MAX_SHELVES = 256,
+	MAX_EVICT_SEARCH = 64,
+
+	TEXT_CACHE_SIZE = 512,
+	TEXT_CACHE_HASH_SIZE = 1024,
+	MAX_CACHED_TEXT_LENGTH = 256,
 };
 
 
@@ -37,6 +45,24 @@ struct CFontChar
 
 	float m_aUvs[4];
 	int64 m_TouchTime;
+
+	// place in the atlas, can be bigger than the glyph when it was taken over from an evicted one
+	int m_CellX;
+	int m_CellY;
+	int m_CellWidth;
+	int m_CellHeight;
+
+	int m_HashNext;
+	int m_LruPrev;
+	int m_LruNext;
+};
+
+// a row of glyphs with the same (rounded) height, filled from left to right
+struct CFontShelf
+{
+	int m_Y;
+	int m_Height;
+	int m_Width;
 };
 
 struct CFontSizeData
@@ -54,11 +80,46 @@ struct CFontSizeData
 	int m_CharMaxWidth;
 	int m_CharMaxHeight;
 
-	CFontChar m_aCharacters[MAX_CHARACTERS*MAX_CHARACTERS];
+	CFontChar m_aCharacters[MAX_GLYPHS];
+	int m_NumCharacters;
+	int m_aHash[GLYPH_HASH_SIZE];
+	int m_LruFirst; // most recently used
+	int m_LruLast;
+
+	CFontShelf m_aShelves[MAX_SHELVES];
+	int m_NumShelves;
+	int m_ShelfBottom;
 
-	int m_CurrentCharacter;
+	// bumped whenever a glyph is evicted, cached text of this size is stale then
+	int m_Generation;
 };
 
+// intrusive lists over arrays, linked by index through m_LruPrev and m_LruNext
+template<class T>
+static void LruRemove(T *pItems, int *pFirst, int *pLast, int Index)
+{
+	if(pItems[Index].m_LruPrev >= 0)
+		pItems[pItems[Index].m_LruPrev].m_LruNext = pItems[Index].m_LruNext;
+	else
+		*pFirst = pItems[Index].m_LruNext;
+	if(pItems[Index].m_LruNext >= 0)
+		pItems[pItems[Index].m_LruNext].m_LruPrev = pItems[Index].m_LruPrev;
+	else
+		*pLast = pItems[Index].m_LruPrev;
+}
+
+template<class T>
+static void LruPushFront(T *pItems, int *pFirst, int *pLast, int Index)
+{
+	pItems[Index].m_LruPrev = -1;
+	pItems[Index].m_LruNext = *pFirst;
+	if(*pFirst >= 0)
+		pItems[*pFirst].m_LruPrev = Index;
+	else
+		*pLast = Index;
+	*pFirst = Index;
+}
+
 class CFont
 {
 public:
@@ -67,6 +128,39 @@ public:
 	CFontSizeData m_aSizes[NUM_FONT_SIZES];
 };
 
+// a laid out text run, the quads are relative to the (pixel aligned) cursor start
+struct CTextCacheEntry
+{
+	unsigned m_Hash;
+	CFont *m_pFont;
+	int m_FontSize;
+	float m_FakeToScreenX;
+	float m_FakeToScreenY;
+	float m_SubPixelX;
+	float m_LineWidth;
+	int m_Flags;
+	int m_MaxLines;
+	int m_LineCount;
+	int m_Length;
+	char m_aText[MAX_CACHED_TEXT_LENGTH];
+
+	int m_Generation;
+	float m_EndX;
+	float m_EndY;
+	int m_GotNewLine;
+	int m_EndLineCount;
+	int m_NumChars;
+
+	IGraphics::CQuadVertex *m_pVertices;
+	int *m_pGlyphs;
+	int m_NumQuads;
+	int m_MaxQuads;
+
+	int m_HashNext;
+	int m_LruPrev;
+	int m_LruNext;
+};
+
 
 class CTextRender : public IEngineTextRender
 {
@@ -103,6 +197,9 @@ class CTextRender : public IEngineTextRender
 
 	FT_Library m_FTLibrary;
 
+	// taken once per text, used to tell which glyphs are still in use
+	int64 m_CurrentTime;
+
 	int GetFontSizeIndex(int Pixelsize)
 	{
 		for(unsigned i = 0; i < NUM_FONT_SIZES; i++)
@@ -165,7 +262,7 @@ class CTextRender : public IEngineTextRender
 		pSizeData->m_NumYChars = Ychars;
 		pSizeData->m_TextureWidth = Width;
 		pSizeData->m_TextureHeight = Height;
-		pSizeData->m_CurrentCharacter = 0;
+		ResetAtlas(pSizeData);
 		
 		dbg_msg("", "pFont memory usage: %d", FontMemoryUsage);
 
@@ -238,65 +335,121 @@ class CTextRender : public IEngineTextRender
 	}
 
 
-	void UploadGlyph(CFontSizeData *pSizeData, int Texnum, int SlotID, int Chr, const void *pData)
+	void UploadGlyph(CFontSizeData *pSizeData, int Texnum, const CFontChar *pFontchr, const void *pData)
 	{
-		int x = (SlotID%pSizeData->m_NumXChars) * (pSizeData->m_TextureWidth/pSizeData->m_NumXChars);
-		int y = (SlotID/pSizeData->m_NumXChars) * (pSizeData->m_TextureHeight/pSizeData->m_NumYChars);
-
-		Graphics()->LoadTextureRawSub(pSizeData->m_aTextures[Texnum], x, y,
-			pSizeData->m_TextureWidth/pSizeData->m_NumXChars,
-			pSizeData->m_TextureHeight/pSizeData->m_NumYChars,
-			CImageInfo::FORMAT_ALPHA, pData);
-		/*
-		glBindTexture(GL_TEXTURE_2D, pSizeData->m_aTextures[Texnum]);
-		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y,
-			pSizeData->m_TextureWidth/pSizeData->m_NumXChars,
-			pSizeData->m_TextureHeight/pSizeData->m_NumYChars,
-			m_FontTextureFormat, GL_UNSIGNED_BYTE, pData);*/
+		Graphics()->LoadTextureRawSub(pSizeData->m_aTextures[Texnum], pFontchr->m_CellX, pFontchr->m_CellY,
+			pFontchr->m_CellWidth, pFontchr->m_CellHeight, CImageInfo::FORMAT_ALPHA, pData);
 	}
 
 	// 32k of data used for rendering glyphs
 	unsigned char ms_aGlyphData[(1024/8) * (1024/8)];
 	unsigned char ms_aGlyphDataOutlined[(1024/8) * (1024/8)];
 
-	int GetSlot(CFontSizeData *pSizeData)
+	void ResetAtlas(CFontSizeData *pSizeData)
 	{
-		int CharCount = pSizeData->m_NumXChars*pSizeData->m_NumYChars;
-		if(pSizeData->m_CurrentCharacter < CharCount)
+		pSizeData->m_NumCharacters = 0;
+		for(int i = 0; i < GLYPH_HASH_SIZE; i++)
+			pSizeData->m_aHash[i] = -1;
+		pSizeData->m_LruFirst = -1;
+		pSizeData->m_LruLast = -1;
+		pSizeData->m_NumShelves = 0;
+		pSizeData->m_ShelfBottom = 0;
+		pSizeData->m_Generation++;
+	}
+
+	void TouchChar(CFontSizeData *pSizeData, int Index)
+	{
+		if(pSizeData->m_LruFirst != Index)
 		{
-			int i = pSizeData->m_CurrentCharacter;
-			pSizeData->m_CurrentCharacter++;
-			return i;
+			LruRemove(pSizeData->m_aCharacters, &pSizeData->m_LruFirst, &pSizeData->m_LruLast, Index);
+			LruPushFront(pSizeData->m_aCharacters, &pSizeData->m_LruFirst, &pSizeData->m_LruLast, Index);
 		}
+		pSizeData->m_aCharacters[Index].m_TouchTime = m_CurrentTime;
+	}
+
+	void EvictGlyph(CFontSizeData *pSizeData, int Index)
+	{
+		int *pLink = &pSizeData->m_aHash[pSizeData->m_aCharacters[Index].m_ID&(GLYPH_HASH_SIZE-1)];
+		while(*pLink != Index)
+			pLink = &pSizeData->m_aCharacters[*pLink].m_HashNext;
+		*pLink = pSizeData->m_aCharacters[Index].m_HashNext;
+
+		LruRemove(pSizeData->m_aCharacters, &pSizeData->m_LruFirst, &pSizeData->m_LruLast, Index);
+		pSizeData->m_Generation++;
+	}
 
-		// kick out the oldest
-		// TODO: remove this linear search
+	// returns a glyph with a cell of at least the given size, it isn't linked in yet
+	int AllocGlyph(CFontSizeData *pSizeData, int Width, int Height)
+	{
+		// fresh space on a shelf of the same height or on a new one
+		if(pSizeData->m_NumCharacters < MAX_GLYPHS)
 		{
-			int Oldest = 0;
-			for(int i = 1; i < CharCount; i++)
+			CFontShelf *pShelf = 0;
+			for(int i = 0; i < pSizeData->m_NumShelves; i++)
+			{
+				if(pSizeData->m_aShelves[i].m_Height == Height && pSizeData->m_aShelves[i].m_Width+Width <= pSizeData->m_TextureWidth)
+				{
+					pShelf = &pSizeData->m_aShelves[i];
+					break;
+				}
+			}
+
+			if(!pShelf && pSizeData->m_NumShelves < MAX_SHELVES && pSizeData->m_ShelfBottom+Height <= pSizeData->m_TextureHeight)
 			{
-				if(pSizeData->m_aCharacters[i].m_TouchTime < pSizeData->m_aCharacters[Oldest].m_TouchTime)
-					Oldest = i;
+				pShelf = &pSizeData->m_aShelves[pSizeData->m_NumShelves++];
+				pShelf->m_Y = pSizeData->m_ShelfBottom;
+				pShelf->m_Height = Height;
+				pShelf->m_Width = 0;
+				pSizeData->m_ShelfBottom += Height;
 			}
 
-			if(time_get()-pSizeData->m_aCharacters[Oldest].m_TouchTime < time_freq() &&
-				(pSizeData->m_NumXChars < MAX_CHARACTERS || pSizeData->m_NumYChars < MAX_CHARACTERS))
+			if(pShelf)
 			{
-				IncreaseTextureSize(pSizeData);
-				return GetSlot(pSizeData);
+				int Index = pSizeData->m_NumCharacters++;
+				CFontChar *pFontchr = &pSizeData->m_aCharacters[Index];
+				pFontchr->m_CellX = pShelf->m_Width;
+				pFontchr->m_CellY = pShelf->m_Y;
+				pFontchr->m_CellWidth = Width;
+				pFontchr->m_CellHeight = Height;
+				pShelf->m_Width += Width;
+				return Index;
 			}
+		}
+
+		// take over the cell of the least recently used glyph that is big enough
+		int Oldest = -1;
+		int Tries = 0;
+		for(int i = pSizeData->m_LruLast; i >= 0 && Tries < MAX_EVICT_SEARCH; i = pSizeData->m_aCharacters[i].m_LruPrev, Tries++)
+		{
+			if(pSizeData->m_aCharacters[i].m_CellWidth >= Width && pSizeData->m_aCharacters[i].m_CellHeight >= Height)
+			{
+				Oldest = i;
+				break;
+			}
+		}
 
-			return Oldest;
+		// rather make room than thrash glyphs that are still in use
+		if((Oldest < 0 || m_CurrentTime-pSizeData->m_aCharacters[Oldest].m_TouchTime < time_freq()) &&
+			(pSizeData->m_NumXChars < MAX_CHARACTERS || pSizeData->m_NumYChars < MAX_CHARACTERS))
+		{
+			IncreaseTextureSize(pSizeData);
+			return AllocGlyph(pSizeData, Width, Height);
 		}
+
+		if(Oldest < 0)
+		{
+			// nothing fits anymore, start over
+			ResetAtlas(pSizeData);
+			return AllocGlyph(pSizeData, Width, Height);
+		}
+
+		EvictGlyph(pSizeData, Oldest);
+		return Oldest;
 	}
 
 	int RenderGlyph(CFont *pFont, CFontSizeData *pSizeData, int Chr)
 	{
 		FT_Bitmap *pBitmap;
-		int SlotID = 0;
-		int SlotW = pSizeData->m_TextureWidth / pSizeData->m_NumXChars;
-		int SlotH = pSizeData->m_TextureHeight / pSizeData->m_NumYChars;
-		int SlotSize = SlotW*SlotH;
 		int x = 1;
 		int y = 1;
 		int px, py;
@@ -311,16 +464,30 @@ class CTextRender : public IEngineTextRender
 
 		pBitmap = &pFont->m_FtFace->glyph->bitmap; // ignore_convention
 
-		// fetch slot
-		SlotID = GetSlot(pSizeData);
-		if(SlotID < 0)
-			return -1;
-
 		// adjust spacing
 		int OutlineThickness = AdjustOutlineThicknessToFontSize(1, pSizeData->m_FontSize);
 		x += OutlineThickness;
 		y += OutlineThickness;
 
+		int Height = pBitmap->rows + OutlineThickness*2 + 2; // ignore_convention
+		int Width = pBitmap->width + OutlineThickness*2 + 2; // ignore_convention
+
+		// cells are rounded up to 4 pixels, keeps the uploaded rows aligned and the number of shelf heights low
+		int CellWidth = (Width+3)&~3;
+		int CellHeight = (Height+3)&~3;
+		if(CellWidth*CellHeight > (int)sizeof(ms_aGlyphData))
+		{
+			dbg_msg("pFont", "glyph %d is too big", Chr);
+			return -1;
+		}
+
+		// fetch slot
+		int SlotID = AllocGlyph(pSizeData, CellWidth, CellHeight);
+		CFontChar *pFontchr = &pSizeData->m_aCharacters[SlotID];
+		int SlotW = pFontchr->m_CellWidth;
+		int SlotH = pFontchr->m_CellHeight;
+		int SlotSize = SlotW*SlotH;
+
 		// prepare glyph data
 		mem_zero(ms_aGlyphData, SlotSize);
 
@@ -345,12 +512,12 @@ class CTextRender : public IEngineTextRender
 				ms_aGlyphData[py*SlotW+px] = 255;
 
 		// upload the glyph
-		UploadGlyph(pSizeData, 0, SlotID, Chr, ms_aGlyphData);
+		UploadGlyph(pSizeData, 0, pFontchr, ms_aGlyphData);
 
 		if(OutlineThickness == 1)
 		{
 			Grow(ms_aGlyphData, ms_aGlyphDataOutlined, SlotW, SlotH);
-			UploadGlyph(pSizeData, 1, SlotID, Chr, ms_aGlyphDataOutlined);
+			UploadGlyph(pSizeData, 1, pFontchr, ms_aGlyphDataOutlined);
 		}
 		else
 		{
@@ -359,17 +526,14 @@ class CTextRender : public IEngineTextRender
 				Grow(ms_aGlyphData, ms_aGlyphDataOutlined, SlotW, SlotH);
 				Grow(ms_aGlyphDataOutlined, ms_aGlyphData, SlotW, SlotH);
 			}
-			UploadGlyph(pSizeData, 1, SlotID, Chr, ms_aGlyphData);
+			UploadGlyph(pSizeData, 1, pFontchr, ms_aGlyphData);
 		}
 
 		// set char info
 		{
-			CFontChar *pFontchr = &pSizeData->m_aCharacters[SlotID];
 			float Scale = 1.0f/pSizeData->m_FontSize;
 			float Uscale = 1.0f/pSizeData->m_TextureWidth;
 			float Vscale = 1.0f/pSizeData->m_TextureHeight;
-			int Height = pBitmap->rows + OutlineThickness*2 + 2; // ignore_convention
-			int Width = pBitmap->width + OutlineThickness*2 + 2; // ignore_convention
 
 			pFontchr->m_ID = Chr;
 			pFontchr->m_Height = Height * Scale;
@@ -378,45 +542,36 @@ class CTextRender : public IEngineTextRender
 			pFontchr->m_OffsetY = (pSizeData->m_FontSize - pFont->m_FtFace->glyph->bitmap_top) * Scale; // ignore_convention
 			pFontchr->m_AdvanceX = (pFont->m_FtFace->glyph->advance.x>>6) * Scale; // ignore_convention
 
-			pFontchr->m_aUvs[0] = (SlotID%pSizeData->m_NumXChars) / (float)(pSizeData->m_NumXChars);
-			pFontchr->m_aUvs[1] = (SlotID/pSizeData->m_NumXChars) / (float)(pSizeData->m_NumYChars);
+			pFontchr->m_aUvs[0] = pFontchr->m_CellX * Uscale;
+			pFontchr->m_aUvs[1] = pFontchr->m_CellY * Vscale;
 			pFontchr->m_aUvs[2] = pFontchr->m_aUvs[0] + Width*Uscale;
 			pFontchr->m_aUvs[3] = pFontchr->m_aUvs[1] + Height*Vscale;
 		}
 
+		// link it in
+		pFontchr->m_HashNext = pSizeData->m_aHash[Chr&(GLYPH_HASH_SIZE-1)];
+		pSizeData->m_aHash[Chr&(GLYPH_HASH_SIZE-1)] = SlotID;
+		LruPushFront(pSizeData->m_aCharacters, &pSizeData->m_LruFirst, &pSizeData->m_LruLast, SlotID);
+
 		return SlotID;
 	}
 
 	CFontChar *GetChar(CFont *pFont, CFontSizeData *pSizeData, int Chr)
 	{
-		CFontChar *pFontchr = NULL;
-
 		// search for the character
-		// TODO: remove this linear search
-		int i;
-		for(i = 0; i < pSizeData->m_CurrentCharacter; i++)
-		{
-			if(pSizeData->m_aCharacters[i].m_ID == Chr)
-			{
-				pFontchr = &pSizeData->m_aCharacters[i];
-				break;
-			}
-		}
+		int Index = pSizeData->m_aHash[Chr&(GLYPH_HASH_SIZE-1)];
+		while(Index >= 0 && pSizeData->m_aCharacters[Index].m_ID != Chr)
+			Index = pSizeData->m_aCharacters[Index].m_HashNext;
 
 		// check if we need to render the character
-		if(!pFontchr)
-		{
-			int Index = RenderGlyph(pFont, pSizeData, Chr);
-			if(Index >= 0)
-				pFontchr = &pSizeData->m_aCharacters[Index];
-		}
+		if(Index < 0)
+			Index = RenderGlyph(pFont, pSizeData, Chr);
+		if(Index < 0)
+			return NULL;
 
 		// touch the character
-		// TODO: don't call time_get here
-		if(pFontchr)
-			pFontchr->m_TouchTime = time_get();
-
-		return pFontchr;
+		TouchChar(pSizeData, Index);
+		return &pSizeData->m_aCharacters[Index];
 	}
 
 	// must only be called from the rendering function as the pFont must be set to the correct size
@@ -433,6 +588,316 @@ class CTextRender : public IEngineTextRender
 	}
 
 
+	struct CLayout
+	{
+		CFont *m_pFont;
+		CFontSizeData *m_pSizeData;
+		int m_ActualSize;
+		float m_Size;
+		float m_FakeToScreenX;
+		float m_FakeToScreenY;
+		float m_CursorX;
+		float m_CursorY;
+	};
+
+	bool SetupLayout(const CTextCursor *pCursor, CLayout *pLayout)
+	{
+		float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
+
+		// to correct coords, convert to screen coords, round, and convert back
+		Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
+
+		pLayout->m_FakeToScreenX = (Graphics()->ScreenWidth()/(ScreenX1-ScreenX0));
+		pLayout->m_FakeToScreenY = (Graphics()->ScreenHeight()/(ScreenY1-ScreenY0));
+		int ActualX = (int)(pCursor->m_X * pLayout->m_FakeToScreenX);
+		int ActualY = (int)(pCursor->m_Y * pLayout->m_FakeToScreenY);
+
+		pLayout->m_CursorX = ActualX / pLayout->m_FakeToScreenX;
+		pLayout->m_CursorY = ActualY / pLayout->m_FakeToScreenY;
+
+		// same with size
+		pLayout->m_ActualSize = (int)(pCursor->m_FontSize * pLayout->m_FakeToScreenY);
+		pLayout->m_Size = pLayout->m_ActualSize / pLayout->m_FakeToScreenY;
+
+		// fetch pFont data
+		pLayout->m_pFont = pCursor->m_pFont;
+		if(!pLayout->m_pFont)
+			pLayout->m_pFont = m_pDefaultFont;
+
+		if(!pLayout->m_pFont)
+			return false;
+
+		pLayout->m_pSizeData = GetSize(pLayout->m_pFont, pLayout->m_ActualSize);
+		return true;
+	}
+
+	// quads of the text that is laid out right now
+	IGraphics::CQuadVertex *m_pQuads;
+	int *m_pQuadGlyphs;
+	int m_NumQuads;
+	int m_MaxQuads;
+
+	void EnsureQuads(int Num)
+	{
+		if(Num <= m_MaxQuads)
+			return;
+
+		int MaxQuads = max(m_MaxQuads*2, max(Num, 64));
+		IGraphics::CQuadVertex *pQuads = (IGraphics::CQuadVertex *)mem_alloc(MaxQuads*4*sizeof(IGraphics::CQuadVertex), 1);
+		int *pQuadGlyphs = (int *)mem_alloc(MaxQuads*sizeof(int), 1);
+		if(m_NumQuads)
+		{
+			mem_copy(pQuads, m_pQuads, m_NumQuads*4*sizeof(IGraphics::CQuadVertex));
+			mem_copy(pQuadGlyphs, m_pQuadGlyphs, m_NumQuads*sizeof(int));
+		}
+		mem_free(m_pQuads);
+		mem_free(m_pQuadGlyphs);
+		m_pQuads = pQuads;
+		m_pQuadGlyphs = pQuadGlyphs;
+		m_MaxQuads = MaxQuads;
+	}
+
+	void AddQuad(const CFontSizeData *pSizeData, const CFontChar *pChr, float x, float y, float w, float h)
+	{
+		EnsureQuads(m_NumQuads+1);
+		IGraphics::CQuadVertex *pVertex = &m_pQuads[m_NumQuads*4];
+		pVertex[0] = IGraphics::CQuadVertex(x, y, pChr->m_aUvs[0], pChr->m_aUvs[1]);
+		pVertex[1] = IGraphics::CQuadVertex(x+w, y, pChr->m_aUvs[2], pChr->m_aUvs[1]);
+		pVertex[2] = IGraphics::CQuadVertex(x+w, y+h, pChr->m_aUvs[2], pChr->m_aUvs[3]);
+		pVertex[3] = IGraphics::CQuadVertex(x, y+h, pChr->m_aUvs[0], pChr->m_aUvs[3]);
+		m_pQuadGlyphs[m_NumQuads++] = pChr - pSizeData->m_aCharacters;
+	}
+
+	void RenderQuads(CFontSizeData *pSizeData, const IGraphics::CQuadVertex *pVertices, int NumQuads)
+	{
+		if(!NumQuads)
+			return;
+
+		// outline first, then the text itself
+		Graphics()->TextureSet(pSizeData->m_aTextures[1]);
+		Graphics()->QuadsBegin();
+		Graphics()->SetColor(m_TextOutlineR, m_TextOutlineG, m_TextOutlineB, m_TextOutlineA*m_TextA);
+		Graphics()->QuadsDrawVertices(pVertices, NumQuads);
+		Graphics()->QuadsEnd();
+
+		Graphics()->TextureSet(pSizeData->m_aTextures[0]);
+		Graphics()->QuadsBegin();
+		Graphics()->SetColor(m_TextR, m_TextG, m_TextB, m_TextA);
+		Graphics()->QuadsDrawVertices(pVertices, NumQuads);
+		Graphics()->QuadsEnd();
+	}
+
+	// lays out the text and moves the cursor, the quads end up in m_pQuads if it renders
+	int TextLayout(CTextCursor *pCursor, const char *pText, int Length, const CLayout *pLayout)
+	{
+		CFont *pFont = pLayout->m_pFont;
+		CFontSizeData *pSizeData = pLayout->m_pSizeData;
+		float FakeToScreenX = pLayout->m_FakeToScreenX;
+		float FakeToScreenY = pLayout->m_FakeToScreenY;
+		float Size = pLayout->m_Size;
+
+		int GotNewLine = 0;
+		float DrawX = pLayout->m_CursorX;
+		float DrawY = pLayout->m_CursorY;
+		int LineCount = pCursor->m_LineCount;
+
+		RenderSetup(pFont, pLayout->m_ActualSize);
+
+		float Scale = 1/pSizeData->m_FontSize;
+
+		const char *pCurrent = (char *)pText;
+		const char *pEnd = pCurrent+Length;
+
+		while(pCurrent < pEnd && (pCursor->m_MaxLines < 1 || LineCount <= pCursor->m_MaxLines))
+		{
+			int NewLine = 0;
+			const char *pBatchEnd = pEnd;
+			if(pCursor->m_LineWidth > 0 && !(pCursor->m_Flags&TEXTFLAG_STOP_AT_END))
+			{
+				int Wlen = min(WordLength((char *)pCurrent), (int)(pEnd-pCurrent));
+				CTextCursor Compare = *pCursor;
+				Compare.m_X = DrawX;
+				Compare.m_Y = DrawY;
+				Compare.m_Flags &= ~TEXTFLAG_RENDER;
+				Compare.m_LineWidth = -1;
+				MeasureText(&Compare, pCurrent, Wlen);
+
+				if(Compare.m_X-DrawX > pCursor->m_LineWidth)
+				{
+					// word can't be fitted in one line, cut it
+					CTextCursor Cutter = *pCursor;
+					Cutter.m_CharCount = 0;
+					Cutter.m_X = DrawX;
+					Cutter.m_Y = DrawY;
+					Cutter.m_Flags &= ~TEXTFLAG_RENDER;
+					Cutter.m_Flags |= TEXTFLAG_STOP_AT_END;
+
+					MeasureText(&Cutter, (const char *)pCurrent, Wlen);
+					Wlen = Cutter.m_CharCount;
+					NewLine = 1;
+
+					if(Wlen <= 3) // if we can't place 3 chars of the word on this line, take the next
+						Wlen = 0;
+				}
+				else if(Compare.m_X-pCursor->m_StartX > pCursor->m_LineWidth)
+				{
+					NewLine = 1;
+					Wlen = 0;
+				}
+
+				pBatchEnd = pCurrent + Wlen;
+			}
+
+			const char *pTmp = pCurrent;
+			int NextCharacter = str_utf8_decode(&pTmp);
+			while(pCurrent < pBatchEnd)
+			{
+				int Character = NextCharacter;
+				pCurrent = pTmp;
+				NextCharacter = str_utf8_decode(&pTmp);
+
+				if(Character == '\n')
+				{
+					DrawX = pCursor->m_StartX;
+					DrawY += Size;
+					DrawX = (int)(DrawX * FakeToScreenX) / FakeToScreenX; // realign
+					DrawY = (int)(DrawY * FakeToScreenY) / FakeToScreenY;
+					++LineCount;
+					if(pCursor->m_MaxLines > 0 && LineCount > pCursor->m_MaxLines)
+						break;
+					continue;
+				}
+
+				CFontChar *pChr = GetChar(pFont, pSizeData, Character);
+				if(pChr)
+				{
+					float Advance = pChr->m_AdvanceX + Kerning(pFont, Character, NextCharacter)*Scale;
+					if(pCursor->m_Flags&TEXTFLAG_STOP_AT_END && DrawX+Advance*Size-pCursor->m_StartX > pCursor->m_LineWidth)
+					{
+						// we hit the end of the line, no more to render or count
+						pCurrent = pEnd;
+						break;
+					}
+
+					if(pCursor->m_Flags&TEXTFLAG_RENDER)
+						AddQuad(pSizeData, pChr, DrawX+pChr->m_OffsetX*Size, DrawY+pChr->m_OffsetY*Size, pChr->m_Width*Size, pChr->m_Height*Size);
+
+					DrawX += Advance*Size;
+					pCursor->m_CharCount++;
+				}
+			}
+
+			if(NewLine)
+			{
+				DrawX = pCursor->m_StartX;
+				DrawY += Size;
+				GotNewLine = 1;
+				DrawX = (int)(DrawX * FakeToScreenX) / FakeToScreenX; // realign
+				DrawY = (int)(DrawY * FakeToScreenY) / FakeToScreenY;
+				++LineCount;
+			}
+		}
+
+		pCursor->m_X = DrawX;
+		pCursor->m_LineCount = LineCount;
+
+		if(GotNewLine)
+			pCursor->m_Y = DrawY;
+
+		return GotNewLine;
+	}
+
+	// used by the line breaking, doesn't go through the cache
+	void MeasureText(CTextCursor *pCursor, const char *pText, int Length)
+	{
+		CLayout Layout;
+		if(SetupLayout(pCursor, &Layout))
+			TextLayout(pCursor, pText, Length, &Layout);
+	}
+
+	CTextCacheEntry m_aTextCache[TEXT_CACHE_SIZE];
+	int m_aTextCacheHash[TEXT_CACHE_HASH_SIZE];
+	int m_NumTextCache;
+	int m_TextCacheFirst;
+	int m_TextCacheLast;
+
+	unsigned TextHash(const char *pText, int Length, int FontSize, int Flags)
+	{
+		unsigned Hash = 2166136261u;
+		for(int i = 0; i < Length; i++)
+			Hash = (Hash^(unsigned char)pText[i])*16777619u;
+		return Hash^(FontSize<<16)^Flags;
+	}
+
+	CTextCacheEntry *FindCachedText(unsigned Hash, const CTextCursor *pCursor, const CLayout *pLayout, float SubPixelX, const char *pText, int Length)
+	{
+		for(int i = m_aTextCacheHash[Hash&(TEXT_CACHE_HASH_SIZE-1)]; i >= 0; i = m_aTextCache[i].m_HashNext)
+		{
+			CTextCacheEntry *pEntry = &m_aTextCache[i];
+			if(pEntry->m_Hash == Hash && pEntry->m_pFont == pLayout->m_pFont && pEntry->m_FontSize == pLayout->m_ActualSize &&
+				pEntry->m_FakeToScreenX == pLayout->m_FakeToScreenX && pEntry->m_FakeToScreenY == pLayout->m_FakeToScreenY &&
+				pEntry->m_SubPixelX == SubPixelX && pEntry->m_LineWidth == pCursor->m_LineWidth && pEntry->m_Flags == pCursor->m_Flags &&
+				pEntry->m_MaxLines == pCursor->m_MaxLines && pEntry->m_LineCount == pCursor->m_LineCount &&
+				pEntry->m_Length == Length && mem_comp(pEntry->m_aText, pText, Length) == 0)
+			{
+				if(m_TextCacheFirst != i)
+				{
+					LruRemove(m_aTextCache, &m_TextCacheFirst, &m_TextCacheLast, i);
+					LruPushFront(m_aTextCache, &m_TextCacheFirst, &m_TextCacheLast, i);
+				}
+				return pEntry;
+			}
+		}
+		return 0;
+	}
+
+	CTextCacheEntry *NewCachedText(unsigned Hash, const CTextCursor *pCursor, const CLayout *pLayout, float SubPixelX, const char *pText, int Length)
+	{
+		int Index;
+		if(m_NumTextCache < TEXT_CACHE_SIZE)
+			Index = m_NumTextCache++;
+		else
+		{
+			// reuse the least recently used one
+			Index = m_TextCacheLast;
+			int *pLink = &m_aTextCacheHash[m_aTextCache[Index].m_Hash&(TEXT_CACHE_HASH_SIZE-1)];
+			while(*pLink != Index)
+				pLink = &m_aTextCache[*pLink].m_HashNext;
+			*pLink = m_aTextCache[Index].m_HashNext;
+			LruRemove(m_aTextCache, &m_TextCacheFirst, &m_TextCacheLast, Index);
+		}
+
+		CTextCacheEntry *pEntry = &m_aTextCache[Index];
+		pEntry->m_Hash = Hash;
+		pEntry->m_pFont = pLayout->m_pFont;
+		pEntry->m_FontSize = pLayout->m_ActualSize;
+		pEntry->m_FakeToScreenX = pLayout->m_FakeToScreenX;
+		pEntry->m_FakeToScreenY = pLayout->m_FakeToScreenY;
+		pEntry->m_SubPixelX = SubPixelX;
+		pEntry->m_LineWidth = pCursor->m_LineWidth;
+		pEntry->m_Flags = pCursor->m_Flags;
+		pEntry->m_MaxLines = pCursor->m_MaxLines;
+		pEntry->m_LineCount = pCursor->m_LineCount;
+		pEntry->m_Length = Length;
+		mem_copy(pEntry->m_aText, pText, Length);
+		pEntry->m_NumQuads = 0;
+
+		pEntry->m_HashNext = m_aTextCacheHash[Hash&(TEXT_CACHE_HASH_SIZE-1)];
+		m_aTextCacheHash[Hash&(TEXT_CACHE_HASH_SIZE-1)] = Index;
+		LruPushFront(m_aTextCache, &m_TextCacheFirst, &m_TextCacheLast, Index);
+		return pEntry;
+	}
+
+	void ClearTextCache()
+	{
+		for(int i = 0; i < TEXT_CACHE_HASH_SIZE; i++)
+			m_aTextCacheHash[i] = -1;
+		m_NumTextCache = 0;
+		m_TextCacheFirst = -1;
+		m_TextCacheLast = -1;
+	}
+
+
 public:
 	CTextRender()
 	{
@@ -448,6 +913,20 @@ public:
 		m_TextOutlineA = 0.3f;
 
 		m_pDefaultFont = 0;
+		m_CurrentTime = 0;
+
+		m_pQuads = 0;
+		m_pQuadGlyphs = 0;
+		m_NumQuads = 0;
+		m_MaxQuads = 0;
+
+		for(int i = 0; i < TEXT_CACHE_SIZE; i++)
+		{
+			m_aTextCache[i].m_pVertices = 0;
+			m_aTextCache[i].m_pGlyphs = 0;
+			m_aTextCache[i].m_MaxQuads = 0;
+		}
+		ClearTextCache();
 
 		// GL_LUMINANCE can be good for debugging
 		//m_FontTextureFormat = GL_ALPHA;
@@ -482,6 +961,8 @@ public:
 
 	virtual void DestroyFont(CFont *pFont)
 	{
+		// the cached runs might refer to it
+		ClearTextCache();
 		mem_free(pFont);
 	}
 
@@ -550,186 +1031,96 @@ public:
 
 	virtual void TextEx(CTextCursor *pCursor, const char *pText, int Length)
 	{
-		CFont *pFont = pCursor->m_pFont;
-		CFontSizeData *pSizeData = NULL;
-
 		//dbg_msg("textrender", "rendering text '%s'", text);
 
-		float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
-		float FakeToScreenX, FakeToScreenY;
-		int ActualX, ActualY;
-
-		int ActualSize;
-		int i;
-		int GotNewLine = 0;
-		float DrawX = 0.0f, DrawY = 0.0f;
-		int LineCount = 0;
-		float CursorX, CursorY;
-
-		float Size = pCursor->m_FontSize;
-
-		// to correct coords, convert to screen coords, round, and convert back
-		Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
-
-		FakeToScreenX = (Graphics()->ScreenWidth()/(ScreenX1-ScreenX0));
-		FakeToScreenY = (Graphics()->ScreenHeight()/(ScreenY1-ScreenY0));
-		ActualX = (int)(pCursor->m_X * FakeToScreenX);
-		ActualY = (int)(pCursor->m_Y * FakeToScreenY);
-
-		CursorX = ActualX / FakeToScreenX;
-		CursorY = ActualY / FakeToScreenY;
-
-		// same with size
-		ActualSize = (int)(Size * FakeToScreenY);
-		Size = ActualSize / FakeToScreenY;
-
-		// fetch pFont data
-		if(!pFont)
-			pFont = m_pDefaultFont;
-
-		if(!pFont)
+		CLayout Layout;
+		if(!SetupLayout(pCursor, &Layout))
 			return;
 
-		pSizeData = GetSize(pFont, ActualSize);
-		RenderSetup(pFont, ActualSize);
-
-		float Scale = 1/pSizeData->m_FontSize;
+		CFontSizeData *pSizeData = Layout.m_pSizeData;
+		int Render = pCursor->m_Flags&TEXTFLAG_RENDER;
 
 		// set length
 		if(Length < 0)
 			Length = str_length(pText);
 
-		// if we don't want to render, we can just skip the first outline pass
-		i = 1;
-		if(pCursor->m_Flags&TEXTFLAG_RENDER)
-			i = 0;
+		m_CurrentTime = time_get();
 
-		for(;i < 2; i++)
+		// text from a fresh cursor lays out the same wherever it starts, so the run can be reused
+		CTextCacheEntry *pEntry = 0;
+		if(Length <= MAX_CACHED_TEXT_LENGTH && pCursor->m_X == pCursor->m_StartX && pCursor->m_Y == pCursor->m_StartY)
 		{
-			const char *pCurrent = (char *)pText;
-			const char *pEnd = pCurrent+Length;
-			DrawX = CursorX;
-			DrawY = CursorY;
-			LineCount = pCursor->m_LineCount;
-
-			if(pCursor->m_Flags&TEXTFLAG_RENDER)
-			{
-				// TODO: Make this better
-				if (i == 0)
-					Graphics()->TextureSet(pSizeData->m_aTextures[1]);
-				else
-					Graphics()->TextureSet(pSizeData->m_aTextures[0]);
-
-				Graphics()->QuadsBegin();
-				if (i == 0)
-					Graphics()->SetColor(m_TextOutlineR, m_TextOutlineG, m_TextOutlineB, m_TextOutlineA*m_TextA);
-				else
-					Graphics()->SetColor(m_TextR, m_TextG, m_TextB, m_TextA);
-			}
+			// line breaks are checked against the unaligned start
+			float SubPixelX = pCursor->m_LineWidth > 0 ? pCursor->m_X-Layout.m_CursorX : 0.0f;
+			unsigned Hash = TextHash(pText, Length, Layout.m_ActualSize, pCursor->m_Flags);
 
-			while(pCurrent < pEnd && (pCursor->m_MaxLines < 1 || LineCount <= pCursor->m_MaxLines))
+			pEntry = FindCachedText(Hash, pCursor, &Layout, SubPixelX, pText, Length);
+			if(pEntry && (!Render || pEntry->m_Generation == pSizeData->m_Generation))
 			{
-				int NewLine = 0;
-				const char *pBatchEnd = pEnd;
-				if(pCursor->m_LineWidth > 0 && !(pCursor->m_Flags&TEXTFLAG_STOP_AT_END))
+				if(Render)
 				{
-					int Wlen = min(WordLength((char *)pCurrent), (int)(pEnd-pCurrent));
-					CTextCursor Compare = *pCursor;
-					Compare.m_X = DrawX;
-					Compare.m_Y = DrawY;
-					Compare.m_Flags &= ~TEXTFLAG_RENDER;
-					Compare.m_LineWidth = -1;
-					TextEx(&Compare, pCurrent, Wlen);
-
-					if(Compare.m_X-DrawX > pCursor->m_LineWidth)
+					EnsureQuads(pEntry->m_NumQuads);
+					for(int i = 0; i < pEntry->m_NumQuads; i++)
+						TouchChar(pSizeData, pEntry->m_pGlyphs[i]);
+					for(int i = 0; i < pEntry->m_NumQuads*4; i++)
 					{
-						// word can't be fitted in one line, cut it
-						CTextCursor Cutter = *pCursor;
-						Cutter.m_CharCount = 0;
-						Cutter.m_X = DrawX;
-						Cutter.m_Y = DrawY;
-						Cutter.m_Flags &= ~TEXTFLAG_RENDER;
-						Cutter.m_Flags |= TEXTFLAG_STOP_AT_END;
-
-						TextEx(&Cutter, (const char *)pCurrent, Wlen);
-						Wlen = Cutter.m_CharCount;
-						NewLine = 1;
-
-						if(Wlen <= 3) // if we can't place 3 chars of the word on this line, take the next
-							Wlen = 0;
+						m_pQuads[i] = pEntry->m_pVertices[i];
+						m_pQuads[i].m_X += Layout.m_CursorX;
+						m_pQuads[i].m_Y += Layout.m_CursorY;
 					}
-					else if(Compare.m_X-pCursor->m_StartX > pCursor->m_LineWidth)
-					{
-						NewLine = 1;
-						Wlen = 0;
-					}
-
-					pBatchEnd = pCurrent + Wlen;
+					RenderQuads(pSizeData, m_pQuads, pEntry->m_NumQuads);
 				}
 
-				const char *pTmp = pCurrent;
-				int NextCharacter = str_utf8_decode(&pTmp);
-				while(pCurrent < pBatchEnd)
-				{
-					int Character = NextCharacter;
-					pCurrent = pTmp;
-					NextCharacter = str_utf8_decode(&pTmp);
+				pCursor->m_X = Layout.m_CursorX + pEntry->m_EndX;
+				pCursor->m_LineCount = pEntry->m_EndLineCount;
+				pCursor->m_CharCount += pEntry->m_NumChars;
+				if(pEntry->m_GotNewLine)
+					pCursor->m_Y = Layout.m_CursorY + pEntry->m_EndY;
+				return;
+			}
 
-					if(Character == '\n')
-					{
-						DrawX = pCursor->m_StartX;
-						DrawY += Size;
-						DrawX = (int)(DrawX * FakeToScreenX) / FakeToScreenX; // realign
-						DrawY = (int)(DrawY * FakeToScreenY) / FakeToScreenY;
-						++LineCount;
-						if(pCursor->m_MaxLines > 0 && LineCount > pCursor->m_MaxLines)
-							break;
-						continue;
-					}
+			if(!pEntry)
+				pEntry = NewCachedText(Hash, pCursor, &Layout, SubPixelX, pText, Length);
+		}
 
-					CFontChar *pChr = GetChar(pFont, pSizeData, Character);
-					if(pChr)
-					{
-						float Advance = pChr->m_AdvanceX + Kerning(pFont, Character, NextCharacter)*Scale;
-						if(pCursor->m_Flags&TEXTFLAG_STOP_AT_END && DrawX+Advance*Size-pCursor->m_StartX > pCursor->m_LineWidth)
-						{
-							// we hit the end of the line, no more to render or count
-							pCurrent = pEnd;
-							break;
-						}
+		// glyphs evicted while laying out leave the run stale right away
+		int Generation = pSizeData->m_Generation;
+		int CharCount = pCursor->m_CharCount;
 
-						if(pCursor->m_Flags&TEXTFLAG_RENDER)
-						{
-							Graphics()->QuadsSetSubset(pChr->m_aUvs[0], pChr->m_aUvs[1], pChr->m_aUvs[2], pChr->m_aUvs[3]);
-							IGraphics::CQuadItem QuadItem(DrawX+pChr->m_OffsetX*Size, DrawY+pChr->m_OffsetY*Size, pChr->m_Width*Size, pChr->m_Height*Size);
-							Graphics()->QuadsDrawTL(&QuadItem, 1);
-						}
+		m_NumQuads = 0;
+		int GotNewLine = TextLayout(pCursor, pText, Length, &Layout);
 
-						DrawX += Advance*Size;
-						pCursor->m_CharCount++;
-					}
-				}
+		if(Render)
+			RenderQuads(pSizeData, m_pQuads, m_NumQuads);
 
-				if(NewLine)
-				{
-					DrawX = pCursor->m_StartX;
-					DrawY += Size;
-					GotNewLine = 1;
-					DrawX = (int)(DrawX * FakeToScreenX) / FakeToScreenX; // realign
-					DrawY = (int)(DrawY * FakeToScreenY) / FakeToScreenY;
-					++LineCount;
-				}
+		if(pEntry)
+		{
+			if(pEntry->m_MaxQuads < m_NumQuads)
+			{
+				mem_free(pEntry->m_pVertices);
+				mem_free(pEntry->m_pGlyphs);
+				pEntry->m_MaxQuads = m_NumQuads;
+				pEntry->m_pVertices = (IGraphics::CQuadVertex *)mem_alloc(m_NumQuads*4*sizeof(IGraphics::CQuadVertex), 1);
+				pEntry->m_pGlyphs = (int *)mem_alloc(m_NumQuads*sizeof(int), 1);
 			}
 
-			if(pCursor->m_Flags&TEXTFLAG_RENDER)
-				Graphics()->QuadsEnd();
+			for(int i = 0; i < m_NumQuads*4; i++)
+			{
+				pEntry->m_pVertices[i] = m_pQuads[i];
+				pEntry->m_pVertices[i].m_X -= Layout.m_CursorX;
+				pEntry->m_pVertices[i].m_Y -= Layout.m_CursorY;
+			}
+			if(m_NumQuads)
+				mem_copy(pEntry->m_pGlyphs, m_pQuadGlyphs, m_NumQuads*sizeof(int));
+			pEntry->m_NumQuads = m_NumQuads;
+
+			pEntry->m_Generation = Generation;
+			pEntry->m_EndX = pCursor->m_X - Layout.m_CursorX;
+			pEntry->m_EndY = pCursor->m_Y - Layout.m_CursorY;
+			pEntry->m_GotNewLine = GotNewLine;
+			pEntry->m_EndLineCount = pCursor->m_LineCount;
+			pEntry->m_NumChars = pCursor->m_CharCount - CharCount;
 		}
-
-		pCursor->m_X = DrawX;
-		pCursor->m_LineCount = LineCount;
-
-		if(GotNewLine)
-			pCursor->m_Y = DrawY;
 	}
 
 };
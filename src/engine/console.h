@@ -59,6 +59,13 @@ public:
 		int GetAccessLevel() const { return m_AccessLevel; }
 	};
 
+	// a command line that got parsed once and can be executed again without parsing it, free it with delete
+	class ICompiledLine
+	{
+	public:
+		virtual ~ICompiledLine() {}
+	};
+
 	typedef void (*FPrintCallback)(const char *pStr, void *pUser);
 	typedef void (*FPossibleCallback)(const char *pCmd, void *pUser);
 	typedef void (*FCommandCallback)(IResult *pResult, void *pUserData);
@@ -82,6 +89,10 @@ public:
 	virtual void ExecuteLineStroked(int Stroke, const char *pStr) = 0;
 	virtual void ExecuteFile(const char *pFilename) = 0;
 
+	// returns 0 if the line contains unknown, temporary or stroke commands or invalid arguments
+	virtual ICompiledLine *CompileLine(const char *pStr) = 0;
+	virtual void ExecuteCompiled(ICompiledLine *pLine) = 0;
+
 	virtual int RegisterPrintCallback(int OutputLevel, FPrintCallback pfnPrintCallback, void *pUserData) = 0;
 	virtual void SetPrintOutputLevel(int Index, int OutputLevel) = 0;
 	virtual void Print(int Level, const char *pFrom, const char *pStr) = 0;
@@ -120,6 +120,16 @@ public:
 			: m_X0(x0), m_Y0(y0), m_X1(x1), m_Y1(y1), m_X2(x2), m_Y2(y2), m_X3(x3), m_Y3(y3) {}
 	};
 	virtual void QuadsDrawFreeform(const CFreeformItem *pArray, int Num) = 0;
+
+	struct CQuadVertex
+	{
+		float m_X, m_Y, m_U, m_V;
+		CQuadVertex() {}
+		CQuadVertex(float x, float y, float u, float v) : m_X(x), m_Y(y), m_U(u), m_V(v) {}
+	};
+	// draws prebuilt quads, four corners each (top left, top right, bottom right, bottom left)
+	// with their own texture coordinates. uses the current color, rotation is ignored
+	virtual void QuadsDrawVertices(const CQuadVertex *pArray, int Num) = 0;
 	virtual void QuadsText(float x, float y, float Size, const char *pText) = 0;
 
 	struct CColorVertex
@@ -137,6 +147,13 @@ public:
 
 	virtual void Swap() = 0;
 
+	// recorders let another thread record drawing into their own command buffers, the
+	// recording is played back in place later on. returns 0 if this isn't supported
+	virtual IGraphics *CreateRecorder() = 0;
+	virtual void DestroyRecorder(IGraphics *pRecorder) = 0;
+	virtual void RecorderBegin(IGraphics *pRecorder) = 0;
+	virtual void RecorderPlay(IGraphics *pRecorder) = 0;
+
 	// syncronization
 	virtual void InsertSignal(class semaphore *pSemaphore) = 0;
 	virtual bool IsIdle() = 0;
@@ -66,6 +66,19 @@ public:
 
 	virtual void DemoRecorder_HandleAutoStart() = 0;
 	virtual bool DemoRecorder_IsRecording() = 0;
+
+	// events for the econ event stream, the meaning of the ids depends on the type
+	enum
+	{
+		EVENT_KILL=0, // victim, killer, weapon
+		EVENT_BOMBPASS, // new bomb, old bomb
+		EVENT_FUSE, // bomb
+		EVENT_ROUNDEND, // winner or -1, active players
+		EVENT_ENTER, // client, -, team
+		EVENT_DROP, // client
+		NUM_EVENTS
+	};
+	virtual void SendEvent(int Type, int ClientID, int OtherID = -1, int Value = 0) = 0;
 };
 
 class IGameServer : public IInterface
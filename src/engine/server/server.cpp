@@ -208,9 +208,8 @@ int CServerBan::BanExt(T *pBanPool, const typename T::CDataType *pData, int Seco
 
 		if(NetMatch(&Data, Server()->m_NetServer.ClientAddr(i)))
 		{
-			CNetHash NetHash(&Data);
 			char aBuf[256];
-			MakeBanInfo(pBanPool->Find(&Data, &NetHash), aBuf, sizeof(aBuf), MSGTYPE_PLAYER);
+			MakeBanInfo(pBanPool->Find(&Data), aBuf, sizeof(aBuf), MSGTYPE_PLAYER);
 			Server()->m_NetServer.Drop(i, aBuf);
 		}
 	}
@@ -285,6 +284,14 @@ CServer::CServer() : m_DemoRecorder(&m_SnapshotDelta)
 	m_RconClientID = IServer::RCON_CID_SERV;
 	m_RconAuthLevel = AUTHED_ADMIN;
 
+	m_EventProduce = 0;
+	m_EventConsume = 0;
+	m_NumDroppedEvents = 0;
+
+	m_ServerInfoSize = 0;
+	m_ServerInfoChanged = true;
+	mem_zero(m_aServerInfoState, sizeof(m_aServerInfoState));
+
 	Init();
 }
 
@@ -320,6 +327,7 @@ int CServer::TrySetClientName(int ClientID, const char *pName)
 
 	// set the client name
 	str_copy(m_aClients[ClientID].m_aName, pName, MAX_NAME_LENGTH);
+	m_ServerInfoChanged = true;
 	return 0;
 }
 
@@ -362,6 +370,7 @@ void CServer::SetClientClan(int ClientID, const char *pClan)
 		return;
 
 	str_copy(m_aClients[ClientID].m_aClan, pClan, MAX_CLAN_LENGTH);
+	m_ServerInfoChanged = true;
 }
 
 void CServer::SetClientCountry(int ClientID, int Country)
@@ -370,13 +379,18 @@ void CServer::SetClientCountry(int ClientID, int Country)
 		return;
 
 	m_aClients[ClientID].m_Country = Country;
+	m_ServerInfoChanged = true;
 }
 
 void CServer::SetClientScore(int ClientID, int Score)
 {
 	if(ClientID < 0 || ClientID >= MAX_CLIENTS || m_aClients[ClientID].m_State < CClient::STATE_READY)
 		return;
-	m_aClients[ClientID].m_Score = Score;
+	if(m_aClients[ClientID].m_Score != Score)
+	{
+		m_aClients[ClientID].m_Score = Score;
+		m_ServerInfoChanged = true;
+	}
 }
 
 void CServer::Kick(int ClientID, const char *pReason)
@@ -1074,9 +1088,8 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 	}
 }
 
-void CServer::SendServerInfo(const NETADDR *pAddr, int Token)
+void CServer::PackServerInfo()
 {
-	CNetChunk Packet;
 	CPacker p;
 	char aBuf[128];
 
@@ -1095,10 +1108,6 @@ void CServer::SendServerInfo(const NETADDR *pAddr, int Token)
 
 	p.Reset();
 
-	p.AddRaw(SERVERBROWSE_INFO, sizeof(SERVERBROWSE_INFO));
-	str_format(aBuf, sizeof(aBuf), "%d", Token);
-	p.AddString(aBuf, 6);
-
 	p.AddString(GameServer()->Version(), 32);
 	p.AddString(g_Config.m_SvName, 64);
 	p.AddString(GetMapName(), 32);
@@ -1130,6 +1139,44 @@ void CServer::SendServerInfo(const NETADDR *pAddr, int Token)
 		}
 	}
 
+	m_ServerInfoSize = min(p.Size(), (int)sizeof(m_aServerInfo));
+	mem_copy(m_aServerInfo, p.Data(), m_ServerInfoSize);
+	m_ServerInfoChanged = false;
+}
+
+void CServer::SendServerInfo(const NETADDR *pAddr, int Token)
+{
+	CNetChunk Packet;
+	CPacker p;
+	char aBuf[128];
+
+	// joins, leaves and team changes don't go through the engine and the game
+	// sets the spectator slots directly, so check for them here
+	int aState[4] = {0, 0, 0, g_Config.m_SvSpectatorSlots};
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(m_aClients[i].m_State != CClient::STATE_EMPTY)
+		{
+			aState[0] |= 1<<i;
+			if(m_aClients[i].m_State == CClient::STATE_INGAME)
+				aState[1] |= 1<<i;
+			if(GameServer()->IsClientPlayer(i))
+				aState[2] |= 1<<i;
+		}
+	}
+	if(m_ServerInfoChanged || mem_comp(aState, m_aServerInfoState, sizeof(aState)) != 0)
+	{
+		mem_copy(m_aServerInfoState, aState, sizeof(aState));
+		PackServerInfo();
+	}
+
+	p.Reset();
+
+	p.AddRaw(SERVERBROWSE_INFO, sizeof(SERVERBROWSE_INFO));
+	str_format(aBuf, sizeof(aBuf), "%d", Token);
+	p.AddString(aBuf, 6);
+	p.AddRaw(m_aServerInfo, m_ServerInfoSize);
+
 	Packet.m_ClientID = -1;
 	Packet.m_Address = *pAddr;
 	Packet.m_Flags = NETSENDFLAG_CONNLESS;
@@ -1140,6 +1187,7 @@ void CServer::SendServerInfo(const NETADDR *pAddr, int Token)
 
 void CServer::UpdateServerInfo()
 {
+	m_ServerInfoChanged = true;
 	for(int i = 0; i < MAX_CLIENTS; ++i)
 	{
 		if(m_aClients[i].m_State != CClient::STATE_EMPTY)
@@ -1148,6 +1196,109 @@ void CServer::UpdateServerInfo()
 }
 
 
+void CServer::SendEvent(int Type, int ClientID, int OtherID, int Value)
+{
+	// nobody listens, don't even queue it
+	if(!m_Econ.HasEventClients())
+		return;
+
+	if(m_EventProduce-m_EventConsume >= (unsigned)MAX_EVENTS)
+	{
+		m_NumDroppedEvents++;
+		return;
+	}
+
+	CEvent *pEvent = &m_aEvents[m_EventProduce%MAX_EVENTS];
+	pEvent->m_Type = Type;
+	pEvent->m_Tick = Tick();
+	pEvent->m_ClientID = ClientID;
+	pEvent->m_OtherID = OtherID;
+	pEvent->m_Value = Value;
+	str_copy(pEvent->m_aName, Type == EVENT_ENTER ? ClientName(ClientID) : "", sizeof(pEvent->m_aName));
+	m_EventProduce++;
+}
+
+static void JsonEscape(char *pDst, int DstSize, const char *pSrc)
+{
+	static const char s_aHex[] = "0123456789abcdef";
+	int Pos = 0;
+	for(; *pSrc && Pos < DstSize-7; pSrc++)
+	{
+		unsigned char Char = *pSrc;
+		if(Char == '"' || Char == '\\')
+		{
+			pDst[Pos++] = '\\';
+			pDst[Pos++] = Char;
+		}
+		else if(Char < 0x20)
+		{
+			pDst[Pos++] = '\\';
+			pDst[Pos++] = 'u';
+			pDst[Pos++] = '0';
+			pDst[Pos++] = '0';
+			pDst[Pos++] = s_aHex[Char>>4];
+			pDst[Pos++] = s_aHex[Char&0xf];
+		}
+		else
+			pDst[Pos++] = Char;
+	}
+	pDst[Pos] = 0;
+}
+
+void CServer::FlushEvents()
+{
+	// the fields of each event type, null ones are left out
+	static const char *s_aapFields[NUM_EVENTS][4] = {
+		{"kill", "victim", "killer", "weapon"},
+		{"bomb_pass", "to", "from", 0},
+		{"fuse", "cid", 0, 0},
+		{"round_end", "winner", 0, "players"},
+		{"enter", "cid", 0, "team"},
+		{"drop", "cid", 0, 0},
+	};
+
+	char aBuf[256];
+	char aName[MAX_NAME_LENGTH*6];
+	char aField[64];
+
+	// let the listeners know when they missed something
+	if(m_NumDroppedEvents)
+	{
+		str_format(aBuf, sizeof(aBuf), "{\"event\":\"dropped\",\"tick\":%d,\"count\":%d}", Tick(), m_NumDroppedEvents);
+		m_Econ.SendEvent(aBuf);
+		m_NumDroppedEvents = 0;
+	}
+
+	while(m_EventConsume != m_EventProduce)
+	{
+		const CEvent *pEvent = &m_aEvents[m_EventConsume%MAX_EVENTS];
+		const char **ppFields = s_aapFields[pEvent->m_Type];
+
+		str_format(aBuf, sizeof(aBuf), "{\"event\":\"%s\",\"tick\":%d,\"%s\":%d", ppFields[0], pEvent->m_Tick, ppFields[1], pEvent->m_ClientID);
+		if(ppFields[2])
+		{
+			str_format(aField, sizeof(aField), ",\"%s\":%d", ppFields[2], pEvent->m_OtherID);
+			str_append(aBuf, aField, sizeof(aBuf));
+		}
+		if(ppFields[3])
+		{
+			str_format(aField, sizeof(aField), ",\"%s\":%d", ppFields[3], pEvent->m_Value);
+			str_append(aBuf, aField, sizeof(aBuf));
+		}
+		if(pEvent->m_Type == EVENT_ENTER)
+		{
+			JsonEscape(aName, sizeof(aName), pEvent->m_aName);
+			str_append(aBuf, ",\"name\":\"", sizeof(aBuf));
+			str_append(aBuf, aName, sizeof(aBuf));
+			str_append(aBuf, "\"", sizeof(aBuf));
+		}
+		str_append(aBuf, "}", sizeof(aBuf));
+
+		m_Econ.SendEvent(aBuf);
+		m_EventConsume++;
+	}
+}
+
 void CServer::PumpNetwork()
 {
 	CNetChunk Packet;
@@ -1174,6 +1325,7 @@ void CServer::PumpNetwork()
 	}
 
 	m_ServerBan.Update();
+	FlushEvents();
 	m_Econ.Update();
 }
 
@@ -1276,6 +1428,7 @@ int CServer::Run()
 	}
 
 	m_NetServer.SetCallbacks(NewClientCallback, DelClientCallback, this);
+	m_NetServer.SetRateLimits(g_Config.m_SvRateLimitConnect, g_Config.m_SvRateLimitInfo, g_Config.m_SvRateLimitSession);
 
 	m_Econ.Init(Console(), &m_ServerBan);
 
@@ -1341,6 +1494,7 @@ int CServer::Run()
 					str_format(aBuf, sizeof(aBuf), "failed to load map. mapname='%s'", g_Config.m_SvMap);
 					Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 					str_copy(g_Config.m_SvMap, m_aCurrentMap, sizeof(g_Config.m_SvMap));
+					m_ServerInfoChanged = true;
 				}
 			}
 
@@ -1465,6 +1619,34 @@ void CServer::ConStatus(IConsole::IResult *pResult, void *pUser)
 	}
 }
 
+void CServer::ConRateLimitStatus(IConsole::IResult *pResult, void *pUser)
+{
+	static const char *s_apTypeNames[CNetRateLimit::NUM_TYPES] = { "connect", "info", "session" };
+
+	CServer* pThis = static_cast<CServer *>(pUser);
+	const CNetRateLimit *pRateLimit = pThis->m_NetServer.RateLimit();
+	char aBuf[256];
+
+	for(int i = 0; i < CNetRateLimit::NUM_TYPES; i++)
+	{
+		str_format(aBuf, sizeof(aBuf), "%s: limit=%d/s allowed=%lld dropped=%lld", s_apTypeNames[i], pRateLimit->Rate(i),
+			pRateLimit->NumAllowed(i), pRateLimit->NumDropped(i));
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "Server", aBuf);
+	}
+	str_format(aBuf, sizeof(aBuf), "%d addresses tracked, %lld evicted", pRateLimit->NumAddresses(), pRateLimit->NumEvicted());
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "Server", aBuf);
+
+	CNetRateLimit::CSource aSources[5];
+	int NumSources = pRateLimit->GetTopSources(aSources, 5);
+	for(int i = 0; i < NumSources; i++)
+	{
+		char aAddrStr[NETADDR_MAXSTRSIZE];
+		net_addr_str(&aSources[i].m_Addr, aAddrStr, sizeof(aAddrStr), false);
+		str_format(aBuf, sizeof(aBuf), "addr=%s dropped=%lld", aAddrStr, aSources[i].m_NumDropped);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "Server", aBuf);
+	}
+}
+
 void CServer::ConShutdown(IConsole::IResult *pResult, void *pUser)
 {
 	((CServer *)pUser)->m_RunServer = 0;
@@ -1542,6 +1724,13 @@ void CServer::ConLogout(IConsole::IResult *pResult, void *pUser)
 	}
 }
 
+void CServer::ConchainServerInfoChange(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	pfnCallback(pResult, pCallbackUserData);
+	if(pResult->NumArguments())
+		((CServer *)pUserData)->m_ServerInfoChanged = true;
+}
+
 void CServer::ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
 	pfnCallback(pResult, pCallbackUserData);
@@ -1556,6 +1745,13 @@ void CServer::ConchainMaxclientsperipUpdate(IConsole::IResult *pResult, void *pU
 		((CServer *)pUserData)->m_NetServer.SetMaxClientsPerIP(pResult->GetInteger(0));
 }
 
+void CServer::ConchainRateLimitUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	pfnCallback(pResult, pCallbackUserData);
+	if(pResult->NumArguments())
+		((CServer *)pUserData)->m_NetServer.SetRateLimits(g_Config.m_SvRateLimitConnect, g_Config.m_SvRateLimitInfo, g_Config.m_SvRateLimitSession);
+}
+
 void CServer::ConchainModCommandUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
 	if(pResult->NumArguments() == 2)
@@ -1605,6 +1801,7 @@ void CServer::RegisterCommands()
 	// register console commands
 	Console()->Register("kick", "i?r", CFGFLAG_SERVER, ConKick, this, "Kick player with specified id for any reason");
 	Console()->Register("status", "", CFGFLAG_SERVER, ConStatus, this, "List players");
+	Console()->Register("ratelimit_status", "", CFGFLAG_SERVER, ConRateLimitStatus, this, "Show packets dropped by the rate limits");
 	Console()->Register("shutdown", "", CFGFLAG_SERVER, ConShutdown, this, "Shut down");
 	Console()->Register("logout", "", CFGFLAG_SERVER, ConLogout, this, "Logout of rcon");
 
@@ -1615,8 +1812,12 @@ void CServer::RegisterCommands()
 
 	Console()->Chain("sv_name", ConchainSpecialInfoupdate, this);
 	Console()->Chain("password", ConchainSpecialInfoupdate, this);
+	Console()->Chain("sv_map", ConchainServerInfoChange, this);
 
 	Console()->Chain("sv_max_clients_per_ip", ConchainMaxclientsperipUpdate, this);
+	Console()->Chain("sv_ratelimit_connect", ConchainRateLimitUpdate, this);
+	Console()->Chain("sv_ratelimit_info", ConchainRateLimitUpdate, this);
+	Console()->Chain("sv_ratelimit_session", ConchainRateLimitUpdate, this);
 	Console()->Chain("mod_command", ConchainModCommandUpdate, this);
 	Console()->Chain("console_output_level", ConchainConsoleOutputLevelUpdate, this);
 
@@ -154,6 +154,31 @@ public:
 	unsigned char *m_pCurrentMapData;
 	int m_CurrentMapSize;
 
+	// game events waiting for the econ event stream, queued by the tick and sent by PumpNetwork
+	enum
+	{
+		MAX_EVENTS=1024,
+	};
+	struct CEvent
+	{
+		int m_Type;
+		int m_Tick;
+		int m_ClientID;
+		int m_OtherID;
+		int m_Value;
+		char m_aName[MAX_NAME_LENGTH]; // of ClientID when it was sent, the slot can be reused before the flush
+	};
+	CEvent m_aEvents[MAX_EVENTS];
+	unsigned m_EventProduce;
+	unsigned m_EventConsume;
+	int m_NumDroppedEvents;
+
+	// everything of the info response after the token
+	char m_aServerInfo[NET_MAX_PAYLOAD];
+	int m_ServerInfoSize;
+	bool m_ServerInfoChanged;
+	int m_aServerInfoState[4]; // client, ingame and player masks and spectator slots the info was packed with
+
 	CDemoRecorder m_DemoRecorder;
 	CRegister m_Register;
 	CMapChecker m_MapChecker;
@@ -207,9 +232,13 @@ public:
 
 	void ProcessClientPacket(CNetChunk *pPacket);
 
+	void PackServerInfo();
 	void SendServerInfo(const NETADDR *pAddr, int Token);
 	void UpdateServerInfo();
 
+	virtual void SendEvent(int Type, int ClientID, int OtherID, int Value);
+	void FlushEvents();
+
 	void PumpNetwork();
 
 	char *GetMapName();
@@ -220,13 +249,16 @@ public:
 
 	static void ConKick(IConsole::IResult *pResult, void *pUser);
 	static void ConStatus(IConsole::IResult *pResult, void *pUser);
+	static void ConRateLimitStatus(IConsole::IResult *pResult, void *pUser);
 	static void ConShutdown(IConsole::IResult *pResult, void *pUser);
 	static void ConRecord(IConsole::IResult *pResult, void *pUser);
 	static void ConStopRecord(IConsole::IResult *pResult, void *pUser);
 	static void ConMapReload(IConsole::IResult *pResult, void *pUser);
 	static void ConLogout(IConsole::IResult *pResult, void *pUser);
+	static void ConchainServerInfoChange(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainMaxclientsperipUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
+	static void ConchainRateLimitUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainModCommandUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainConsoleOutputLevelUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 
@@ -35,6 +35,68 @@ float CConsole::CResult::GetFloat(unsigned Index)
 	return str_tofloat(m_apArgs[Index]);
 }
 
+CConsole::CCompiledResult::CCompiledResult(CCommand *pCommand, const CResult *pResult) : IResult()
+{
+	m_pNext = 0;
+	m_pCommand = pCommand;
+
+	// keep the command name and the parsed arguments, everything after the last argument is unused
+	int End = str_length(pResult->m_pCommand)+1;
+	for(int i = 0; i < pResult->NumArguments(); i++)
+		End = max(End, (int)(pResult->m_apArgs[i]-pResult->m_pCommand)+str_length(pResult->m_apArgs[i])+1);
+
+	m_StorageSize = End;
+	m_pStorage = (char *)mem_alloc(m_StorageSize, 1);
+	mem_copy(m_pStorage, pResult->m_pCommand, m_StorageSize);
+
+	m_NumArgs = pResult->NumArguments();
+	m_ppArgs = 0;
+	if(m_NumArgs)
+	{
+		m_ppArgs = (const char **)mem_alloc(m_NumArgs*sizeof(const char *), sizeof(void*));
+		for(unsigned i = 0; i < m_NumArgs; i++)
+			m_ppArgs[i] = m_pStorage+(pResult->m_apArgs[i]-pResult->m_pCommand);
+	}
+}
+
+CConsole::CCompiledResult::~CCompiledResult()
+{
+	mem_free(m_pStorage);
+	if(m_ppArgs)
+		mem_free(m_ppArgs);
+}
+
+const char *CConsole::CCompiledResult::GetString(unsigned Index)
+{
+	if (Index >= m_NumArgs)
+		return "";
+	return m_ppArgs[Index];
+}
+
+int CConsole::CCompiledResult::GetInteger(unsigned Index)
+{
+	if (Index >= m_NumArgs)
+		return 0;
+	return str_toint(m_ppArgs[Index]);
+}
+
+float CConsole::CCompiledResult::GetFloat(unsigned Index)
+{
+	if (Index >= m_NumArgs)
+		return 0.0f;
+	return str_tofloat(m_ppArgs[Index]);
+}
+
+CConsole::CCompiledLine::~CCompiledLine()
+{
+	while(m_pFirst)
+	{
+		CCompiledResult *pNext = m_pFirst->m_pNext;
+		delete m_pFirst;
+		m_pFirst = pNext;
+	}
+}
+
 const IConsole::CCommandInfo *CConsole::CCommand::NextCommandInfo(int AccessLevel, int FlagMask) const
 {
 	const CCommand *pInfo = m_pNext;
@@ -60,6 +122,36 @@ const IConsole::CCommandInfo *CConsole::FirstCommandInfo(int AccessLevel, int Fl
 
 // the maximum number of tokens occurs in a string of length CONSOLE_MAX_STR_LENGTH with tokens size 1 separated by single spaces
 
+const char *CConsole::FindPartEnd(const char *pStr, const char **ppNextPart)
+{
+	int InString = 0;
+	*ppNextPart = 0;
+
+	while(*pStr)
+	{
+		if(*pStr == '"')
+			InString ^= 1;
+		else if(*pStr == '\\') // escape sequences
+		{
+			if(pStr[1] == '"')
+				pStr++;
+		}
+		else if(!InString)
+		{
+			if(*pStr == ';') // command separator
+			{
+				*ppNextPart = pStr+1;
+				break;
+			}
+			else if(*pStr == '#') // comment, no need to do anything more
+				break;
+		}
+
+		pStr++;
+	}
+
+	return pStr;
+}
 
 int CConsole::ParseStart(CResult *pResult, const char *pString, int Length)
 {
@@ -214,32 +306,8 @@ bool CConsole::LineIsValid(const char *pStr)
 	do
 	{
 		CResult Result;
-		const char *pEnd = pStr;
-		const char *pNextPart = 0;
-		int InString = 0;
-
-		while(*pEnd)
-		{
-			if(*pEnd == '"')
-				InString ^= 1;
-			else if(*pEnd == '\\') // escape sequences
-			{
-				if(pEnd[1] == '"')
-					pEnd++;
-			}
-			else if(!InString)
-			{
-				if(*pEnd == ';') // command separator
-				{
-					pNextPart = pEnd+1;
-					break;
-				}
-				else if(*pEnd == '#') // comment, no need to do anything more
-					break;
-			}
-
-			pEnd++;
-		}
+		const char *pNextPart;
+		const char *pEnd = FindPartEnd(pStr, &pNextPart);
 
 		if(ParseStart(&Result, pStr, (pEnd-pStr) + 1) != 0)
 			return false;
@@ -260,32 +328,8 @@ void CConsole::ExecuteLineStroked(int Stroke, const char *pStr)
 	while(pStr && *pStr)
 	{
 		CResult Result;
-		const char *pEnd = pStr;
-		const char *pNextPart = 0;
-		int InString = 0;
-
-		while(*pEnd)
-		{
-			if(*pEnd == '"')
-				InString ^= 1;
-			else if(*pEnd == '\\') // escape sequences
-			{
-				if(pEnd[1] == '"')
-					pEnd++;
-			}
-			else if(!InString)
-			{
-				if(*pEnd == ';') // command separator
-				{
-					pNextPart = pEnd+1;
-					break;
-				}
-				else if(*pEnd == '#') // comment, no need to do anything more
-					break;
-			}
-
-			pEnd++;
-		}
+		const char *pNextPart;
+		const char *pEnd = FindPartEnd(pStr, &pNextPart);
 
 		if(ParseStart(&Result, pStr, (pEnd-pStr) + 1) != 0)
 			return;
@@ -305,6 +349,7 @@ void CConsole::ExecuteLineStroked(int Stroke, const char *pStr)
 					// insert the stroke direction token
 					Result.AddArgument(m_paStrokeStr[Stroke]);
 					IsStrokeCommand = 1;
+					m_StrokeCommandSeen = true;
 				}
 
 				if(Stroke || IsStrokeCommand)
@@ -322,7 +367,7 @@ void CConsole::ExecuteLineStroked(int Stroke, const char *pStr)
 						m_ExecutionQueue.m_pLast->m_pCommandUserData = pCommand->m_pUserData;
 						m_ExecutionQueue.m_pLast->m_Result = Result;
 					}
-					else
+					else if(!DeferChain(pCommand, &Result))
 						pCommand->m_pfnCallback(&Result, pCommand->m_pUserData);
 				}
 			}
@@ -356,9 +401,18 @@ void CConsole::PossibleCommands(const char *pStr, int FlagMask, bool Temp, FPoss
 	}
 }
 
+unsigned CConsole::CommandHash(const char *pName)
+{
+	// case insensitive, commands are compared with str_comp_nocase
+	unsigned Hash = 5381;
+	for(; *pName; pName++)
+		Hash = ((Hash << 5) + Hash) + str_uppercase(*pName);
+	return Hash%COMMAND_HASH_SIZE;
+}
+
 CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	for(CCommand *pCommand = m_apCommandHash[CommandHash(pName)]; pCommand; pCommand = pCommand->m_pHashNext)
 	{
 		if(pCommand->m_Flags&FlagMask)
 		{
@@ -372,8 +426,13 @@ CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 
 void CConsole::ExecuteLine(const char *pStr)
 {
+	// the release only does something for stroke commands, don't parse the line again without them
+	bool StrokeCommandSeen = m_StrokeCommandSeen;
+	m_StrokeCommandSeen = false;
 	CConsole::ExecuteLineStroked(1, pStr); // press it
-	CConsole::ExecuteLineStroked(0, pStr); // then release it
+	if(m_StrokeCommandSeen)
+		CConsole::ExecuteLineStroked(0, pStr); // then release it
+	m_StrokeCommandSeen = StrokeCommandSeen;
 }
 
 void CConsole::ExecuteLineFlag(const char *pStr, int FlagMask)
@@ -384,6 +443,95 @@ void CConsole::ExecuteLineFlag(const char *pStr, int FlagMask)
 	m_FlagMask = Temp;
 }
 
+IConsole::ICompiledLine *CConsole::CompileLine(const char *pStr)
+{
+	CCompiledLine *pLine = new CCompiledLine();
+
+	while(pStr && *pStr)
+	{
+		CResult Result;
+		const char *pNextPart;
+		const char *pEnd = FindPartEnd(pStr, &pNextPart);
+
+		if(ParseStart(&Result, pStr, (pEnd-pStr) + 1) != 0 || !*Result.m_pCommand)
+			break;
+
+		// temporary commands can be removed and stroke commands need the stroke direction, don't keep them
+		CCommand *pCommand = FindCommand(Result.m_pCommand, m_FlagMask);
+		if(!pCommand || pCommand->m_Temp || Result.m_pCommand[0] == '+' || ParseArgs(&Result, pCommand->m_pParams))
+		{
+			delete pLine;
+			return 0;
+		}
+
+		CCompiledResult *pPart = new CCompiledResult(pCommand, &Result);
+		if(pLine->m_pLast)
+			pLine->m_pLast->m_pNext = pPart;
+		else
+			pLine->m_pFirst = pPart;
+		pLine->m_pLast = pPart;
+
+		pStr = pNextPart;
+	}
+
+	return pLine;
+}
+
+void CConsole::ExecuteCompiled(ICompiledLine *pLine)
+{
+	for(CCompiledResult *pPart = static_cast<CCompiledLine *>(pLine)->m_pFirst; pPart; pPart = pPart->m_pNext)
+	{
+		CCommand *pCommand = pPart->m_pCommand;
+		char aBuf[256];
+		if(!(pCommand->m_Flags&m_FlagMask))
+		{
+			str_format(aBuf, sizeof(aBuf), "No such command: %s.", pCommand->m_pName);
+			Print(OUTPUT_LEVEL_STANDARD, "Console", aBuf);
+		}
+		else if(pCommand->GetAccessLevel() < m_AccessLevel)
+		{
+			str_format(aBuf, sizeof(aBuf), "Access for command %s denied.", pCommand->m_pName);
+			Print(OUTPUT_LEVEL_STANDARD, "Console", aBuf);
+		}
+		else if(m_StoreCommands && pCommand->m_Flags&CFGFLAG_STORE)
+		{
+			m_ExecutionQueue.AddEntry();
+			m_ExecutionQueue.m_pLast->m_pfnCommandCallback = pCommand->m_pfnCallback;
+			m_ExecutionQueue.m_pLast->m_pCommandUserData = pCommand->m_pUserData;
+
+			// the arguments are parsed already, nothing is left after them
+			CResult *pResult = &m_ExecutionQueue.m_pLast->m_Result;
+			mem_copy(pResult->m_aStringStorage, pPart->m_pStorage, pPart->m_StorageSize);
+			pResult->m_pCommand = pResult->m_aStringStorage;
+			pResult->m_pArgsStart = pResult->m_aStringStorage+pPart->m_StorageSize-1;
+			for(int i = 0; i < pPart->NumArguments(); i++)
+				pResult->AddArgument(pResult->m_aStringStorage+(pPart->m_ppArgs[i]-pPart->m_pStorage));
+		}
+		else
+			pCommand->m_pfnCallback(pPart, pCommand->m_pUserData);
+	}
+}
+
+void CConsole::BeginBatch()
+{
+	m_BatchDepth++;
+}
+
+void CConsole::EndBatch()
+{
+	// chains run by the outermost batch only, deferred ones they cause get appended and run as well
+	if(m_BatchDepth == 1)
+	{
+		for(CExecutionQueue::CQueueEntry *pEntry = m_BatchQueue.m_pFirst; pEntry; pEntry = pEntry->m_pNext)
+		{
+			m_pBatchRun = pEntry;
+			pEntry->m_pfnCommandCallback(&pEntry->m_Result, pEntry->m_pCommandUserData);
+		}
+		m_BatchQueue.Reset();
+		m_pBatchRun = 0;
+	}
+	m_BatchDepth--;
+}
 
 void CConsole::ExecuteFile(const char *pFilename)
 {
@@ -417,8 +565,10 @@ void CConsole::ExecuteFile(const char *pFilename)
 		Print(IConsole::OUTPUT_LEVEL_STANDARD, "console", aBuf);
 		lr.Init(File);
 
+		BeginBatch();
 		while((pLine = lr.Get()))
 			ExecuteLine(pLine);
+		EndBatch();
 
 		io_close(File);
 	}
@@ -574,6 +724,33 @@ static void StrVariableCommand(IConsole::IResult *pResult, void *pUserData)
 	}
 }
 
+bool CConsole::DeferChain(CCommand *pCommand, CResult *pResult)
+{
+	if(!m_BatchDepth || pCommand->m_pfnCallback != Con_Chain || !pResult->NumArguments())
+		return false;
+
+	// only variables, they can be set right away and the chain sees the last value
+	CChain *pChainInfo = static_cast<CChain *>(pCommand->m_pUserData);
+	if(pChainInfo->m_pfnCallback != IntVariableCommand && pChainInfo->m_pfnCallback != StrVariableCommand)
+		return false;
+
+	pChainInfo->m_pfnCallback(pResult, pChainInfo->m_pCallbackUserData);
+
+	// entries that ran already don't count, the chain has to run again
+	CExecutionQueue::CQueueEntry *pEntry = m_pBatchRun ? m_pBatchRun->m_pNext : m_BatchQueue.m_pFirst;
+	while(pEntry && pEntry->m_pCommandUserData != pChainInfo)
+		pEntry = pEntry->m_pNext;
+	if(!pEntry)
+	{
+		m_BatchQueue.AddEntry();
+		pEntry = m_BatchQueue.m_pLast;
+		pEntry->m_pfnCommandCallback = Con_Chain;
+		pEntry->m_pCommandUserData = pChainInfo;
+	}
+	pEntry->m_Result = *pResult;
+	return true;
+}
+
 void CConsole::ConToggle(IConsole::IResult *pResult, void *pUser)
 {
 	CConsole* pConsole = static_cast<CConsole *>(pUser);
@@ -650,10 +827,15 @@ CConsole::CConsole(int FlagMask)
 	m_pRecycleList = 0;
 	m_TempCommands.Reset();
 	m_StoreCommands = true;
+	m_StrokeCommandSeen = false;
+	m_BatchDepth = 0;
 	m_paStrokeStr[0] = "0";
 	m_paStrokeStr[1] = "1";
 	m_ExecutionQueue.Reset();
+	m_BatchQueue.Reset();
+	m_pBatchRun = 0;
 	m_pFirstCommand = 0;
+	mem_zero(m_apCommandHash, sizeof(m_apCommandHash));
 	m_pFirstExec = 0;
 	mem_zero(m_aPrintCB, sizeof(m_aPrintCB));
 	m_NumPrintCB = 0;
@@ -691,6 +873,7 @@ CConsole::CConsole(int FlagMask)
 
 void CConsole::ParseArguments(int NumArgs, const char **ppArguments)
 {
+	BeginBatch();
 	for(int i = 0; i < NumArgs; i++)
 	{
 		// check for scripts to execute
@@ -711,6 +894,7 @@ void CConsole::ParseArguments(int NumArgs, const char **ppArguments)
 			ExecuteLine(ppArguments[i]);
 		}
 	}
+	EndBatch();
 }
 
 void CConsole::AddCommandSorted(CCommand *pCommand)
@@ -735,6 +919,20 @@ void CConsole::AddCommandSorted(CCommand *pCommand)
 			}
 		}
 	}
+
+	// newer commands come first like in the sorted list
+	unsigned Hash = CommandHash(pCommand->m_pName);
+	pCommand->m_pHashNext = m_apCommandHash[Hash];
+	m_apCommandHash[Hash] = pCommand;
+}
+
+void CConsole::RemoveCommandHash(CCommand *pCommand)
+{
+	CCommand **ppCommand = &m_apCommandHash[CommandHash(pCommand->m_pName)];
+	while(*ppCommand && *ppCommand != pCommand)
+		ppCommand = &(*ppCommand)->m_pHashNext;
+	if(*ppCommand)
+		*ppCommand = pCommand->m_pHashNext;
 }
 
 void CConsole::Register(const char *pName, const char *pParams,
@@ -822,6 +1020,7 @@ void CConsole::DeregisterTemp(const char *pName)
 	// add to recycle list
 	if(pRemoved)
 	{
+		RemoveCommandHash(pRemoved);
 		pRemoved->m_pNext = m_pRecycleList;
 		m_pRecycleList = pRemoved;
 	}
@@ -843,6 +1042,18 @@ void CConsole::DeregisterTempAll()
 		}
 	}
 
+	for(int i = 0; i < COMMAND_HASH_SIZE; i++)
+	{
+		CCommand **ppCommand = &m_apCommandHash[i];
+		while(*ppCommand)
+		{
+			if((*ppCommand)->m_Temp)
+				*ppCommand = (*ppCommand)->m_pHashNext;
+			else
+				ppCommand = &(*ppCommand)->m_pHashNext;
+		}
+	}
+
 	m_TempCommands.Reset();
 	m_pRecycleList = 0;
 }
@@ -892,7 +1103,7 @@ void CConsole::StoreCommands(bool Store)
 
 const IConsole::CCommandInfo *CConsole::GetCommandInfo(const char *pName, int FlagMask, bool Temp)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	for(CCommand *pCommand = m_apCommandHash[CommandHash(pName)]; pCommand; pCommand = pCommand->m_pHashNext)
 	{
 		if(pCommand->m_Flags&FlagMask && pCommand->m_Temp == Temp)
 		{
@@ -12,6 +12,7 @@ class CConsole : public IConsole
 	{
 	public:
 		CCommand *m_pNext;
+		CCommand *m_pHashNext;
 		int m_Flags;
 		bool m_Temp;
 		FCommandCallback m_pfnCallback;
@@ -32,10 +33,18 @@ class CConsole : public IConsole
 		void *m_pUserData;
 	};
 
+	enum
+	{
+		COMMAND_HASH_SIZE=1024,
+	};
+
 	int m_FlagMask;
 	bool m_StoreCommands;
+	bool m_StrokeCommandSeen;
+	int m_BatchDepth;
 	const char *m_paStrokeStr[2];
 	CCommand *m_pFirstCommand;
+	CCommand *m_apCommandHash[COMMAND_HASH_SIZE];
 
 	class CExecFile
 	{
@@ -62,6 +71,9 @@ class CConsole : public IConsole
 	void ExecuteFileRecurse(const char *pFilename);
 	void ExecuteLineStroked(int Stroke, const char *pStr);
 
+	void BeginBatch();
+	void EndBatch();
+
 	struct
 	{
 		int m_OutputLevel;
@@ -117,6 +129,34 @@ class CConsole : public IConsole
 		virtual float GetFloat(unsigned Index);
 	};
 
+	class CCompiledResult : public IResult
+	{
+	public:
+		CCompiledResult *m_pNext;
+		CCommand *m_pCommand;
+		char *m_pStorage;
+		int m_StorageSize;
+		const char **m_ppArgs;
+
+		CCompiledResult(CCommand *pCommand, const CResult *pResult);
+		virtual ~CCompiledResult();
+
+		virtual const char *GetString(unsigned Index);
+		virtual int GetInteger(unsigned Index);
+		virtual float GetFloat(unsigned Index);
+	};
+
+	class CCompiledLine : public ICompiledLine
+	{
+	public:
+		CCompiledResult *m_pFirst;
+		CCompiledResult *m_pLast;
+
+		CCompiledLine() : m_pFirst(0), m_pLast(0) {}
+		virtual ~CCompiledLine();
+	};
+
+	static const char *FindPartEnd(const char *pStr, const char **ppNextPart);
 	int ParseStart(CResult *pResult, const char *pString, int Length);
 	int ParseArgs(CResult *pResult, const char *pFormat);
 
@@ -151,7 +191,14 @@ class CConsole : public IConsole
 		}
 	} m_ExecutionQueue;
 
+	// chains of variables assigned during a batch, run once at its end
+	CExecutionQueue m_BatchQueue;
+	CExecutionQueue::CQueueEntry *m_pBatchRun; // last entry that ran while the queue gets executed
+	bool DeferChain(CCommand *pCommand, CResult *pResult);
+
+	static unsigned CommandHash(const char *pName);
 	void AddCommandSorted(CCommand *pCommand);
+	void RemoveCommandHash(CCommand *pCommand);
 	CCommand *FindCommand(const char *pName, int FlagMask);
 
 public:
@@ -174,6 +221,9 @@ public:
 	virtual void ExecuteLineFlag(const char *pStr, int FlagMask);
 	virtual void ExecuteFile(const char *pFilename);
 
+	virtual ICompiledLine *CompileLine(const char *pStr);
+	virtual void ExecuteCompiled(ICompiledLine *pLine);
+
 	virtual int RegisterPrintCallback(int OutputLevel, FPrintCallback pfnPrintCallback, void *pUserData);
 	virtual void SetPrintOutputLevel(int Index, int OutputLevel);
 	virtual void Print(int Level, const char *pFrom, const char *pStr);
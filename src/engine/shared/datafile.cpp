@@ -264,6 +264,16 @@ int CDataFileReader::GetDataSize(int Index)
 	return m_pDataFile->m_Info.m_pDataOffsets[Index+1]-m_pDataFile->m_Info.m_pDataOffsets[Index];
 }
 
+int CDataFileReader::GetUncompressedDataSize(int Index)
+{
+	if(!m_pDataFile) { return 0; }
+
+	// version 3 files store the data uncompressed
+	if(m_pDataFile->m_Header.m_Version == 4)
+		return m_pDataFile->m_Info.m_pDataSizes[Index];
+	return GetDataSize(Index);
+}
+
 void *CDataFileReader::GetDataImpl(int Index, int Swap)
 {
 	if(!m_pDataFile) { return 0; }
@@ -429,10 +439,12 @@ CDataFileWriter::CDataFileWriter()
 	m_pItemTypes = static_cast<CItemTypeInfo *>(mem_alloc(sizeof(CItemTypeInfo) * MAX_ITEM_TYPES, 1));
 	m_pItems = static_cast<CItemInfo *>(mem_alloc(sizeof(CItemInfo) * MAX_ITEMS, 1));
 	m_pDatas = static_cast<CDataInfo *>(mem_alloc(sizeof(CDataInfo) * MAX_DATAS, 1));
+	m_CompressionLock = lock_create();
 }
 
 CDataFileWriter::~CDataFileWriter()
 {
+	lock_destroy(m_CompressionLock);
 	mem_free(m_pItemTypes);
 	m_pItemTypes = 0;
 	mem_free(m_pItems);
@@ -441,7 +453,7 @@ CDataFileWriter::~CDataFileWriter()
 	m_pDatas = 0;
 }
 
-bool CDataFileWriter::Open(class IStorage *pStorage, const char *pFilename)
+bool CDataFileWriter::Open(class IStorage *pStorage, const char *pFilename, int CompressionLevel, int NumThreads)
 {
 	dbg_assert(!m_File, "a file already exists");
 	m_File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
@@ -451,6 +463,8 @@ bool CDataFileWriter::Open(class IStorage *pStorage, const char *pFilename)
 	m_NumItems = 0;
 	m_NumDatas = 0;
 	m_NumItemTypes = 0;
+	m_CompressionLevel = CompressionLevel < 0 ? Z_DEFAULT_COMPRESSION : min(CompressionLevel, (int)Z_BEST_COMPRESSION);
+	m_NumThreads = clamp(NumThreads, 1, (int)MAX_COMPRESSION_THREADS);
 	mem_zero(m_pItemTypes, sizeof(CItemTypeInfo) * MAX_ITEM_TYPES);
 
 	for(int i = 0; i < MAX_ITEM_TYPES; i++)
@@ -504,25 +518,54 @@ int CDataFileWriter::AddData(int Size, void *pData)
 
 	dbg_assert(m_NumDatas < 1024, "too much data");
 
+	// keep a copy, the data gets compressed when the file is finished
 	CDataInfo *pInfo = &m_pDatas[m_NumDatas];
-	unsigned long s = compressBound(Size);
+	pInfo->m_UncompressedSize = Size;
+	pInfo->m_pUncompressedData = mem_alloc(Size, 1);
+	mem_copy(pInfo->m_pUncompressedData, pData, Size);
+	pInfo->m_CompressedSize = 0;
+	pInfo->m_pCompressedData = 0;
+
+	m_NumDatas++;
+	return m_NumDatas-1;
+}
+
+void CDataFileWriter::CompressData(int Index)
+{
+	CDataInfo *pInfo = &m_pDatas[Index];
+	unsigned long s = compressBound(pInfo->m_UncompressedSize);
 	void *pCompData = mem_alloc(s, 1); // temporary buffer that we use during compression
 
-	int Result = compress((Bytef*)pCompData, &s, (Bytef*)pData, Size); // ignore_convention
+	int Result = compress2((Bytef*)pCompData, &s, (Bytef*)pInfo->m_pUncompressedData, pInfo->m_UncompressedSize, m_CompressionLevel); // ignore_convention
 	if(Result != Z_OK)
 	{
 		dbg_msg("datafile", "compression error %d", Result);
 		dbg_assert(0, "zlib error");
 	}
 
-	pInfo->m_UncompressedSize = Size;
 	pInfo->m_CompressedSize = (int)s;
 	pInfo->m_pCompressedData = mem_alloc(pInfo->m_CompressedSize, 1);
 	mem_copy(pInfo->m_pCompressedData, pCompData, pInfo->m_CompressedSize);
 	mem_free(pCompData);
+	mem_free(pInfo->m_pUncompressedData);
+	pInfo->m_pUncompressedData = 0;
+}
 
-	m_NumDatas++;
-	return m_NumDatas-1;
+void CDataFileWriter::CompressThread(void *pUser)
+{
+	CDataFileWriter *pSelf = (CDataFileWriter *)pUser;
+
+	while(1)
+	{
+		// fetch the next data block, results are stored by index so the output order does not depend on scheduling
+		lock_wait(pSelf->m_CompressionLock);
+		int Index = pSelf->m_NextCompressData++;
+		lock_release(pSelf->m_CompressionLock);
+
+		if(Index >= pSelf->m_NumDatas)
+			break;
+		pSelf->CompressData(Index);
+	}
 }
 
 int CDataFileWriter::AddDataSwapped(int Size, void *pData)
@@ -551,6 +594,21 @@ int CDataFileWriter::Finish()
 	int DataSize = 0;
 	CDatafileHeader Header;
 
+	// compress all data blocks
+	m_NextCompressData = 0;
+	int NumThreads = min(m_NumThreads, m_NumDatas);
+	if(NumThreads > 1)
+	{
+		void *apThreads[MAX_COMPRESSION_THREADS];
+		for(int i = 0; i < NumThreads-1; i++)
+			apThreads[i] = thread_create(CompressThread, this);
+		CompressThread(this);
+		for(int i = 0; i < NumThreads-1; i++)
+			thread_wait(apThreads[i]);
+	}
+	else
+		CompressThread(this);
+
 	// we should now write this file!
 	if(DEBUG)
 		dbg_msg("datafile", "writing");
@@ -22,6 +22,7 @@ public:
 	void *GetData(int Index);
 	void *GetDataSwapped(int Index); // makes sure that the data is 32bit LE ints when saved
 	int GetDataSize(int Index);
+	int GetUncompressedDataSize(int Index);
 	void UnloadData(int Index);
 	void *GetItem(int Index, int *pType, int *pID);
 	int GetItemSize(int Index);
@@ -41,6 +42,7 @@ class CDataFileWriter
 	{
 		int m_UncompressedSize;
 		int m_CompressedSize;
+		void *m_pUncompressedData;
 		void *m_pCompressedData;
 	};
 
@@ -66,6 +68,7 @@ class CDataFileWriter
 		MAX_ITEM_TYPES=0xffff,
 		MAX_ITEMS=1024,
 		MAX_DATAS=1024,
+		MAX_COMPRESSION_THREADS=16,
 	};
 
 	IOHANDLE m_File;
@@ -76,10 +79,25 @@ class CDataFileWriter
 	CItemInfo *m_pItems;
 	CDataInfo *m_pDatas;
 
+	// deferred compression, done in Finish()
+	int m_CompressionLevel;
+	int m_NumThreads;
+	LOCK m_CompressionLock;
+	volatile int m_NextCompressData;
+
+	void CompressData(int Index);
+	static void CompressThread(void *pUser);
+
 public:
+	enum
+	{
+		COMPRESSION_DEFAULT=-1, // zlib default, 1 (fastest) to 9 (smallest) otherwise
+		DEFAULT_THREADS=4,
+	};
+
 	CDataFileWriter();
 	~CDataFileWriter();
-	bool Open(class IStorage *pStorage, const char *Filename);
+	bool Open(class IStorage *pStorage, const char *Filename, int CompressionLevel = COMPRESSION_DEFAULT, int NumThreads = DEFAULT_THREADS);
 	int AddData(int Size, void *pData);
 	int AddDataSwapped(int Size, void *pData);
 	int AddItem(int Type, int ID, int Size, void *pData);
@@ -18,6 +18,7 @@ int CEcon::NewClientCallback(int ClientID, void *pUser)
 	pThis->m_aClients[ClientID].m_State = CClient::STATE_CONNECTED;
 	pThis->m_aClients[ClientID].m_TimeConnected = time_get();
 	pThis->m_aClients[ClientID].m_AuthTries = 0;
+	pThis->m_aClients[ClientID].m_Events = false;
 
 	pThis->m_NetConsole.Send(ClientID, "Enter password:");
 	return 0;
@@ -33,6 +34,8 @@ int CEcon::DelClientCallback(int ClientID, const char *pReason, void *pUser)
 	str_format(aBuf, sizeof(aBuf), "client dropped. cid=%d addr=%s reason='%s'", ClientID, aAddrStr, pReason);
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "econ", aBuf);
 
+	if(pThis->m_aClients[ClientID].m_Events)
+		pThis->m_NumEventClients--;
 	pThis->m_aClients[ClientID].m_State = CClient::STATE_EMPTY;
 	return 0;
 }
@@ -52,6 +55,17 @@ void CEcon::ConchainEconOutputLevelUpdate(IConsole::IResult *pResult, void *pUse
 	}
 }
 
+void CEcon::ConchainEconDropSlowUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	pfnCallback(pResult, pCallbackUserData);
+	if(pResult->NumArguments() == 1)
+	{
+		// only affects new connections
+		CEcon *pThis = static_cast<CEcon *>(pUserData);
+		pThis->m_NetConsole.SetFlags(pResult->GetInteger(0) ? NETCONSOLE_FLAG_DROPSLOW : 0);
+	}
+}
+
 void CEcon::ConLogout(IConsole::IResult *pResult, void *pUserData)
 {
 	CEcon *pThis = static_cast<CEcon *>(pUserData);
@@ -60,15 +74,56 @@ void CEcon::ConLogout(IConsole::IResult *pResult, void *pUserData)
 		pThis->m_NetConsole.Drop(pThis->m_UserClientID, "Logout");
 }
 
+void CEcon::ConStatus(IConsole::IResult *pResult, void *pUserData)
+{
+	CEcon *pThis = static_cast<CEcon *>(pUserData);
+	char aBuf[256];
+	char aAddrStr[NETADDR_MAXSTRSIZE];
+
+	for(int i = 0; i < NET_MAX_CONSOLE_CLIENTS; i++)
+	{
+		if(pThis->m_aClients[i].m_State == CClient::STATE_EMPTY)
+			continue;
+
+		net_addr_str(pThis->m_NetConsole.ClientAddr(i), aAddrStr, sizeof(aAddrStr), true);
+		str_format(aBuf, sizeof(aBuf), "cid=%d addr=%s %s dropped_lines=%d", i, aAddrStr,
+			pThis->m_aClients[i].m_State == CClient::STATE_AUTHED ? "authed" : "connecting", pThis->m_NetConsole.NumDroppedLines(i));
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "econ", aBuf);
+	}
+	str_format(aBuf, sizeof(aBuf), "max_clients=%d dropped_lines=%d dropped_clients=%d", pThis->m_NetConsole.MaxClients(),
+		pThis->m_NetConsole.NumDroppedLines(), pThis->m_NetConsole.NumDroppedClients());
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "econ", aBuf);
+}
+
+void CEcon::ConEvents(IConsole::IResult *pResult, void *pUserData)
+{
+	CEcon *pThis = static_cast<CEcon *>(pUserData);
+
+	int ClientID = pThis->m_UserClientID;
+	if(ClientID < 0 || ClientID >= NET_MAX_CONSOLE_CLIENTS || pThis->m_aClients[ClientID].m_State != CClient::STATE_AUTHED)
+		return;
+
+	bool Events = pResult->NumArguments() ? pResult->GetInteger(0) != 0 : !pThis->m_aClients[ClientID].m_Events;
+	if(Events != pThis->m_aClients[ClientID].m_Events)
+	{
+		pThis->m_aClients[ClientID].m_Events = Events;
+		pThis->m_NumEventClients += Events ? 1 : -1;
+	}
+}
+
 void CEcon::Init(IConsole *pConsole, CNetBan *pNetBan)
 {
 	m_pConsole = pConsole;
 
 	for(int i = 0; i < NET_MAX_CONSOLE_CLIENTS; i++)
+	{
 		m_aClients[i].m_State = CClient::STATE_EMPTY;
+		m_aClients[i].m_Events = false;
+	}
 
 	m_Ready = false;
 	m_UserClientID = -1;
+	m_NumEventClients = 0;
 
 	if(g_Config.m_EcPort == 0 || g_Config.m_EcPassword[0] == 0)
 		return;
@@ -87,7 +142,7 @@ void CEcon::Init(IConsole *pConsole, CNetBan *pNetBan)
 		BindAddr.port = g_Config.m_EcPort;
 	}
 
-	if(m_NetConsole.Open(BindAddr, pNetBan, 0))
+	if(m_NetConsole.Open(BindAddr, pNetBan, g_Config.m_EcMaxClients, g_Config.m_EcDropSlow ? NETCONSOLE_FLAG_DROPSLOW : 0))
 	{
 		m_NetConsole.SetCallbacks(NewClientCallback, DelClientCallback, this);
 		m_Ready = true;
@@ -96,9 +151,12 @@ void CEcon::Init(IConsole *pConsole, CNetBan *pNetBan)
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD,"econ", aBuf);
 
 		Console()->Chain("ec_output_level", ConchainEconOutputLevelUpdate, this);
+		Console()->Chain("ec_drop_slow", ConchainEconDropSlowUpdate, this);
 		m_PrintCBIndex = Console()->RegisterPrintCallback(g_Config.m_EcOutputLevel, SendLineCB, this);
 
 		Console()->Register("logout", "", CFGFLAG_ECON, ConLogout, this, "Logout of econ");
+		Console()->Register("econ_status", "", CFGFLAG_ECON, ConStatus, this, "List econ clients and dropped output");
+		Console()->Register("events", "?i", CFGFLAG_ECON, ConEvents, this, "Receive game events as json lines (toggles without argument)");
 	}
 	else
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD,"econ", "couldn't open socket. port might already be in use");
@@ -178,6 +236,18 @@ void CEcon::Send(int ClientID, const char *pLine)
 		m_NetConsole.Send(ClientID, pLine);
 }
 
+void CEcon::SendEvent(const char *pLine)
+{
+	if(!m_Ready)
+		return;
+
+	for(int i = 0; i < NET_MAX_CONSOLE_CLIENTS; i++)
+	{
+		if(m_aClients[i].m_State == CClient::STATE_AUTHED && m_aClients[i].m_Events)
+			m_NetConsole.Send(i, pLine);
+	}
+}
+
 void CEcon::Shutdown()
 {
 	if(!m_Ready)
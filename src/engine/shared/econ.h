@@ -24,6 +24,7 @@ class CEcon
 		int m_State;
 		int64 m_TimeConnected;
 		int m_AuthTries;
+		bool m_Events;
 	};
 	CClient m_aClients[NET_MAX_CONSOLE_CLIENTS];
 
@@ -33,10 +34,14 @@ class CEcon
 	bool m_Ready;
 	int m_PrintCBIndex;
 	int m_UserClientID;
+	int m_NumEventClients;
 
 	static void SendLineCB(const char *pLine, void *pUserData);
 	static void ConchainEconOutputLevelUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
+	static void ConchainEconDropSlowUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConLogout(IConsole::IResult *pResult, void *pUserData);
+	static void ConStatus(IConsole::IResult *pResult, void *pUserData);
+	static void ConEvents(IConsole::IResult *pResult, void *pUserData);
 
 	static int NewClientCallback(int ClientID, void *pUser);
 	static int DelClientCallback(int ClientID, const char *pReason, void *pUser);
@@ -47,6 +52,8 @@ public:
 	void Init(IConsole *pConsole, class CNetBan *pNetBan);
 	void Update();
 	void Send(int ClientID, const char *pLine);
+	void SendEvent(const char *pLine);
+	bool HasEventClients() const { return m_NumEventClients > 0; }
 	void Shutdown();
 };
 
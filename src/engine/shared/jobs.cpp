@@ -1,12 +1,16 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <base/system.h>
+#include <base/tl/threading.h>
 #include "jobs.h"
 
 CJobPool::CJobPool()
 {
 	// empty the pool
 	m_Lock = lock_create();
+#if !defined(CONF_PLATFORM_MACOSX)
+	semaphore_init(&m_Pending);
+#endif
 	m_pFirstJob = 0;
 	m_pLastJob = 0;
 }
@@ -19,6 +23,10 @@ void CJobPool::WorkerThread(void *pUser)
 	{
 		CJob *pJob = 0;
 
+#if !defined(CONF_PLATFORM_MACOSX)
+		semaphore_wait(&pPool->m_Pending);
+#endif
+
 		// fetch job from queue
 		lock_wait(pPool->m_Lock);
 		if(pPool->m_pFirstJob)
@@ -37,6 +45,7 @@ void CJobPool::WorkerThread(void *pUser)
 		{
 			pJob->m_Status = CJob::STATE_RUNNING;
 			pJob->m_Result = pJob->m_pfnFunc(pJob->m_pFuncData);
+			sync_barrier();
 			pJob->m_Status = CJob::STATE_DONE;
 		}
 		else
@@ -70,6 +79,9 @@ int CJobPool::Add(CJob *pJob, JOBFUNC pfnFunc, void *pData)
 		m_pFirstJob = pJob;
 
 	lock_release(m_Lock);
+#if !defined(CONF_PLATFORM_MACOSX)
+	semaphore_signal(&m_Pending);
+#endif
 	return 0;
 }
 
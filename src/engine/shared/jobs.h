@@ -2,6 +2,9 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #ifndef ENGINE_SHARED_JOBS_H
 #define ENGINE_SHARED_JOBS_H
+
+#include <base/system.h>
+
 typedef int (*JOBFUNC)(void *pData);
 
 class CJobPool;
@@ -40,6 +43,9 @@ public:
 class CJobPool
 {
 	LOCK m_Lock;
+#if !defined(CONF_PLATFORM_MACOSX)
+	SEMAPHORE m_Pending; // counts queued jobs so idle workers can sleep until there is one
+#endif
 	CJob *m_pFirstJob;
 	CJob *m_pLastJob;
 
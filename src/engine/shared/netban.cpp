@@ -3,6 +3,7 @@
 #include <engine/console.h>
 #include <engine/storage.h>
 #include <engine/shared/config.h>
+#include <engine/shared/linereader.h>
 
 #include "netban.h"
 
@@ -19,101 +20,108 @@ bool CNetBan::StrAllnum(const char *pStr)
 }
 
 
-CNetBan::CNetHash::CNetHash(const NETADDR *pAddr)
+static inline int PrefixBit(const unsigned char *pIp, int Pos)
 {
-	if(pAddr->type==NETTYPE_IPV4)
-		m_Hash = (pAddr->ip[0]+pAddr->ip[1]+pAddr->ip[2]+pAddr->ip[3])&0xFF;
-	else
-		m_Hash = (pAddr->ip[0]+pAddr->ip[1]+pAddr->ip[2]+pAddr->ip[3]+pAddr->ip[4]+pAddr->ip[5]+pAddr->ip[6]+pAddr->ip[7]+
-			pAddr->ip[8]+pAddr->ip[9]+pAddr->ip[10]+pAddr->ip[11]+pAddr->ip[12]+pAddr->ip[13]+pAddr->ip[14]+pAddr->ip[15])&0xFF;
-	m_HashIndex = 0;
+	return (pIp[Pos>>3]>>(7-(Pos&7)))&1;
 }
 
-CNetBan::CNetHash::CNetHash(const CNetRange *pRange)
+static int CommonBits(const unsigned char *pIp1, const unsigned char *pIp2, int MaxBits)
 {
-	m_Hash = 0;
-	m_HashIndex = 0;
-	for(int i = 0; pRange->m_LB.ip[i] == pRange->m_UB.ip[i]; ++i)
+	int Bits = 0;
+	for(int i = 0; Bits < MaxBits; i++, Bits += 8)
 	{
-		m_Hash += pRange->m_LB.ip[i];
-		++m_HashIndex;
+		int Diff = pIp1[i]^pIp2[i];
+		if(Diff)
+		{
+			while(!(Diff&0x80))
+			{
+				Diff <<= 1;
+				Bits++;
+			}
+			break;
+		}
 	}
-	m_Hash &= 0xFF;
+	return min(Bits, MaxBits);
 }
 
-int CNetBan::CNetHash::MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17])
+int CNetBan::MakePrefixes(const CNetRange *pRange, CNetPrefix *pPrefixes, int MaxPrefixes)
 {
-	int Length = pAddr->type==NETTYPE_IPV4 ? 4 : 16;
-	aHash[0].m_Hash = 0;
-	aHash[0].m_HashIndex = 0;
-	for(int i = 1, Sum = 0; i <= Length; ++i)
+	int Bits = pRange->m_LB.type==NETTYPE_IPV4 ? 32 : 128;
+	int Bytes = Bits/8;
+	unsigned char aFirst[16] = {0}, aLast[16] = {0};
+	mem_copy(aFirst, pRange->m_LB.ip, Bytes);
+
+	int Num = 0;
+	while(Num < MaxPrefixes)
 	{
-		Sum += pAddr->ip[i-1];
-		aHash[i].m_Hash = Sum&0xFF;
-		aHash[i].m_HashIndex = i%Length;
+		// the largest aligned block starting at aFirst that still ends inside the range
+		int Size = 0;
+		mem_copy(aLast, aFirst, Bytes);
+		while(Size < Bits && !PrefixBit(aFirst, Bits-1-Size))
+		{
+			aLast[(Bits-1-Size)>>3] |= 1<<(Size&7);
+			if(mem_comp(aLast, pRange->m_UB.ip, Bytes) > 0)
+			{
+				aLast[(Bits-1-Size)>>3] &= ~(1<<(Size&7));
+				break;
+			}
+			Size++;
+		}
+
+		pPrefixes[Num].m_Type = pRange->m_LB.type;
+		pPrefixes[Num].m_Length = Bits-Size;
+		mem_copy(pPrefixes[Num].m_aIp, aFirst, sizeof(pPrefixes[Num].m_aIp));
+		Num++;
+
+		if(mem_comp(aLast, pRange->m_UB.ip, Bytes) == 0)
+			break;
+
+		// the next block starts right after this one
+		mem_copy(aFirst, aLast, Bytes);
+		for(int i = Bytes-1; i >= 0 && ++aFirst[i] == 0; i--);
 	}
-	return Length;
+	return Num;
 }
 
+unsigned CNetBan::Hash(const NETADDR *pAddr)
+{
+	// bans don't look at the port
+	return net_addr_hash(pAddr, false);
+}
 
-template<class T, int HashCount>
-typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData, const CBanInfo *pInfo,  const CNetHash *pNetHash)
+unsigned CNetBan::Hash(const CNetRange *pRange)
 {
-	if(!m_pFirstFree)
-		return 0;
+	return Hash(&pRange->m_LB)*31+Hash(&pRange->m_UB);
+}
 
+
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanPool<T>::Add(const T *pData, const CBanInfo *pInfo)
+{
 	// create new ban
-	CBan<T> *pBan = m_pFirstFree;
+	CBan<T> *pBan = new CBan<T>;
 	pBan->m_Data = *pData;
 	pBan->m_Info = *pInfo;
-	pBan->m_NetHash = *pNetHash;
-	if(pBan->m_pNext)
-		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
-	if(pBan->m_pPrev)
-		pBan->m_pPrev->m_pNext = pBan->m_pNext;
-	else
-		m_pFirstFree = pBan->m_pNext;
-
-	// add it to the hash list
-	if(m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash])
-		m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]->m_pHashPrev = pBan;
-	pBan->m_pHashPrev = 0;
-	pBan->m_pHashNext = m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash];
-	m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash] = pBan;
-
-	// insert it into the used list
-	if(m_pFirstUsed)
-	{
-		for(CBan<T> *p = m_pFirstUsed; ; p = p->m_pNext)
-		{
-			if(p->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER || (pInfo->m_Expires != CBanInfo::EXPIRES_NEVER && pInfo->m_Expires <= p->m_Info.m_Expires))
-			{
-				// insert before
-				pBan->m_pNext = p;
-				pBan->m_pPrev = p->m_pPrev;
-				if(p->m_pPrev)
-					p->m_pPrev->m_pNext = pBan;
-				else
-					m_pFirstUsed = pBan;
-				p->m_pPrev = pBan;
-				break;
-			}
-
-			if(!p->m_pNext)
-			{
-				// last entry
-				p->m_pNext = pBan;
-				pBan->m_pPrev = p;
-				pBan->m_pNext = 0;
-				break;
-			}
-		}
-	}
+	pBan->m_ExpireIndex = -1;
+	HashInsert(pBan);
+
+	// add it to the trie
+	CNetPrefix aPrefixes[MAX_PREFIXES];
+	int NumPrefixes = MakePrefixes(pData, aPrefixes, MAX_PREFIXES);
+	for(int i = 0; i < NumPrefixes; ++i)
+		Insert(&aPrefixes[i], pBan);
+
+	if(pInfo->m_Expires != CBanInfo::EXPIRES_NEVER)
+		ExpireInsert(pBan);
+
+	// append it to the used list
+	pBan->m_pNext = 0;
+	pBan->m_pPrev = m_pLastUsed;
+	if(m_pLastUsed)
+		m_pLastUsed->m_pNext = pBan;
 	else
-	{
 		m_pFirstUsed = pBan;
-		pBan->m_pNext = pBan->m_pPrev = 0;
-	}
+	m_pLastUsed = pBan;
 
 	// update ban count
 	++m_CountUsed;
@@ -121,35 +129,33 @@ typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData,
 	return pBan;
 }
 
-template<class T, int HashCount>
-int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
+template<class T>
+int CNetBan::CBanPool<T>::Remove(CBan<T> *pBan)
 {
 	if(pBan == 0)
 		return -1;
 
-	// remove from hash list
-	if(pBan->m_pHashNext)
-		pBan->m_pHashNext->m_pHashPrev = pBan->m_pHashPrev;
-	if(pBan->m_pHashPrev)
-		pBan->m_pHashPrev->m_pHashNext = pBan->m_pHashNext;
-	else
-		m_paaHashList[pBan->m_NetHash.m_HashIndex][pBan->m_NetHash.m_Hash] = pBan->m_pHashNext;
-	pBan->m_pHashNext = pBan->m_pHashPrev = 0;
+	// remove from the trie
+	CNetPrefix aPrefixes[MAX_PREFIXES];
+	int NumPrefixes = MakePrefixes(&pBan->m_Data, aPrefixes, MAX_PREFIXES);
+	for(int i = 0; i < NumPrefixes; ++i)
+		Erase(&aPrefixes[i], pBan);
+
+	HashRemove(pBan);
+	if(pBan->m_ExpireIndex != -1)
+		ExpireRemove(pBan);
 
 	// remove from used list
 	if(pBan->m_pNext)
 		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
+	else
+		m_pLastUsed = pBan->m_pPrev;
 	if(pBan->m_pPrev)
 		pBan->m_pPrev->m_pNext = pBan->m_pNext;
 	else
 		m_pFirstUsed = pBan->m_pNext;
 
-	// add to recycle list
-	if(m_pFirstFree)
-		m_pFirstFree->m_pPrev = pBan;
-	pBan->m_pPrev = 0;
-	pBan->m_pNext = m_pFirstFree;
-	m_pFirstFree = pBan;
+	delete pBan;
 
 	// update ban count
 	--m_CountUsed;
@@ -157,75 +163,89 @@ int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
 	return 0;
 }
 
-template<class T, int HashCount>
-void CNetBan::CBanPool<T, HashCount>::Update(CBan<CDataType> *pBan, const CBanInfo *pInfo)
+template<class T>
+void CNetBan::CBanPool<T>::Update(CBan<CDataType> *pBan, const CBanInfo *pInfo)
 {
+	int OldExpires = pBan->m_Info.m_Expires;
 	pBan->m_Info = *pInfo;
 
-	// remove from used list
-	if(pBan->m_pNext)
-		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
-	if(pBan->m_pPrev)
-		pBan->m_pPrev->m_pNext = pBan->m_pNext;
-	else
-		m_pFirstUsed = pBan->m_pNext;
+	// move it in the expire heap
+	if(OldExpires == CBanInfo::EXPIRES_NEVER && pInfo->m_Expires != CBanInfo::EXPIRES_NEVER)
+		ExpireInsert(pBan);
+	else if(OldExpires != CBanInfo::EXPIRES_NEVER && pInfo->m_Expires == CBanInfo::EXPIRES_NEVER)
+		ExpireRemove(pBan);
+	else if(pInfo->m_Expires != CBanInfo::EXPIRES_NEVER)
+	{
+		ExpireUp(pBan->m_ExpireIndex);
+		ExpireDown(pBan->m_ExpireIndex);
+	}
+}
 
-	// insert it into the used list
-	if(m_pFirstUsed)
+template<class T>
+void CNetBan::CBanPool<T>::Reset()
+{
+	for(int i = 0; i < 2; ++i)
 	{
-		for(CBan<T> *p = m_pFirstUsed; ; p = p->m_pNext)
-		{
-			if(p->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER || (pInfo->m_Expires != CBanInfo::EXPIRES_NEVER && pInfo->m_Expires <= p->m_Info.m_Expires))
-			{
-				// insert before
-				pBan->m_pNext = p;
-				pBan->m_pPrev = p->m_pPrev;
-				if(p->m_pPrev)
-					p->m_pPrev->m_pNext = pBan;
-				else
-					m_pFirstUsed = pBan;
-				p->m_pPrev = pBan;
-				break;
-			}
+		FreeNode(m_apRoots[i]);
+		m_apRoots[i] = 0;
+	}
 
-			if(!p->m_pNext)
-			{
-				// last entry
-				p->m_pNext = pBan;
-				pBan->m_pPrev = p;
-				pBan->m_pNext = 0;
-				break;
-			}
-		}
+	while(m_pFirstUsed)
+	{
+		CBan<T> *pNext = m_pFirstUsed->m_pNext;
+		delete m_pFirstUsed;
+		m_pFirstUsed = pNext;
 	}
-	else
+	m_pLastUsed = 0;
+	m_CountUsed = 0;
+
+	mem_free(m_ppHashList);
+	m_ppHashList = 0;
+	m_HashSize = 0;
+
+	mem_free(m_ppExpireHeap);
+	m_ppExpireHeap = 0;
+	m_NumExpire = 0;
+	m_ExpireCapacity = 0;
+}
+
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanPool<T>::Find(const T *pData) const
+{
+	if(!m_HashSize)
+		return 0;
+
+	for(CBan<T> *pBan = m_ppHashList[Hash(pData)&(m_HashSize-1)]; pBan; pBan = pBan->m_pHashNext)
 	{
-		m_pFirstUsed = pBan;
-		pBan->m_pNext = pBan->m_pPrev = 0;
+		if(NetComp(&pBan->m_Data, pData) == 0)
+			return pBan;
 	}
+
+	return 0;
 }
 
-template<class T, int HashCount>
-void CNetBan::CBanPool<T, HashCount>::Reset()
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanPool<T>::Match(const NETADDR *pAddr) const
 {
-	mem_zero(m_paaHashList, sizeof(m_paaHashList));
-	mem_zero(m_aBans, sizeof(m_aBans));
-	m_pFirstUsed = 0;
-	m_CountUsed = 0;
+	if(pAddr->type != NETTYPE_IPV4 && pAddr->type != NETTYPE_IPV6)
+		return 0;
 
-	for(int i = 1; i < MAX_BANS-1; ++i)
+	// the first node on the way down that holds a ban covers the address, only the branch bits are
+	// looked at until then. when its prefix differs, every node below it differs as well
+	int Bits = pAddr->type==NETTYPE_IPV4 ? 32 : 128;
+	for(CNode *pNode = m_apRoots[pAddr->type==NETTYPE_IPV4 ? 0 : 1]; pNode; pNode = pNode->m_apChildren[PrefixBit(pAddr->ip, pNode->m_Length)])
 	{
-		m_aBans[i].m_pNext = &m_aBans[i+1];
-		m_aBans[i].m_pPrev = &m_aBans[i-1];
+		if(pNode->m_pBans)
+			return CommonBits(pNode->m_aPrefix, pAddr->ip, pNode->m_Length) == pNode->m_Length ? pNode->m_pBans->m_pBan : 0;
+		if(pNode->m_Length == Bits)
+			return 0;
 	}
 
-	m_aBans[0].m_pNext = &m_aBans[1];
-	m_aBans[MAX_BANS-1].m_pPrev = &m_aBans[MAX_BANS-2];
-	m_pFirstFree = &m_aBans[0];
+	return 0;
 }
 
-template<class T, int HashCount>
-typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Get(int Index) const
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanPool<T>::Get(int Index) const
 {
 	if(Index < 0 || Index >= Num())
 		return 0;
@@ -239,6 +259,223 @@ typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Get(int Index) const
 	return 0;
 }
 
+template<class T>
+void CNetBan::CBanPool<T>::Insert(const CNetPrefix *pPrefix, CBan<T> *pBan)
+{
+	CNode **ppNode = &m_apRoots[pPrefix->m_Type==NETTYPE_IPV4 ? 0 : 1];
+	while(1)
+	{
+		CNode *pNode = *ppNode;
+		if(!pNode)
+		{
+			pNode = new CNode;
+			mem_copy(pNode->m_aPrefix, pPrefix->m_aIp, sizeof(pNode->m_aPrefix));
+			pNode->m_Length = pPrefix->m_Length;
+			pNode->m_apChildren[0] = pNode->m_apChildren[1] = 0;
+			pNode->m_pBans = 0;
+			*ppNode = pNode;
+		}
+
+		int Common = CommonBits(pNode->m_aPrefix, pPrefix->m_aIp, min(pNode->m_Length, pPrefix->m_Length));
+		if(Common < pNode->m_Length)
+		{
+			// split the node where the prefixes part
+			CNode *pSplit = new CNode;
+			mem_copy(pSplit->m_aPrefix, pPrefix->m_aIp, sizeof(pSplit->m_aPrefix));
+			pSplit->m_Length = Common;
+			pSplit->m_apChildren[PrefixBit(pNode->m_aPrefix, Common)] = pNode;
+			pSplit->m_apChildren[PrefixBit(pNode->m_aPrefix, Common)^1] = 0;
+			pSplit->m_pBans = 0;
+			*ppNode = pSplit;
+			pNode = pSplit;
+		}
+
+		if(pNode->m_Length == pPrefix->m_Length)
+		{
+			CBanRef *pRef = new CBanRef;
+			pRef->m_pBan = pBan;
+			pRef->m_pNext = pNode->m_pBans;
+			pNode->m_pBans = pRef;
+			return;
+		}
+
+		ppNode = &pNode->m_apChildren[PrefixBit(pPrefix->m_aIp, pNode->m_Length)];
+	}
+}
+
+template<class T>
+void CNetBan::CBanPool<T>::Erase(const CNetPrefix *pPrefix, CBan<T> *pBan)
+{
+	CNode **appPath[129];
+	int Depth = 0;
+	CNode **ppNode = &m_apRoots[pPrefix->m_Type==NETTYPE_IPV4 ? 0 : 1];
+	while(*ppNode && (*ppNode)->m_Length < pPrefix->m_Length)
+	{
+		appPath[Depth++] = ppNode;
+		ppNode = &(*ppNode)->m_apChildren[PrefixBit(pPrefix->m_aIp, (*ppNode)->m_Length)];
+	}
+
+	CNode *pNode = *ppNode;
+	if(!pNode || pNode->m_Length != pPrefix->m_Length || CommonBits(pNode->m_aPrefix, pPrefix->m_aIp, pNode->m_Length) < pNode->m_Length)
+		return;
+
+	for(CBanRef **ppRef = &pNode->m_pBans; *ppRef; ppRef = &(*ppRef)->m_pNext)
+	{
+		if((*ppRef)->m_pBan == pBan)
+		{
+			CBanRef *pRef = *ppRef;
+			*ppRef = pRef->m_pNext;
+			delete pRef;
+			break;
+		}
+	}
+
+	// drop nodes that neither hold a ban nor branch
+	while(1)
+	{
+		pNode = *ppNode;
+		if(pNode->m_pBans || (pNode->m_apChildren[0] && pNode->m_apChildren[1]))
+			break;
+		*ppNode = pNode->m_apChildren[0] ? pNode->m_apChildren[0] : pNode->m_apChildren[1];
+		delete pNode;
+
+		// only a node that went away completely can leave its parent useless
+		if(*ppNode || Depth == 0)
+			break;
+		ppNode = appPath[--Depth];
+	}
+}
+
+template<class T>
+void CNetBan::CBanPool<T>::FreeNode(CNode *pNode)
+{
+	if(!pNode)
+		return;
+
+	FreeNode(pNode->m_apChildren[0]);
+	FreeNode(pNode->m_apChildren[1]);
+	while(pNode->m_pBans)
+	{
+		CBanRef *pNext = pNode->m_pBans->m_pNext;
+		delete pNode->m_pBans;
+		pNode->m_pBans = pNext;
+	}
+	delete pNode;
+}
+
+template<class T>
+void CNetBan::CBanPool<T>::HashInsert(CBan<T> *pBan)
+{
+	if(m_CountUsed+1 > m_HashSize)
+		HashGrow();
+
+	CBan<T> **ppList = &m_ppHashList[Hash(&pBan->m_Data)&(m_HashSize-1)];
+	pBan->m_pHashNext = *ppList;
+	*ppList = pBan;
+}
+
+template<class T>
+void CNetBan::CBanPool<T>::HashRemove(CBan<T> *pBan)
+{
+	for(CBan<T> **ppBan = &m_ppHashList[Hash(&pBan->m_Data)&(m_HashSize-1)]; *ppBan; ppBan = &(*ppBan)->m_pHashNext)
+	{
+		if(*ppBan == pBan)
+		{
+			*ppBan = pBan->m_pHashNext;
+			break;
+		}
+	}
+}
+
+template<class T>
+void CNetBan::CBanPool<T>::HashGrow()
+{
+	mem_free(m_ppHashList);
+	m_HashSize = max(m_HashSize*2, 256);
+	m_ppHashList = (CBan<T> **)mem_alloc(m_HashSize*sizeof(CBan<T> *), 1);
+	mem_zero(m_ppHashList, m_HashSize*sizeof(CBan<T> *));
+
+	// every ban is in the used list
+	for(CBan<T> *pBan = m_pFirstUsed; pBan; pBan = pBan->m_pNext)
+	{
+		CBan<T> **ppList = &m_ppHashList[Hash(&pBan->m_Data)&(m_HashSize-1)];
+		pBan->m_pHashNext = *ppList;
+		*ppList = pBan;
+	}
+}
+
+template<class T>
+void CNetBan::CBanPool<T>::ExpireInsert(CBan<T> *pBan)
+{
+	if(m_NumExpire == m_ExpireCapacity)
+	{
+		m_ExpireCapacity = max(m_ExpireCapacity*2, 64);
+		CBan<T> **ppNewHeap = (CBan<T> **)mem_alloc(m_ExpireCapacity*sizeof(CBan<T> *), 1);
+		if(m_NumExpire)
+			mem_copy(ppNewHeap, m_ppExpireHeap, m_NumExpire*sizeof(CBan<T> *));
+		mem_free(m_ppExpireHeap);
+		m_ppExpireHeap = ppNewHeap;
+	}
+
+	ExpireSet(m_NumExpire++, pBan);
+	ExpireUp(pBan->m_ExpireIndex);
+}
+
+template<class T>
+void CNetBan::CBanPool<T>::ExpireRemove(CBan<T> *pBan)
+{
+	// move the last ban into the gap
+	int Index = pBan->m_ExpireIndex;
+	pBan->m_ExpireIndex = -1;
+	if(Index == --m_NumExpire)
+		return;
+	CBan<T> *pMoved = m_ppExpireHeap[m_NumExpire];
+	ExpireSet(Index, pMoved);
+	ExpireUp(Index);
+	ExpireDown(pMoved->m_ExpireIndex);
+}
+
+template<class T>
+void CNetBan::CBanPool<T>::ExpireSet(int Index, CBan<T> *pBan)
+{
+	m_ppExpireHeap[Index] = pBan;
+	pBan->m_ExpireIndex = Index;
+}
+
+template<class T>
+void CNetBan::CBanPool<T>::ExpireUp(int Index)
+{
+	CBan<T> *pBan = m_ppExpireHeap[Index];
+	while(Index > 0)
+	{
+		int Parent = (Index-1)/2;
+		if(m_ppExpireHeap[Parent]->m_Info.m_Expires <= pBan->m_Info.m_Expires)
+			break;
+		ExpireSet(Index, m_ppExpireHeap[Parent]);
+		Index = Parent;
+	}
+	ExpireSet(Index, pBan);
+}
+
+template<class T>
+void CNetBan::CBanPool<T>::ExpireDown(int Index)
+{
+	CBan<T> *pBan = m_ppExpireHeap[Index];
+	while(1)
+	{
+		int Child = Index*2+1;
+		if(Child >= m_NumExpire)
+			break;
+		if(Child+1 < m_NumExpire && m_ppExpireHeap[Child+1]->m_Info.m_Expires < m_ppExpireHeap[Child]->m_Info.m_Expires)
+			Child++;
+		if(pBan->m_Info.m_Expires <= m_ppExpireHeap[Child]->m_Info.m_Expires)
+			break;
+		ExpireSet(Index, m_ppExpireHeap[Child]);
+		Index = Child;
+	}
+	ExpireSet(Index, pBan);
+}
+
 
 template<class T>
 void CNetBan::MakeBanInfo(const CBan<T> *pBan, char *pBuf, unsigned BuffSize, int Type) const
@@ -301,37 +538,35 @@ int CNetBan::Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, c
 	str_copy(Info.m_aReason, pReason, sizeof(Info.m_aReason));
 
 	// check if it already exists
-	CNetHash NetHash(pData);
-	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData, &NetHash);
+	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData);
 	if(pBan)
 	{
 		// adjust the ban
 		pBanPool->Update(pBan, &Info);
-		char aBuf[128];
-		MakeBanInfo(pBan, aBuf, sizeof(aBuf), MSGTYPE_LIST);
-		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		if(!m_Importing)
+		{
+			char aBuf[128];
+			MakeBanInfo(pBan, aBuf, sizeof(aBuf), MSGTYPE_LIST);
+			Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		}
 		return 1;
 	}
 
 	// add ban and print result
-	pBan = pBanPool->Add(pData, &Info, &NetHash);
-	if(pBan)
+	pBan = pBanPool->Add(pData, &Info);
+	if(!m_Importing)
 	{
 		char aBuf[128];
 		MakeBanInfo(pBan, aBuf, sizeof(aBuf), MSGTYPE_BANADD);
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
-		return 0;
 	}
-	else
-		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", "ban failed (full banlist)");
-	return -1;
+	return 0;
 }
 
 template<class T>
 int CNetBan::Unban(T *pBanPool, const typename T::CDataType *pData)
 {
-	CNetHash NetHash(pData);
-	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData, &NetHash);
+	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData);
 	if(pBan)
 	{
 		char aBuf[256];
@@ -351,6 +586,7 @@ void CNetBan::Init(IConsole *pConsole, IStorage *pStorage)
 	m_pStorage = pStorage;
 	m_BanAddrPool.Reset();
 	m_BanRangePool.Reset();
+	m_Importing = false;
 
 	net_host_lookup("localhost", &m_LocalhostIPV4, NETTYPE_IPV4);
 	net_host_lookup("localhost", &m_LocalhostIPV6, NETTYPE_IPV6);
@@ -362,6 +598,7 @@ void CNetBan::Init(IConsole *pConsole, IStorage *pStorage)
 	Console()->Register("unban_all", "", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConUnbanAll, this, "Unban all entries");
 	Console()->Register("bans", "", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConBans, this, "Show banlist");
 	Console()->Register("bans_save", "s", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConBansSave, this, "Save banlist in a file");
+	Console()->Register("bans_load", "s", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConBansLoad, this, "Load a banlist saved with bans_save");
 }
 
 void CNetBan::Update()
@@ -370,17 +607,17 @@ void CNetBan::Update()
 
 	// remove expired bans
 	char aBuf[256], aNetStr[256];
-	while(m_BanAddrPool.First() && m_BanAddrPool.First()->m_Info.m_Expires != CBanInfo::EXPIRES_NEVER && m_BanAddrPool.First()->m_Info.m_Expires < Now)
+	while(m_BanAddrPool.NextExpire() && m_BanAddrPool.NextExpire()->m_Info.m_Expires < Now)
 	{
-		str_format(aBuf, sizeof(aBuf), "ban %s expired", NetToString(&m_BanAddrPool.First()->m_Data, aNetStr, sizeof(aNetStr)));
+		str_format(aBuf, sizeof(aBuf), "ban %s expired", NetToString(&m_BanAddrPool.NextExpire()->m_Data, aNetStr, sizeof(aNetStr)));
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
-		m_BanAddrPool.Remove(m_BanAddrPool.First());
+		m_BanAddrPool.Remove(m_BanAddrPool.NextExpire());
 	}
-	while(m_BanRangePool.First() && m_BanRangePool.First()->m_Info.m_Expires != CBanInfo::EXPIRES_NEVER && m_BanRangePool.First()->m_Info.m_Expires < Now)
+	while(m_BanRangePool.NextExpire() && m_BanRangePool.NextExpire()->m_Info.m_Expires < Now)
 	{
-		str_format(aBuf, sizeof(aBuf), "ban %s expired", NetToString(&m_BanRangePool.First()->m_Data, aNetStr, sizeof(aNetStr)));
+		str_format(aBuf, sizeof(aBuf), "ban %s expired", NetToString(&m_BanRangePool.NextExpire()->m_Data, aNetStr, sizeof(aNetStr)));
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
-		m_BanRangePool.Remove(m_BanRangePool.First());
+		m_BanRangePool.Remove(m_BanRangePool.NextExpire());
 	}
 }
 
@@ -445,11 +682,8 @@ int CNetBan::UnbanByIndex(int Index)
 
 bool CNetBan::IsBanned(const NETADDR *pAddr, char *pBuf, unsigned BufferSize) const
 {
-	CNetHash aHash[17];
-	int Length = CNetHash::MakeHashArray(pAddr, aHash);
-
 	// check ban adresses
-	CBanAddr *pBan = m_BanAddrPool.Find(pAddr, &aHash[Length]);
+	CBanAddr *pBan = m_BanAddrPool.Find(pAddr);
 	if(pBan)
 	{
 		MakeBanInfo(pBan, pBuf, BufferSize, MSGTYPE_PLAYER);
@@ -457,16 +691,11 @@ bool CNetBan::IsBanned(const NETADDR *pAddr, char *pBuf, unsigned BufferSize) co
 	}
 
 	// check ban ranges
-	for(int i = Length-1; i >= 0; --i)
+	CBanRange *pBanRange = m_BanRangePool.Match(pAddr);
+	if(pBanRange)
 	{
-		for(CBanRange *pBan = m_BanRangePool.First(&aHash[i]); pBan; pBan = pBan->m_pHashNext)
-		{
-			if(NetMatch(&pBan->m_Data, pAddr, i, Length))
-			{
-				MakeBanInfo(pBan, pBuf, BufferSize, MSGTYPE_PLAYER);
-				return true;
-			}
-		}
+		MakeBanInfo(pBanRange, pBuf, BufferSize, MSGTYPE_PLAYER);
+		return true;
 	}
 	
 	return false;
@@ -601,3 +830,82 @@ void CNetBan::ConBansSave(IConsole::IResult *pResult, void *pUser)
 	str_format(aBuf, sizeof(aBuf), "saved banlist to '%s'", pResult->GetString(0));
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
 }
+
+void CNetBan::ConBansLoad(IConsole::IResult *pResult, void *pUser)
+{
+	CNetBan *pThis = static_cast<CNetBan *>(pUser);
+
+	char aBuf[256];
+	IOHANDLE File = pThis->Storage()->OpenFile(pResult->GetString(0), IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!File)
+	{
+		str_format(aBuf, sizeof(aBuf), "failed to load banlist from '%s'", pResult->GetString(0));
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		return;
+	}
+
+	// same lines as bans_save writes, without going through the console for each of them
+	int NumLoaded = 0, NumFailed = 0;
+	int64 StartTime = time_get();
+	CLineReader LineReader;
+	LineReader.Init(File);
+	pThis->m_Importing = true;
+	char *pLine;
+	while((pLine = LineReader.Get()))
+	{
+		char *apArgs[4] = {0};
+		int NumArgs = 0;
+		bool Range = str_comp_num(pLine, "ban_range ", 10) == 0;
+		if(!Range && str_comp_num(pLine, "ban ", 4) != 0)
+		{
+			if(pLine[0] && pLine[0] != '#')
+				NumFailed++;
+			continue;
+		}
+
+		// address (or two), minutes and the rest of the line as reason
+		char *pStr = str_skip_whitespaces(str_skip_to_whitespace(pLine));
+		while(NumArgs < (Range ? 4 : 3) && *pStr)
+		{
+			apArgs[NumArgs++] = pStr;
+			if(NumArgs == (Range ? 4 : 3))
+				break;
+			pStr = str_skip_to_whitespace(pStr);
+			if(*pStr)
+				*pStr++ = 0;
+			pStr = str_skip_whitespaces(pStr);
+		}
+		if(NumArgs < (Range ? 3 : 2))
+		{
+			NumFailed++;
+			continue;
+		}
+
+		int Minutes = clamp(str_toint(apArgs[Range ? 2 : 1]), 0, 44640);
+		const char *pReason = apArgs[Range ? 3 : 2] ? apArgs[Range ? 3 : 2] : "No reason given";
+		int Result = -1;
+		if(Range)
+		{
+			CNetRange BanRange;
+			if(net_addr_from_str(&BanRange.m_LB, apArgs[0]) == 0 && net_addr_from_str(&BanRange.m_UB, apArgs[1]) == 0)
+				Result = pThis->BanRange(&BanRange, Minutes*60, pReason);
+		}
+		else
+		{
+			NETADDR Addr;
+			if(net_addr_from_str(&Addr, apArgs[0]) == 0)
+				Result = pThis->BanAddr(&Addr, Minutes*60, pReason);
+		}
+
+		if(Result >= 0)
+			NumLoaded++;
+		else
+			NumFailed++;
+	}
+	pThis->m_Importing = false;
+	io_close(File);
+
+	str_format(aBuf, sizeof(aBuf), "loaded %d bans from '%s' in %.2f ms, %d failed", NumLoaded, pResult->GetString(0),
+		(time_get()-StartTime)*1000.0/time_freq(), NumFailed);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+}
@@ -63,19 +63,26 @@ protected:
 	// todo: move?
 	static bool StrAllnum(const char *pStr);
 
-	class CNetHash
+	// all addresses starting with the first m_Length bits of m_aIp
+	struct CNetPrefix
 	{
-	public:
-		int m_Hash;
-		int m_HashIndex;	// matching parts for ranges, 0 for addr
-
-		CNetHash() {}	
-		CNetHash(const NETADDR *pAddr);
-		CNetHash(const CNetRange *pRange);
+		int m_Type;
+		int m_Length;
+		unsigned char m_aIp[16];
+	};
 
-		static int MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17]);
+	enum
+	{
+		MAX_PREFIXES=256, // a range splits into at most two prefixes per bit
 	};
 
+	// single addresses are only found through the hash, ranges go into the trie as well
+	static int MakePrefixes(const NETADDR *pAddr, CNetPrefix *pPrefixes, int MaxPrefixes) { return 0; }
+	static int MakePrefixes(const CNetRange *pRange, CNetPrefix *pPrefixes, int MaxPrefixes);
+
+	static unsigned Hash(const NETADDR *pAddr);
+	static unsigned Hash(const CNetRange *pRange);
+
 	struct CBanInfo
 	{
 		enum
@@ -91,59 +98,84 @@ protected:
 	{
 		T m_Data;
 		CBanInfo m_Info;
-		CNetHash m_NetHash;
+		int m_ExpireIndex; // position in the expire heap, -1 if it never expires
 
 		// hash list
 		CBan *m_pHashNext;
-		CBan *m_pHashPrev;
 
-		// used or free list
+		// used list
 		CBan *m_pNext;
 		CBan *m_pPrev;
 	};
 
-	template<class T, int HashCount> class CBanPool
+	template<class T> class CBanPool
 	{
 	public:
 		typedef T CDataType;
 
-		CBan<CDataType> *Add(const CDataType *pData, const CBanInfo *pInfo, const CNetHash *pNetHash);
+		CBanPool() : m_ppHashList(0), m_HashSize(0), m_ppExpireHeap(0), m_NumExpire(0), m_ExpireCapacity(0), m_pFirstUsed(0), m_pLastUsed(0), m_CountUsed(0)
+		{
+			m_apRoots[0] = m_apRoots[1] = 0;
+		}
+		~CBanPool() { Reset(); }
+
+		CBan<CDataType> *Add(const CDataType *pData, const CBanInfo *pInfo);
 		int Remove(CBan<CDataType> *pBan);
 		void Update(CBan<CDataType> *pBan, const CBanInfo *pInfo);
 		void Reset();
-	
+
 		int Num() const { return m_CountUsed; }
-		bool IsFull() const { return m_CountUsed == MAX_BANS; }
 
 		CBan<CDataType> *First() const { return m_pFirstUsed; }
-		CBan<CDataType> *First(const CNetHash *pNetHash) const { return m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; }
-		CBan<CDataType> *Find(const CDataType *pData, const CNetHash *pNetHash) const
-		{
-			for(CBan<CDataType> *pBan = m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; pBan; pBan = pBan->m_pHashNext)
-			{
-				if(NetComp(&pBan->m_Data, pData) == 0)
-					return pBan;
-			}
-
-			return 0;
-		}
+		CBan<CDataType> *NextExpire() const { return m_NumExpire ? m_ppExpireHeap[0] : 0; }
+		CBan<CDataType> *Find(const CDataType *pData) const;
+		CBan<CDataType> *Match(const NETADDR *pAddr) const; // a range covering the address
 		CBan<CDataType> *Get(int Index) const;
 
 	private:
-		enum
+		struct CBanRef
+		{
+			CBan<CDataType> *m_pBan;
+			CBanRef *m_pNext;
+		};
+
+		// compressed binary trie over the address bits, one for each address type
+		struct CNode
 		{
-			MAX_BANS=1024,
+			unsigned char m_aPrefix[16];
+			int m_Length;
+			CNode *m_apChildren[2];
+			CBanRef *m_pBans; // bans covering exactly this prefix
 		};
 
-		CBan<CDataType> *m_paaHashList[HashCount][256];
-		CBan<CDataType> m_aBans[MAX_BANS];
-		CBan<CDataType> *m_pFirstFree;
+		void Insert(const CNetPrefix *pPrefix, CBan<CDataType> *pBan);
+		void Erase(const CNetPrefix *pPrefix, CBan<CDataType> *pBan);
+		void FreeNode(CNode *pNode);
+
+		void HashInsert(CBan<CDataType> *pBan);
+		void HashRemove(CBan<CDataType> *pBan);
+		void HashGrow();
+
+		// min heap on the expire time
+		void ExpireInsert(CBan<CDataType> *pBan);
+		void ExpireRemove(CBan<CDataType> *pBan);
+		void ExpireSet(int Index, CBan<CDataType> *pBan);
+		void ExpireUp(int Index);
+		void ExpireDown(int Index);
+
+		CNode *m_apRoots[2];
+		CBan<CDataType> **m_ppHashList;
+		int m_HashSize; // power of two, at least the number of bans
+		CBan<CDataType> **m_ppExpireHeap;
+		int m_NumExpire;
+		int m_ExpireCapacity;
 		CBan<CDataType> *m_pFirstUsed;
+		CBan<CDataType> *m_pLastUsed;
 		int m_CountUsed;
 	};
 
-	typedef CBanPool<NETADDR, 1> CBanAddrPool;
-	typedef CBanPool<CNetRange, 16> CBanRangePool;
+	typedef CBanPool<NETADDR> CBanAddrPool;
+	typedef CBanPool<CNetRange> CBanRangePool;
 	typedef CBan<NETADDR> CBanAddr;
 	typedef CBan<CNetRange> CBanRange;
 	
@@ -156,6 +188,7 @@ protected:
 	CBanAddrPool m_BanAddrPool;
 	CBanRangePool m_BanRangePool;
 	NETADDR m_LocalhostIPV4, m_LocalhostIPV6;
+	bool m_Importing; // no message for every ban while loading a banlist
 
 public:
 	enum
@@ -188,6 +221,7 @@ public:
 	static void ConUnbanAll(class IConsole::IResult *pResult, void *pUser);
 	static void ConBans(class IConsole::IResult *pResult, void *pUser);
 	static void ConBansSave(class IConsole::IResult *pResult, void *pUser);
+	static void ConBansLoad(class IConsole::IResult *pResult, void *pUser);
 };
 
 #endif
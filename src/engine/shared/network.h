@@ -36,7 +36,11 @@ enum
 	NETSTATE_ONLINE,
 
 	NETBANTYPE_SOFT=1,
-	NETBANTYPE_DROP=2
+	NETBANTYPE_DROP=2,
+
+	NETCREATE_FLAG_REUSEPORT=1,
+
+	NETCONSOLE_FLAG_DROPSLOW=1, // disconnect clients that can't keep up instead of dropping their oldest lines
 };
 
 
@@ -49,7 +53,8 @@ enum
 	NET_MAX_CHUNKHEADERSIZE = 5,
 	NET_PACKETHEADERSIZE = 3,
 	NET_MAX_CLIENTS = 16,
-	NET_MAX_CONSOLE_CLIENTS = 4,
+	NET_MAX_CONSOLE_CLIENTS = 16,
+	NET_CONSOLE_SENDBUFFER_SIZE = 64*1024,
 	NET_MAX_SEQUENCE = 1<<10,
 	NET_SEQUENCE_MASK = NET_MAX_SEQUENCE-1,
 
@@ -204,18 +209,29 @@ private:
 	char m_aBuffer[NET_MAX_PACKETSIZE];
 	int m_BufferOffset;
 
+	// lines waiting to be sent, the one currently being sent is moved out of the ring buffer
+	TStaticRingBuffer<char, NET_CONSOLE_SENDBUFFER_SIZE> m_SendBuffer;
+	char m_aSendLine[1024+3];
+	int m_SendLineSize;
+	int m_SendLineOffset;
+	bool m_DropSlow;
+	int m_NumDroppedLines;
+
 	char m_aErrorString[256];
 
 	bool m_LineEndingDetected;
 	char m_aLineEnding[3];
 
+	int Flush();
+
 public:
-	void Init(NETSOCKET Socket, const NETADDR *pAddr);
+	void Init(NETSOCKET Socket, const NETADDR *pAddr, bool DropSlow);
 	void Disconnect(const char *pReason);
 
 	int State() const { return m_State; }
 	const NETADDR *PeerAddress() const { return &m_PeerAddr; }
 	const char *ErrorString() const { return m_aErrorString; }
+	int NumDroppedLines() const { return m_NumDroppedLines; }
 
 	void Reset();
 	int Update();
@@ -241,6 +257,72 @@ public:
 	int FetchChunk(CNetChunk *pChunk);
 };
 
+// per source address token buckets, checked before a packet is parsed
+class CNetRateLimit
+{
+public:
+	enum
+	{
+		TYPE_CONNECT=0,
+		TYPE_CONNLESS,
+		TYPE_SESSION,
+		NUM_TYPES,
+
+		MAX_ADDRESSES=4096,
+		HASH_SIZE=MAX_ADDRESSES*2,
+	};
+
+	struct CSource
+	{
+		NETADDR m_Addr;
+		int64 m_NumDropped;
+	};
+
+private:
+	struct CEntry
+	{
+		NETADDR m_Addr;
+		float m_aTokens[NUM_TYPES];
+		int64 m_LastTime;
+		int64 m_NumDropped;
+
+		int m_HashNext;
+		int m_Prev;
+		int m_Next;
+	};
+
+	CEntry m_aEntries[MAX_ADDRESSES];
+	int m_aHash[HASH_SIZE];
+	int m_NumEntries;
+	int m_First; // most recently used
+	int m_Last;
+
+	int m_aRate[NUM_TYPES];
+	int64 m_aNumAllowed[NUM_TYPES];
+	int64 m_aNumDropped[NUM_TYPES];
+	int64 m_NumEvicted;
+
+	static unsigned Hash(const NETADDR *pAddr);
+	void Unlink(int Index);
+	void LinkFirst(int Index);
+	int Find(const NETADDR *pAddr, unsigned HashIndex) const;
+	int Insert(const NETADDR *pAddr, unsigned HashIndex, int64 Now);
+
+public:
+	void Init();
+	void SetRate(int Type, int Rate) { m_aRate[Type] = Rate; }
+	bool Allow(const NETADDR *pAddr, int Type);
+
+	static int Classify(const unsigned char *pData, int Size);
+
+	int Rate(int Type) const { return m_aRate[Type]; }
+	int64 NumAllowed(int Type) const { return m_aNumAllowed[Type]; }
+	int64 NumDropped(int Type) const { return m_aNumDropped[Type]; }
+	int NumAddresses() const { return m_NumEntries; }
+	int64 NumEvicted() const { return m_NumEvicted; }
+	int GetTopSources(CSource *pSources, int MaxSources) const;
+};
+
 // server side
 class CNetServer
 {
@@ -261,6 +343,7 @@ class CNetServer
 	void *m_UserPtr;
 
 	CNetRecvUnpacker m_RecvUnpacker;
+	CNetRateLimit m_RateLimit;
 
 public:
 	int SetCallbacks(NETFUNC_NEWCLIENT pfnNewClient, NETFUNC_DELCLIENT pfnDelClient, void *pUser);
@@ -283,9 +366,11 @@ public:
 	class CNetBan *NetBan() const { return m_pNetBan; }
 	int NetType() const { return m_Socket.type; }
 	int MaxClients() const { return m_MaxClients; }
+	const CNetRateLimit *RateLimit() const { return &m_RateLimit; }
 
 	//
 	void SetMaxClientsPerIP(int Max);
+	void SetRateLimits(int Connect, int Connless, int Session);
 };
 
 class CNetConsole
@@ -298,6 +383,11 @@ class CNetConsole
 	NETSOCKET m_Socket;
 	class CNetBan *m_pNetBan;
 	CSlot m_aSlots[NET_MAX_CONSOLE_CLIENTS];
+	int m_MaxClients;
+	int m_Flags;
+
+	int m_NumDroppedLines;
+	int m_NumDroppedClients;
 
 	NETFUNC_NEWCLIENT m_pfnNewClient;
 	NETFUNC_DELCLIENT m_pfnDelClient;
@@ -309,7 +399,7 @@ public:
 	void SetCallbacks(NETFUNC_NEWCLIENT pfnNewClient, NETFUNC_DELCLIENT pfnDelClient, void *pUser);
 
 	//
-	bool Open(NETADDR BindAddr, class CNetBan *pNetBan, int Flags);
+	bool Open(NETADDR BindAddr, class CNetBan *pNetBan, int MaxClients, int Flags);
 	int Close();
 
 	//
@@ -324,6 +414,13 @@ public:
 	// status requests
 	const NETADDR *ClientAddr(int ClientID) const { return m_aSlots[ClientID].m_Connection.PeerAddress(); }
 	class CNetBan *NetBan() const { return m_pNetBan; }
+	int MaxClients() const { return m_MaxClients; }
+	int NumDroppedLines(int ClientID) const { return m_aSlots[ClientID].m_Connection.NumDroppedLines(); }
+	int NumDroppedLines() const;
+	int NumDroppedClients() const { return m_NumDroppedClients; }
+
+	//
+	void SetFlags(int Flags) { m_Flags = Flags; }
 };
 
 
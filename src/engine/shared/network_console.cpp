@@ -8,7 +8,7 @@
 #include "network.h"
 
 
-bool CNetConsole::Open(NETADDR BindAddr, CNetBan *pNetBan, int Flags)
+bool CNetConsole::Open(NETADDR BindAddr, CNetBan *pNetBan, int MaxClients, int Flags)
 {
 	// zero out the whole structure
 	mem_zero(this, sizeof(*this));
@@ -16,12 +16,20 @@ bool CNetConsole::Open(NETADDR BindAddr, CNetBan *pNetBan, int Flags)
 	m_Socket.ipv4sock = -1;
 	m_Socket.ipv6sock = -1;
 	m_pNetBan = pNetBan;
+	m_Flags = Flags;
+
+	// clamp clients
+	m_MaxClients = MaxClients;
+	if(m_MaxClients > NET_MAX_CONSOLE_CLIENTS)
+		m_MaxClients = NET_MAX_CONSOLE_CLIENTS;
+	if(m_MaxClients < 1)
+		m_MaxClients = 1;
 
 	// open socket
 	m_Socket = net_tcp_create(BindAddr);
 	if(!m_Socket.type)
 		return false;
-	if(net_tcp_listen(m_Socket, NET_MAX_CONSOLE_CLIENTS))
+	if(net_tcp_listen(m_Socket, m_MaxClients))
 		return false;
 	net_set_non_blocking(m_Socket);
 
@@ -53,6 +61,7 @@ int CNetConsole::Drop(int ClientID, const char *pReason)
 	if(m_pfnDelClient)
 		m_pfnDelClient(ClientID, pReason, m_UserPtr);
 
+	m_NumDroppedLines += m_aSlots[ClientID].m_Connection.NumDroppedLines();
 	m_aSlots[ClientID].m_Connection.Disconnect(pReason);
 
 	return 0;
@@ -64,7 +73,7 @@ int CNetConsole::AcceptClient(NETSOCKET Socket, const NETADDR *pAddr)
 	int FreeSlot = -1;
 
 	// look for free slot or multiple client
-	for(int i = 0; i < NET_MAX_CONSOLE_CLIENTS; i++)
+	for(int i = 0; i < m_MaxClients; i++)
 	{
 		if(FreeSlot == -1 && m_aSlots[i].m_Connection.State() == NET_CONNSTATE_OFFLINE)
 			FreeSlot = i;
@@ -81,7 +90,7 @@ int CNetConsole::AcceptClient(NETSOCKET Socket, const NETADDR *pAddr)
 	// accept client
 	if(!aError[0] && FreeSlot != -1)
 	{
-		m_aSlots[FreeSlot].m_Connection.Init(Socket, pAddr);
+		m_aSlots[FreeSlot].m_Connection.Init(Socket, pAddr, m_Flags&NETCONSOLE_FLAG_DROPSLOW);
 		if(m_pfnNewClient)
 			m_pfnNewClient(FreeSlot, m_UserPtr);
 		return 0;
@@ -143,8 +152,22 @@ int CNetConsole::Recv(char *pLine, int MaxLength, int *pClientID)
 
 int CNetConsole::Send(int ClientID, const char *pLine)
 {
-	if(m_aSlots[ClientID].m_Connection.State() == NET_CONNSTATE_ONLINE)
-		return m_aSlots[ClientID].m_Connection.Send(pLine);
-	else
+	if(m_aSlots[ClientID].m_Connection.State() != NET_CONNSTATE_ONLINE)
+		return -1;
+
+	// only fails when the client doesn't read fast enough, it's dropped on the next update
+	if(m_aSlots[ClientID].m_Connection.Send(pLine))
+	{
+		m_NumDroppedClients++;
 		return -1;
+	}
+	return 0;
+}
+
+int CNetConsole::NumDroppedLines() const
+{
+	int Num = m_NumDroppedLines;
+	for(int i = 0; i < NET_MAX_CONSOLE_CLIENTS; i++)
+		Num += m_aSlots[i].m_Connection.NumDroppedLines();
+	return Num;
 }
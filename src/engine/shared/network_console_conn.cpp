@@ -15,6 +15,12 @@ void CConsoleNetConnection::Reset()
 	m_aBuffer[0] = 0;
 	m_BufferOffset = 0;
 
+	m_SendBuffer.Init();
+	m_SendLineSize = 0;
+	m_SendLineOffset = 0;
+	m_DropSlow = false;
+	m_NumDroppedLines = 0;
+
 	m_LineEndingDetected = false;
 	#if defined(CONF_FAMILY_WINDOWS)
 		m_aLineEnding[0] = '\r';
@@ -27,12 +33,13 @@ void CConsoleNetConnection::Reset()
 	#endif
 }
 
-void CConsoleNetConnection::Init(NETSOCKET Socket, const NETADDR *pAddr)
+void CConsoleNetConnection::Init(NETSOCKET Socket, const NETADDR *pAddr, bool DropSlow)
 {
 	Reset();
 
 	m_Socket = Socket;
 	net_set_non_blocking(m_Socket);
+	m_DropSlow = DropSlow;
 
 	m_PeerAddr = *pAddr;
 	m_State = NET_CONNSTATE_ONLINE;
@@ -43,18 +50,56 @@ void CConsoleNetConnection::Disconnect(const char *pReason)
 	if(State() == NET_CONNSTATE_OFFLINE)
 		return;
 
+	// send what still fits without blocking
 	if(pReason && pReason[0])
 		Send(pReason);
+	Flush();
 
 	net_tcp_close(m_Socket);
 
 	Reset();
 }
 
+int CConsoleNetConnection::Flush()
+{
+	while(true)
+	{
+		// take the next line out of the ring buffer
+		if(m_SendLineOffset == m_SendLineSize)
+		{
+			char *pLine = m_SendBuffer.First();
+			if(!pLine)
+				return 0;
+			m_SendLineSize = str_length(pLine);
+			m_SendLineOffset = 0;
+			mem_copy(m_aSendLine, pLine, m_SendLineSize);
+			m_SendBuffer.PopFirst();
+		}
+
+		int Send = net_tcp_send(m_Socket, m_aSendLine+m_SendLineOffset, m_SendLineSize-m_SendLineOffset);
+		if(Send < 0)
+		{
+			if(net_would_block()) // try again next update
+				return 0;
+
+			m_State = NET_CONNSTATE_ERROR;
+			str_copy(m_aErrorString, "failed to send packet", sizeof(m_aErrorString));
+			return -1;
+		}
+
+		m_SendLineOffset += Send;
+		if(m_SendLineOffset < m_SendLineSize)
+			return 0;
+	}
+}
+
 int CConsoleNetConnection::Update()
 {
 	if(State() == NET_CONNSTATE_ONLINE)
 	{
+		if(Flush())
+			return -1;
+
 		if((int)(sizeof(m_aBuffer)) <= m_BufferOffset)
 		{
 			m_State = NET_CONNSTATE_ERROR;
@@ -162,25 +207,25 @@ int CConsoleNetConnection::Send(const char *pLine)
 	aBuf[Length] = m_aLineEnding[0];
 	aBuf[Length+1] = m_aLineEnding[1];
 	aBuf[Length+2] = m_aLineEnding[2];
-	Length += 3;
-	const char *pData = aBuf;
+	Length = str_length(aBuf)+1;
 
-	while(true)
+	// queue the line, it's sent by the next update
+	char *pData = m_SendBuffer.Allocate(Length);
+	while(!pData)
 	{
-		int Send = net_tcp_send(m_Socket, pData, Length);
-		if(Send < 0)
+		if(m_DropSlow || !m_SendBuffer.First())
 		{
 			m_State = NET_CONNSTATE_ERROR;
-			str_copy(m_aErrorString, "failed to send packet", sizeof(m_aErrorString));
+			str_copy(m_aErrorString, "too weak connection (out of send buffer)", sizeof(m_aErrorString));
 			return -1;
 		}
 
-		if(Send >= Length)
-			break;
-
-		pData += Send;
-		Length -= Send;
+		// make room by dropping the oldest lines
+		m_SendBuffer.PopFirst();
+		m_NumDroppedLines++;
+		pData = m_SendBuffer.Allocate(Length);
 	}
+	mem_copy(pData, aBuf, Length);
 
 	return 0;
 }
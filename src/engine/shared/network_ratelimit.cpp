@@ -0,0 +1,165 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+
+#include "network.h"
+
+
+void CNetRateLimit::Init()
+{
+	mem_zero(this, sizeof(*this));
+	for(int i = 0; i < HASH_SIZE; i++)
+		m_aHash[i] = -1;
+	m_First = -1;
+	m_Last = -1;
+}
+
+unsigned CNetRateLimit::Hash(const NETADDR *pAddr)
+{
+	// the port is ignored
+	return net_addr_hash(pAddr, false)%HASH_SIZE;
+}
+
+void CNetRateLimit::Unlink(int Index)
+{
+	CEntry *pEntry = &m_aEntries[Index];
+	if(pEntry->m_Prev != -1)
+		m_aEntries[pEntry->m_Prev].m_Next = pEntry->m_Next;
+	else
+		m_First = pEntry->m_Next;
+	if(pEntry->m_Next != -1)
+		m_aEntries[pEntry->m_Next].m_Prev = pEntry->m_Prev;
+	else
+		m_Last = pEntry->m_Prev;
+}
+
+void CNetRateLimit::LinkFirst(int Index)
+{
+	CEntry *pEntry = &m_aEntries[Index];
+	pEntry->m_Prev = -1;
+	pEntry->m_Next = m_First;
+	if(m_First != -1)
+		m_aEntries[m_First].m_Prev = Index;
+	else
+		m_Last = Index;
+	m_First = Index;
+}
+
+int CNetRateLimit::Find(const NETADDR *pAddr, unsigned HashIndex) const
+{
+	for(int i = m_aHash[HashIndex]; i != -1; i = m_aEntries[i].m_HashNext)
+	{
+		if(net_addr_comp(&m_aEntries[i].m_Addr, pAddr) == 0)
+			return i;
+	}
+	return -1;
+}
+
+int CNetRateLimit::Insert(const NETADDR *pAddr, unsigned HashIndex, int64 Now)
+{
+	int Index;
+	if(m_NumEntries < MAX_ADDRESSES)
+		Index = m_NumEntries++;
+	else
+	{
+		// table is full, reuse the least recently seen address
+		Index = m_Last;
+		Unlink(Index);
+		int *pLink = &m_aHash[Hash(&m_aEntries[Index].m_Addr)];
+		while(*pLink != Index)
+			pLink = &m_aEntries[*pLink].m_HashNext;
+		*pLink = m_aEntries[Index].m_HashNext;
+		m_NumEvicted++;
+	}
+
+	// new addresses start with full buckets
+	CEntry *pEntry = &m_aEntries[Index];
+	pEntry->m_Addr = *pAddr;
+	for(int i = 0; i < NUM_TYPES; i++)
+		pEntry->m_aTokens[i] = m_aRate[i]*2.0f;
+	pEntry->m_LastTime = Now;
+	pEntry->m_NumDropped = 0;
+	pEntry->m_HashNext = m_aHash[HashIndex];
+	m_aHash[HashIndex] = Index;
+	LinkFirst(Index);
+	return Index;
+}
+
+bool CNetRateLimit::Allow(const NETADDR *pAddr, int Type)
+{
+	if(m_aRate[Type] <= 0)
+	{
+		m_aNumAllowed[Type]++;
+		return true;
+	}
+
+	NETADDR Addr = *pAddr;
+	Addr.port = 0;
+	unsigned HashIndex = Hash(&Addr);
+	int64 Now = time_get();
+
+	int Index = Find(&Addr, HashIndex);
+	if(Index == -1)
+		Index = Insert(&Addr, HashIndex, Now);
+	else if(Index != m_First)
+	{
+		Unlink(Index);
+		LinkFirst(Index);
+	}
+
+	// refill all buckets of this address, each one holds up to two seconds worth of packets
+	CEntry *pEntry = &m_aEntries[Index];
+	float Elapsed = (Now-pEntry->m_LastTime)/(float)time_freq();
+	pEntry->m_LastTime = Now;
+	for(int i = 0; i < NUM_TYPES; i++)
+		pEntry->m_aTokens[i] = min(pEntry->m_aTokens[i]+Elapsed*m_aRate[i], m_aRate[i]*2.0f);
+
+	if(pEntry->m_aTokens[Type] < 1.0f)
+	{
+		pEntry->m_NumDropped++;
+		m_aNumDropped[Type]++;
+		return false;
+	}
+
+	pEntry->m_aTokens[Type] -= 1.0f;
+	m_aNumAllowed[Type]++;
+	return true;
+}
+
+int CNetRateLimit::Classify(const unsigned char *pData, int Size)
+{
+	// only looks at the raw header, the packet is not validated yet
+	int Flags = Size > 0 ? pData[0]>>4 : 0;
+	if(Flags&NET_PACKETFLAG_CONNLESS)
+		return TYPE_CONNLESS;
+	if(Flags&NET_PACKETFLAG_CONTROL && !(Flags&NET_PACKETFLAG_COMPRESSION) &&
+		Size > NET_PACKETHEADERSIZE && pData[NET_PACKETHEADERSIZE] == NET_CTRLMSG_CONNECT)
+		return TYPE_CONNECT;
+	return TYPE_SESSION;
+}
+
+int CNetRateLimit::GetTopSources(CSource *pSources, int MaxSources) const
+{
+	// sorted by dropped packets, only addresses that got something dropped
+	int Num = 0;
+	for(int i = 0; i < m_NumEntries; i++)
+	{
+		if(m_aEntries[i].m_NumDropped == 0)
+			continue;
+
+		int Pos = Num < MaxSources ? Num++ : MaxSources;
+		while(Pos > 0 && pSources[Pos-1].m_NumDropped < m_aEntries[i].m_NumDropped)
+		{
+			if(Pos < MaxSources)
+				pSources[Pos] = pSources[Pos-1];
+			Pos--;
+		}
+		if(Pos < MaxSources)
+		{
+			pSources[Pos].m_Addr = m_aEntries[i].m_Addr;
+			pSources[Pos].m_NumDropped = m_aEntries[i].m_NumDropped;
+		}
+	}
+	return Num;
+}
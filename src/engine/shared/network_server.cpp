@@ -29,6 +29,8 @@ bool CNetServer::Open(NETADDR BindAddr, CNetBan *pNetBan, int MaxClients, int Ma
 
 	m_MaxClientsPerIP = MaxClientsPerIP;
 
+	m_RateLimit.Init();
+
 	for(int i = 0; i < NET_MAX_CLIENTS; i++)
 		m_aSlots[i].m_Connection.Init(m_Socket, true);
 
@@ -105,6 +107,10 @@ int CNetServer::Recv(CNetChunk *pChunk)
 		if(Bytes <= 0)
 			break;
 
+		// drop floods before spending any time on them
+		if(!m_RateLimit.Allow(&Addr, CNetRateLimit::Classify(m_RecvUnpacker.m_aBuffer, Bytes)))
+			continue;
+
 		if(CNetBase::UnpackPacket(m_RecvUnpacker.m_aBuffer, Bytes, &m_RecvUnpacker.m_Data) == 0)
 		{
 			// check if we just should drop the packet
@@ -254,3 +260,11 @@ void CNetServer::SetMaxClientsPerIP(int Max)
 
 	m_MaxClientsPerIP = Max;
 }
+
+void CNetServer::SetRateLimits(int Connect, int Connless, int Session)
+{
+	// packets per second for each source address, 0 disables the limit
+	m_RateLimit.SetRate(CNetRateLimit::TYPE_CONNECT, Connect);
+	m_RateLimit.SetRate(CNetRateLimit::TYPE_CONNLESS, Connless);
+	m_RateLimit.SetRate(CNetRateLimit::TYPE_SESSION, Session);
+}
@@ -37,6 +37,9 @@ public:
 	virtual int Init() = 0;
 	virtual int Update() = 0;
 	virtual int Shutdown() = 0;
+
+	// mixes made up voices for a while and reports how long it took, needs no audio device
+	virtual void Benchmark(int NumVoices, int Seconds) = 0;
 };
 
 extern IEngineSound *CreateEngineSound();
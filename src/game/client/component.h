@@ -12,17 +12,18 @@ protected:
 	friend class CGameClient;
 
 	CGameClient *m_pClient;
+	CRenderJob *m_pRenderJob;
 
 	// perhaps propagte pointers for these as well
 	class IKernel *Kernel() const { return m_pClient->Kernel(); }
-	class IGraphics *Graphics() const { return m_pClient->Graphics(); }
+	class IGraphics *Graphics() const { return m_pRenderJob && m_pRenderJob->m_Active ? m_pRenderJob->m_pRecorder : m_pClient->Graphics(); }
 	class ITextRender *TextRender() const { return m_pClient->TextRender(); }
 	class IClient *Client() const { return m_pClient->Client(); }
 	class IInput *Input() const { return m_pClient->Input(); }
 	class IStorage *Storage() const { return m_pClient->Storage(); }
 	class CUI *UI() const { return m_pClient->UI(); }
 	class ISound *Sound() const { return m_pClient->Sound(); }
-	class CRenderTools *RenderTools() const { return m_pClient->RenderTools(); }
+	class CRenderTools *RenderTools() const { return m_pRenderJob && m_pRenderJob->m_Active ? &m_pRenderJob->m_RenderTools : m_pClient->RenderTools(); }
 	class IConsole *Console() const { return m_pClient->Console(); }
 	class IDemoPlayer *DemoPlayer() const { return m_pClient->DemoPlayer(); }
 	class IDemoRecorder *DemoRecorder() const { return m_pClient->DemoRecorder(); }
@@ -30,8 +31,13 @@ protected:
 	class CLayers *Layers() const { return m_pClient->Layers(); }
 	class CCollision *Collision() const { return m_pClient->Collision(); }
 public:
+	CComponent() { m_pRenderJob = 0; }
 	virtual ~CComponent() {}
 
+	// components that only draw and don't touch shared state during OnRender can have it
+	// run on a render job, see cl_render_threads
+	virtual bool CanRecordParallel() const { return false; }
+
 	virtual void OnStateChange(int NewState, int OldState) {};
 	virtual void OnConsoleInit() {};
 	virtual void OnInit() {};
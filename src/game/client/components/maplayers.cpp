@@ -25,6 +25,14 @@ CMapLayers::CMapLayers(int t)
 	m_CurrentLocalTick = 0;
 	m_LastLocalTick = 0;
 	m_EnvelopeUpdate = false;
+	m_EnvTime = 0.0f;
+	m_EnvLastLocalTime = -1.0f;
+	m_pTilemapCaches = 0;
+}
+
+CMapLayers::~CMapLayers()
+{
+	delete [] m_pTilemapCaches;
 }
 
 void CMapLayers::OnInit()
@@ -32,6 +40,35 @@ void CMapLayers::OnInit()
 	m_pLayers = Layers();
 }
 
+void CMapLayers::OnMapLoad()
+{
+	delete [] m_pTilemapCaches;
+	m_pTilemapCaches = new CTilemapCache[m_pLayers->NumLayers()];
+
+	// build the tile layers on the same side of the game layer as OnRender renders them
+	bool PassedGameLayer = false;
+	for(int g = 0; g < m_pLayers->NumGroups(); g++)
+	{
+		CMapItemGroup *pGroup = m_pLayers->GetGroup(g);
+		for(int l = 0; l < pGroup->m_NumLayers; l++)
+		{
+			CMapItemLayer *pLayer = m_pLayers->GetLayer(pGroup->m_StartLayer+l);
+			if(pLayer == (CMapItemLayer*)m_pLayers->GameLayer())
+			{
+				PassedGameLayer = true;
+				continue;
+			}
+
+			if(pLayer->m_Type != LAYERTYPE_TILES || (m_Type == TYPE_BACKGROUND && PassedGameLayer) || (m_Type == TYPE_FOREGROUND && !PassedGameLayer))
+				continue;
+
+			CMapItemLayerTilemap *pTMap = (CMapItemLayerTilemap *)pLayer;
+			CTile *pTiles = (CTile *)m_pLayers->Map()->GetData(pTMap->m_Data);
+			m_pTilemapCaches[pGroup->m_StartLayer+l].Init(pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f);
+		}
+	}
+}
+
 void CMapLayers::EnvelopeUpdate()
 {
 	if(Client()->State() == IClient::STATE_DEMOPLAYBACK)
@@ -77,8 +114,9 @@ void CMapLayers::EnvelopeEval(float TimeOffset, int Env, float *pChannels, void
 
 	CMapItemEnvelope *pItem = (CMapItemEnvelope *)pThis->m_pLayers->Map()->GetItem(Start+Env, 0, 0);
 
-	static float s_Time = 0.0f;
-	static float s_LastLocalTime = pThis->Client()->LocalTime();
+	// kept per instance, both map layers may be evaluated at the same time on render jobs
+	if(pThis->m_EnvLastLocalTime < 0.0f)
+		pThis->m_EnvLastLocalTime = pThis->Client()->LocalTime();
 	if(pThis->Client()->State() == IClient::STATE_DEMOPLAYBACK)
 	{
 		const IDemoPlayer::CInfo *pInfo = pThis->DemoPlayer()->BaseInfo();
@@ -91,12 +129,12 @@ void CMapLayers::EnvelopeEval(float TimeOffset, int Env, float *pChannels, void
 				pThis->m_CurrentLocalTick = pInfo->m_CurrentTick;
 			}
 
-			s_Time = mix(pThis->m_LastLocalTick / (float)pThis->Client()->GameTickSpeed(),
+			pThis->m_EnvTime = mix(pThis->m_LastLocalTick / (float)pThis->Client()->GameTickSpeed(),
 						pThis->m_CurrentLocalTick / (float)pThis->Client()->GameTickSpeed(),
 						pThis->Client()->IntraGameTick());
 		}
 
-		pThis->RenderTools()->RenderEvalEnvelope(pPoints+pItem->m_StartPoint, pItem->m_NumPoints, 4, s_Time+TimeOffset, pChannels);
+		pThis->RenderTools()->RenderEvalEnvelope(pPoints+pItem->m_StartPoint, pItem->m_NumPoints, 4, pThis->m_EnvTime+TimeOffset, pChannels);
 	}
 	else
 	{
@@ -104,15 +142,15 @@ void CMapLayers::EnvelopeEval(float TimeOffset, int Env, float *pChannels, void
 		{
 			if(pItem->m_Version < 2 || pItem->m_Synchronized)
 			{
-				s_Time = mix((pThis->Client()->PrevGameTick()-pThis->m_pClient->m_Snap.m_pGameInfoObj->m_RoundStartTick) / (float)pThis->Client()->GameTickSpeed(),
+				pThis->m_EnvTime = mix((pThis->Client()->PrevGameTick()-pThis->m_pClient->m_Snap.m_pGameInfoObj->m_RoundStartTick) / (float)pThis->Client()->GameTickSpeed(),
 							(pThis->Client()->GameTick()-pThis->m_pClient->m_Snap.m_pGameInfoObj->m_RoundStartTick) / (float)pThis->Client()->GameTickSpeed(),
 							pThis->Client()->IntraGameTick());
 			}
 			else
-				s_Time += pThis->Client()->LocalTime()-s_LastLocalTime;
+				pThis->m_EnvTime += pThis->Client()->LocalTime()-pThis->m_EnvLastLocalTime;
 		}
-		pThis->RenderTools()->RenderEvalEnvelope(pPoints+pItem->m_StartPoint, pItem->m_NumPoints, 4, s_Time+TimeOffset, pChannels);
-		s_LastLocalTime = pThis->Client()->LocalTime();
+		pThis->RenderTools()->RenderEvalEnvelope(pPoints+pItem->m_StartPoint, pItem->m_NumPoints, 4, pThis->m_EnvTime+TimeOffset, pChannels);
+		pThis->m_EnvLastLocalTime = pThis->Client()->LocalTime();
 	}
 }
 
@@ -214,13 +252,13 @@ void CMapLayers::OnRender()
 					else
 						Graphics()->TextureSet(m_pClient->m_pMapimages->Get(pTMap->m_Image));
 
-					CTile *pTiles = (CTile *)m_pLayers->Map()->GetData(pTMap->m_Data);
+					CTilemapCache *pCache = &m_pTilemapCaches[pGroup->m_StartLayer+l];
 					Graphics()->BlendNone();
 					vec4 Color = vec4(pTMap->m_Color.r/255.0f, pTMap->m_Color.g/255.0f, pTMap->m_Color.b/255.0f, pTMap->m_Color.a/255.0f);
-					RenderTools()->RenderTilemap(pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE,
+					RenderTools()->RenderTilemapCached(pCache, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_OPAQUE,
 													EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
 					Graphics()->BlendNormal();
-					RenderTools()->RenderTilemap(pTiles, pTMap->m_Width, pTMap->m_Height, 32.0f, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT,
+					RenderTools()->RenderTilemapCached(pCache, Color, TILERENDERFLAG_EXTEND|LAYERRENDERFLAG_TRANSPARENT,
 													EnvelopeEval, this, pTMap->m_ColorEnv, pTMap->m_ColorEnvOffset);
 				}
 				else if(pLayer->m_Type == LAYERTYPE_QUADS)
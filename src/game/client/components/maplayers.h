@@ -11,6 +11,11 @@ class CMapLayers : public CComponent
 	int m_CurrentLocalTick;
 	int m_LastLocalTick;
 	bool m_EnvelopeUpdate;
+	float m_EnvTime;
+	float m_EnvLastLocalTime;
+
+	// one per map layer, only the tile layers this instance renders are built
+	class CTilemapCache *m_pTilemapCaches;
 
 	void MapScreenToGroup(float CenterX, float CenterY, CMapItemGroup *pGroup);
 	static void EnvelopeEval(float TimeOffset, int Env, float *pChannels, void *pUser);
@@ -22,8 +27,11 @@ public:
 	};
 
 	CMapLayers(int Type);
+	~CMapLayers();
 	virtual void OnInit();
+	virtual void OnMapLoad();
 	virtual void OnRender();
+	virtual bool CanRecordParallel() const { return true; }
 
 	void EnvelopeUpdate();
 };
@@ -71,11 +71,18 @@ void CSounds::OnInit()
 	ClearQueue();
 
 	// load sounds
-	if(g_Config.m_ClThreadsoundloading)
+	if(g_Config.m_ClAssetThreads > 0)
+	{
+		// the game client streams them in together with the images, queued sounds wait until they are published
+		m_SoundsFromAssetJobs = true;
+		m_WaitForSoundJob = true;
+	}
+	else if(g_Config.m_ClThreadsoundloading)
 	{
 		g_UserData.m_pGameClient = m_pClient;
 		g_UserData.m_Render = false;
 		m_pClient->Engine()->AddJob(&m_SoundJob, LoadSoundsThread, &g_UserData);
+		m_SoundsFromAssetJobs = false;
 		m_WaitForSoundJob = true;
 	}
 	else
@@ -83,6 +90,7 @@ void CSounds::OnInit()
 		g_UserData.m_pGameClient = m_pClient;
 		g_UserData.m_Render = true;
 		LoadSoundsThread(&g_UserData);
+		m_SoundsFromAssetJobs = false;
 		m_WaitForSoundJob = false;
 	}
 }
@@ -107,7 +115,7 @@ void CSounds::OnRender()
 	// check for sound initialisation
 	if(m_WaitForSoundJob)
 	{
-		if(m_SoundJob.Status() == CJob::STATE_DONE)
+		if(m_SoundsFromAssetJobs ? !m_pClient->SoundsPending() : m_SoundJob.Status() == CJob::STATE_DONE)
 			m_WaitForSoundJob = false;
 		else
 			return;
@@ -199,5 +207,6 @@ void CSounds::Stop(int SetId)
 	CDataSoundset *pSet = &g_pData->m_aSounds[SetId];
 
 	for(int i = 0; i < pSet->m_NumSounds; i++)
-		Sound()->Stop(pSet->m_aSounds[i].m_Id);
+		if(pSet->m_aSounds[i].m_Id != -1)
+			Sound()->Stop(pSet->m_aSounds[i].m_Id);
 }
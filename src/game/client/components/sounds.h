@@ -19,6 +19,7 @@ class CSounds : public CComponent
 	int64 m_QueueWaitTime;
 	class CJob m_SoundJob;
 	bool m_WaitForSoundJob;
+	bool m_SoundsFromAssetJobs;
 	
 	int GetSampleId(int SetId);
 
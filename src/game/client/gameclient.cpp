@@ -216,6 +216,14 @@ void CGameClient::OnConsoleInit()
 
 	//
 	m_SuppressEvents = false;
+	m_NumRenderJobs = 0;
+	m_paAssetJobs = 0;
+	m_NumAssetJobs = 0;
+	m_NumAssetsPending = 0;
+	m_NumSoundsPending = 0;
+	m_PredictionLastTick = -1;
+	m_NumPredictionSimulatedTicks = 0;
+	m_NumPredictionReusedTicks = 0;
 }
 
 void CGameClient::OnInit()
@@ -250,15 +258,65 @@ void CGameClient::OnInit()
 	if(!pDefaultFont)
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "gameclient", "failed to load font. filename='fonts/DejaVuSans.ttf'");
 
+	// images and sounds get decoded on asset threads when wanted, the components look at this while they init
+	if(g_Config.m_ClAssetThreads > 0)
+	{
+		int NumSoundFiles = 0;
+		for(int s = 0; s < g_pData->m_NumSounds; s++)
+			NumSoundFiles += g_pData->m_aSounds[s].m_NumSounds;
+		m_NumAssetJobs = g_pData->m_NumImages+NumSoundFiles;
+		m_paAssetJobs = new CAssetJob[m_NumAssetJobs];
+		m_AssetJobPool.Init(g_Config.m_ClAssetThreads);
+	}
+
 	// init all components
 	for(int i = m_All.m_Num-1; i >= 0; --i)
 		m_All.m_paComponents[i]->OnInit();
 
+	// setup render jobs for the components that can record on their own
+	if(g_Config.m_ClRenderThreads > 0)
+	{
+		for(int i = 0; i < m_All.m_Num && m_NumRenderJobs < MAX_RENDER_JOBS; i++)
+		{
+			if(!m_All.m_paComponents[i]->CanRecordParallel())
+				continue;
+
+			IGraphics *pRecorder = Graphics()->CreateRecorder();
+			if(!pRecorder)
+			{
+				Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "gameclient", "render threads need gfx_threaded, rendering everything on the main thread");
+				break;
+			}
+
+			CRenderJob *pJob = &m_aRenderJobs[m_NumRenderJobs++];
+			pJob->m_pComponent = m_All.m_paComponents[i];
+			pJob->m_pRecorder = pRecorder;
+			pJob->m_RenderTools.m_pGraphics = pRecorder;
+			pJob->m_RenderTools.m_pUI = UI();
+			pJob->m_Active = false;
+			pJob->m_pComponent->m_pRenderJob = pJob;
+		}
+
+		if(m_NumRenderJobs)
+		{
+			m_RenderJobPool.Init(g_Config.m_ClRenderThreads);
+
+			char aBuf[128];
+			str_format(aBuf, sizeof(aBuf), "recording %d components on %d render threads", m_NumRenderJobs, g_Config.m_ClRenderThreads);
+			Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "gameclient", aBuf);
+		}
+	}
+
 	// setup load amount// load textures
-	for(int i = 0; i < g_pData->m_NumImages; i++)
+	if(m_paAssetJobs)
+		StartAssetJobs();
+	else
 	{
-		g_pData->m_aImages[i].m_Id = Graphics()->LoadTexture(g_pData->m_aImages[i].m_pFilename, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, 0);
-		g_GameClient.m_pMenus->RenderLoading();
+		for(int i = 0; i < g_pData->m_NumImages; i++)
+		{
+			g_pData->m_aImages[i].m_Id = Graphics()->LoadTexture(g_pData->m_aImages[i].m_pFilename, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, 0);
+			g_GameClient.m_pMenus->RenderLoading();
+		}
 	}
 
 	for(int i = 0; i < m_All.m_Num; i++)
@@ -338,6 +396,7 @@ void CGameClient::OnReset()
 {
 	// clear out the invalid pointers
 	m_LastNewPredictedTick = -1;
+	InvalidatePrediction();
 	mem_zero(&g_GameClient.m_Snap, sizeof(g_GameClient.m_Snap));
 
 	for(int i = 0; i < MAX_CLIENTS; i++)
@@ -434,6 +493,10 @@ void CGameClient::OnRender()
 
 	return;*/
 
+	// hand over images and sounds that finished loading
+	if(m_NumAssetsPending)
+		PublishAssets();
+
 	// update the local character and spectate position
 	UpdatePositions();
 
@@ -441,8 +504,29 @@ void CGameClient::OnRender()
 	DispatchInput();
 
 	// render all systems
+	bool RenderJobsStarted = false;
 	for(int i = 0; i < m_All.m_Num; i++)
-		m_All.m_paComponents[i]->OnRender();
+	{
+		CRenderJob *pJob = m_All.m_paComponents[i]->m_pRenderJob;
+		if(!pJob)
+		{
+			m_All.m_paComponents[i]->OnRender();
+			continue;
+		}
+
+		// start them all at the first one, everything before it (like the camera) is done by then
+		if(!RenderJobsStarted)
+		{
+			StartRenderJobs();
+			RenderJobsStarted = true;
+		}
+
+		// play the recording back at the place where the component would have rendered
+		while(pJob->m_Job.Status() != CJob::STATE_DONE)
+			thread_yield();
+		Graphics()->RecorderPlay(pJob->m_pRecorder);
+		pJob->m_Active = false;
+	}
 
 	// clear new tick flags
 	m_NewTick = false;
@@ -566,7 +650,122 @@ void CGameClient::OnStateChange(int NewState, int OldState)
 		m_All.m_paComponents[i]->OnStateChange(NewState, OldState);
 }
 
-void CGameClient::OnShutdown() {}
+int CGameClient::RenderJobThread(void *pUser)
+{
+	CRenderJob *pJob = (CRenderJob *)pUser;
+	pJob->m_pComponent->OnRender();
+	return 0;
+}
+
+void CGameClient::StartRenderJobs()
+{
+	for(int i = 0; i < m_NumRenderJobs; i++)
+	{
+		CRenderJob *pJob = &m_aRenderJobs[i];
+		Graphics()->RecorderBegin(pJob->m_pRecorder);
+		pJob->m_Active = true;
+		m_RenderJobPool.Add(&pJob->m_Job, RenderJobThread, pJob);
+	}
+}
+
+int CGameClient::AssetJobThread(void *pUser)
+{
+	CAssetJob *pJob = (CAssetJob *)pUser;
+	if(pJob->m_IsSound)
+		return pJob->m_pGameClient->Sound()->LoadWV(pJob->m_pFilename);
+	if(str_length(pJob->m_pFilename) < 3)
+		return 0;
+	return pJob->m_pGameClient->Graphics()->LoadPNG(&pJob->m_Image, pJob->m_pFilename, IStorage::TYPE_ALL);
+}
+
+void CGameClient::StartAssetJobs()
+{
+	int Num = 0;
+	m_NumSoundsPending = 0;
+	for(int i = 0; i < g_pData->m_NumImages; i++)
+	{
+		CAssetJob *pJob = &m_paAssetJobs[Num++];
+		pJob->m_pFilename = g_pData->m_aImages[i].m_pFilename;
+		pJob->m_pId = &g_pData->m_aImages[i].m_Id;
+		pJob->m_IsSound = false;
+	}
+	for(int s = 0; s < g_pData->m_NumSounds; s++)
+	{
+		for(int i = 0; i < g_pData->m_aSounds[s].m_NumSounds; i++)
+		{
+			CAssetJob *pJob = &m_paAssetJobs[Num++];
+			pJob->m_pFilename = g_pData->m_aSounds[s].m_aSounds[i].m_pFilename;
+			pJob->m_pId = &g_pData->m_aSounds[s].m_aSounds[i].m_Id;
+			pJob->m_IsSound = true;
+			m_NumSoundsPending++;
+		}
+	}
+
+	// everything starts out as a placeholder (no texture, no sample) until it got published
+	for(int i = 0; i < m_NumAssetJobs; i++)
+	{
+		CAssetJob *pJob = &m_paAssetJobs[i];
+		pJob->m_pGameClient = this;
+		pJob->m_Published = false;
+		pJob->m_Image.m_pData = 0;
+		*pJob->m_pId = -1;
+		m_AssetJobPool.Add(&pJob->m_Job, AssetJobThread, pJob);
+	}
+	m_NumAssetsPending = m_NumAssetJobs;
+}
+
+void CGameClient::PublishAssets()
+{
+	for(int i = 0; i < m_NumAssetJobs; i++)
+	{
+		CAssetJob *pJob = &m_paAssetJobs[i];
+		if(pJob->m_Published || pJob->m_Job.Status() != CJob::STATE_DONE)
+			continue;
+
+		// textures can only be created on this thread
+		if(pJob->m_IsSound)
+		{
+			*pJob->m_pId = pJob->m_Job.Result();
+			m_NumSoundsPending--;
+		}
+		else if(pJob->m_Job.Result())
+		{
+			CImageInfo *pImg = &pJob->m_Image;
+			*pJob->m_pId = Graphics()->LoadTextureRaw(pImg->m_Width, pImg->m_Height, pImg->m_Format, pImg->m_pData, pImg->m_Format, 0);
+			mem_free(pImg->m_pData);
+			pImg->m_pData = 0;
+		}
+		else
+			*pJob->m_pId = Graphics()->LoadTexture(pJob->m_pFilename, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, 0);
+
+		pJob->m_Published = true;
+		m_NumAssetsPending--;
+	}
+}
+
+void CGameClient::OnShutdown()
+{
+	// the asset threads still write into the jobs
+	for(int i = 0; i < m_NumAssetJobs; i++)
+	{
+		while(m_paAssetJobs[i].m_Job.Status() != CJob::STATE_DONE)
+			thread_yield();
+		mem_free(m_paAssetJobs[i].m_Image.m_pData);
+	}
+	delete [] m_paAssetJobs;
+	m_paAssetJobs = 0;
+	m_NumAssetJobs = 0;
+	m_NumAssetsPending = 0;
+	m_NumSoundsPending = 0;
+
+	for(int i = 0; i < m_NumRenderJobs; i++)
+	{
+		m_aRenderJobs[i].m_pComponent->m_pRenderJob = 0;
+		Graphics()->DestroyRecorder(m_aRenderJobs[i].m_pRecorder);
+	}
+	m_NumRenderJobs = 0;
+}
+
 void CGameClient::OnEnterGame() {}
 
 void CGameClient::OnGameOver()
@@ -904,6 +1103,52 @@ void CGameClient::OnNewSnapshot()
 	}
 }
 
+CGameClient::CPredictionTick *CGameClient::PredictionTick(int Tick)
+{
+	return &m_aPredictionTicks[Tick%PREDICTION_CACHE_SIZE];
+}
+
+int CGameClient::FindPredictionResumeTick()
+{
+	// returns the first tick that has to be simulated again, the world before it is in the cache
+	int GameTick = Client()->GameTick();
+	int PredTick = Client()->PredGameTick();
+	if(m_PredictionLastTick < 0 || GameTick < m_PredictionFirstTick || GameTick > m_PredictionLastTick ||
+		PredTick-GameTick >= PREDICTION_CACHE_SIZE || m_PredictionLocalClientID != m_Snap.m_LocalClientID ||
+		mem_comp(&m_PredictionWorld.m_Tuning, &m_Tuning, sizeof(m_Tuning)) != 0)
+		return -1;
+
+	// the snapshot has to be exactly what we predicted for its tick
+	CPredictionTick *pBase = PredictionTick(GameTick);
+	if(pBase->m_Tick != GameTick)
+		return -1;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(m_Snap.m_aCharacters[i].m_Active != (m_PredictionWorld.m_apCharacters[i] != 0))
+			return -1;
+		if(!m_Snap.m_aCharacters[i].m_Active)
+			continue;
+
+		CNetObj_CharacterCore Core;
+		pBase->m_aCores[i].Write(&Core);
+		Core.m_Tick = m_Snap.m_aCharacters[i].m_Cur.m_Tick;
+		if(mem_comp(&Core, static_cast<CNetObj_CharacterCore *>(&m_Snap.m_aCharacters[i].m_Cur), sizeof(Core)) != 0)
+			return -1;
+	}
+
+	// and every tick after it has to see the same input as last time
+	int Tick = GameTick+1;
+	for(; Tick <= min(m_PredictionLastTick, PredTick); Tick++)
+	{
+		CPredictionTick *pTick = PredictionTick(Tick);
+		int *pInput = Client()->GetInput(Tick);
+		if(pTick->m_Tick != Tick || pTick->m_HasInput != (pInput != 0) ||
+			(pInput && mem_comp(&pTick->m_Input, pInput, sizeof(CNetObj_PlayerInput)) != 0))
+			break;
+	}
+	return Tick;
+}
+
 void CGameClient::OnPredict()
 {
 	// store the previous values so we can detect prediction errors
@@ -921,60 +1166,94 @@ void CGameClient::OnPredict()
 			m_PredictedChar.Read(m_Snap.m_pLocalCharacter);
 		if(m_Snap.m_pLocalPrevCharacter)
 			m_PredictedPrevChar.Read(m_Snap.m_pLocalPrevCharacter);
+		InvalidatePrediction();
 		return;
 	}
 
-	// repredict character
-	CWorldCore World;
-	World.m_Tuning = m_Tuning;
+	int GameTick = Client()->GameTick();
+	int PredTick = Client()->PredGameTick();
+	CWorldCore *pWorld = &m_PredictionWorld;
 
-	// search for players
-	for(int i = 0; i < MAX_CLIENTS; i++)
+	int ResumeTick = FindPredictionResumeTick();
+	if(ResumeTick < 0)
 	{
-		if(!m_Snap.m_aCharacters[i].m_Active)
-			continue;
+		// repredict character
+		pWorld->m_Tuning = m_Tuning;
+		CPredictionTick *pBase = PredictionTick(GameTick);
+		pBase->m_Tick = GameTick;
+		pBase->m_HasInput = false;
+
+		// search for players
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			pWorld->m_apCharacters[i] = 0;
+			if(!m_Snap.m_aCharacters[i].m_Active)
+				continue;
+
+			g_GameClient.m_aClients[i].m_Predicted.Init(pWorld, Collision());
+			pWorld->m_apCharacters[i] = &g_GameClient.m_aClients[i].m_Predicted;
+			g_GameClient.m_aClients[i].m_Predicted.Read(&m_Snap.m_aCharacters[i].m_Cur);
+			pBase->m_aCores[i] = g_GameClient.m_aClients[i].m_Predicted;
+		}
 
-		g_GameClient.m_aClients[i].m_Predicted.Init(&World, Collision());
-		World.m_apCharacters[i] = &g_GameClient.m_aClients[i].m_Predicted;
-		g_GameClient.m_aClients[i].m_Predicted.Read(&m_Snap.m_aCharacters[i].m_Cur);
+		m_PredictionLocalClientID = m_Snap.m_LocalClientID;
+		m_PredictionLastTick = GameTick;
+		ResumeTick = GameTick+1;
 	}
+	else if(ResumeTick <= PredTick)
+	{
+		// continue from the last tick that is still right
+		CPredictionTick *pResume = PredictionTick(ResumeTick-1);
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			if(pWorld->m_apCharacters[i])
+				*pWorld->m_apCharacters[i] = pResume->m_aCores[i];
+	}
+	m_PredictionFirstTick = GameTick;
+	m_NumPredictionReusedTicks += min(ResumeTick-1, PredTick)-GameTick;
 
 	// predict
-	for(int Tick = Client()->GameTick()+1; Tick <= Client()->PredGameTick(); Tick++)
+	for(int Tick = ResumeTick; Tick <= PredTick; Tick++)
 	{
-		// fetch the local
-		if(Tick == Client()->PredGameTick() && World.m_apCharacters[m_Snap.m_LocalClientID])
-			m_PredictedPrevChar = *World.m_apCharacters[m_Snap.m_LocalClientID];
+		CPredictionTick *pCache = PredictionTick(Tick);
+		pCache->m_Tick = Tick;
+		pCache->m_HasInput = false;
 
 		// first calculate where everyone should move
 		for(int c = 0; c < MAX_CLIENTS; c++)
 		{
-			if(!World.m_apCharacters[c])
+			if(!pWorld->m_apCharacters[c])
 				continue;
 
-			mem_zero(&World.m_apCharacters[c]->m_Input, sizeof(World.m_apCharacters[c]->m_Input));
+			mem_zero(&pWorld->m_apCharacters[c]->m_Input, sizeof(pWorld->m_apCharacters[c]->m_Input));
 			if(m_Snap.m_LocalClientID == c)
 			{
 				// apply player input
 				int *pInput = Client()->GetInput(Tick);
 				if(pInput)
-					World.m_apCharacters[c]->m_Input = *((CNetObj_PlayerInput*)pInput);
-				World.m_apCharacters[c]->Tick(true);
+				{
+					pWorld->m_apCharacters[c]->m_Input = *((CNetObj_PlayerInput*)pInput);
+					pCache->m_Input = pWorld->m_apCharacters[c]->m_Input;
+					pCache->m_HasInput = true;
+				}
+				pWorld->m_apCharacters[c]->Tick(true);
 			}
 			else
-				World.m_apCharacters[c]->Tick(false);
+				pWorld->m_apCharacters[c]->Tick(false);
 
 		}
 
 		// move all players and quantize their data
 		for(int c = 0; c < MAX_CLIENTS; c++)
 		{
-			if(!World.m_apCharacters[c])
+			if(!pWorld->m_apCharacters[c])
 				continue;
 
-			World.m_apCharacters[c]->Move();
-			World.m_apCharacters[c]->Quantize();
+			pWorld->m_apCharacters[c]->Move();
+			pWorld->m_apCharacters[c]->Quantize();
+			pCache->m_aCores[c] = *pWorld->m_apCharacters[c];
 		}
+		m_PredictionLastTick = Tick;
+		m_NumPredictionSimulatedTicks++;
 
 		// check if we want to trigger effects
 		if(Tick > m_LastNewPredictedTick)
@@ -982,10 +1261,10 @@ void CGameClient::OnPredict()
 			m_LastNewPredictedTick = Tick;
 			m_NewPredictedTick = true;
 
-			if(m_Snap.m_LocalClientID != -1 && World.m_apCharacters[m_Snap.m_LocalClientID])
+			if(m_Snap.m_LocalClientID != -1 && pWorld->m_apCharacters[m_Snap.m_LocalClientID])
 			{
-				vec2 Pos = World.m_apCharacters[m_Snap.m_LocalClientID]->m_Pos;
-				int Events = World.m_apCharacters[m_Snap.m_LocalClientID]->m_TriggeredEvents;
+				vec2 Pos = pWorld->m_apCharacters[m_Snap.m_LocalClientID]->m_Pos;
+				int Events = pWorld->m_apCharacters[m_Snap.m_LocalClientID]->m_TriggeredEvents;
 				if(Events&COREEVENT_GROUND_JUMP) g_GameClient.m_pSounds->PlayAndRecord(CSounds::CHN_WORLD, SOUND_PLAYER_JUMP, 1.0f, Pos);
 
 				/*if(events&COREEVENT_AIR_JUMP)
@@ -1001,9 +1280,13 @@ void CGameClient::OnPredict()
 				//if(events&COREEVENT_HOOK_RETRACT) snd_play_random(CHN_WORLD, SOUND_PLAYER_JUMP, 1.0f, pos);
 			}
 		}
+	}
 
-		if(Tick == Client()->PredGameTick() && World.m_apCharacters[m_Snap.m_LocalClientID])
-			m_PredictedChar = *World.m_apCharacters[m_Snap.m_LocalClientID];
+	// fetch the local
+	if(PredTick > GameTick && pWorld->m_apCharacters[m_Snap.m_LocalClientID])
+	{
+		m_PredictedPrevChar = PredictionTick(PredTick-1)->m_aCores[m_Snap.m_LocalClientID];
+		m_PredictedChar = PredictionTick(PredTick)->m_aCores[m_Snap.m_LocalClientID];
 	}
 
 	if(g_Config.m_Debug && g_Config.m_ClPredict && m_PredictedTick == Client()->PredGameTick())
@@ -6,10 +6,35 @@
 #include <base/vmath.h>
 #include <engine/client.h>
 #include <engine/console.h>
+#include <engine/shared/jobs.h>
 #include <game/layers.h>
 #include <game/gamecore.h>
 #include "render.h"
 
+// a component that records its drawing on a worker thread, see CComponent::CanRecordParallel
+class CRenderJob
+{
+public:
+	CJob m_Job;
+	class CComponent *m_pComponent;
+	class IGraphics *m_pRecorder;
+	CRenderTools m_RenderTools;
+	bool m_Active;
+};
+
+// an image or sound file that gets decoded on an asset thread and published on the main thread
+class CAssetJob
+{
+public:
+	CJob m_Job;
+	class CGameClient *m_pGameClient;
+	const char *m_pFilename;
+	int *m_pId;
+	bool m_IsSound;
+	bool m_Published;
+	CImageInfo m_Image;
+};
+
 class CGameClient : public IGameClient
 {
 	class CStack
@@ -49,6 +74,28 @@ class CGameClient : public IGameClient
 	class CCollision m_Collision;
 	CUI m_UI;
 
+	enum
+	{
+		MAX_RENDER_JOBS=8,
+	};
+
+	CRenderJob m_aRenderJobs[MAX_RENDER_JOBS];
+	int m_NumRenderJobs;
+	CJobPool m_RenderJobPool;
+
+	static int RenderJobThread(void *pUser);
+	void StartRenderJobs();
+
+	CAssetJob *m_paAssetJobs;
+	int m_NumAssetJobs;
+	int m_NumAssetsPending;
+	int m_NumSoundsPending;
+	CJobPool m_AssetJobPool;
+
+	static int AssetJobThread(void *pUser);
+	void StartAssetJobs();
+	void PublishAssets();
+
 	void DispatchInput();
 	void ProcessEvents();
 	void UpdatePositions();
@@ -56,6 +103,31 @@ class CGameClient : public IGameClient
 	int m_PredictedTick;
 	int m_LastNewPredictedTick;
 
+	// the predicted world after every tick since the snapshot, so the next prediction
+	// only has to simulate from the first tick where the snapshot or the input differs
+	enum
+	{
+		PREDICTION_CACHE_SIZE=64, // OnPredict never looks further ahead than 50 ticks
+	};
+
+	struct CPredictionTick
+	{
+		int m_Tick;
+		bool m_HasInput;
+		CNetObj_PlayerInput m_Input;
+		CCharacterCore m_aCores[MAX_CLIENTS];
+	};
+
+	CWorldCore m_PredictionWorld;
+	CPredictionTick m_aPredictionTicks[PREDICTION_CACHE_SIZE];
+	int m_PredictionFirstTick;
+	int m_PredictionLastTick;
+	int m_PredictionLocalClientID;
+
+	void InvalidatePrediction() { m_PredictionLastTick = -1; }
+	CPredictionTick *PredictionTick(int Tick);
+	int FindPredictionResumeTick();
+
 	int64 m_LastSendInfo;
 
 	static void ConTeam(IConsole::IResult *pResult, void *pUserData);
@@ -84,6 +156,11 @@ public:
 	class IFriends *Friends() { return m_pFriends; }
 
 	int NetobjNumCorrections() { return m_NetObjHandler.NumObjCorrections(); }
+	bool SoundsPending() const { return m_NumSoundsPending > 0; }
+
+	// prediction profiling
+	int m_NumPredictionSimulatedTicks;
+	int m_NumPredictionReusedTicks;
 	const char *NetobjCorrectedOn() { return m_NetObjHandler.CorrectedObjOn(); }
 
 	bool m_SuppressEvents;
@@ -216,6 +293,8 @@ public:
 	virtual const char *Version();
 	virtual const char *NetVersion();
 
+	virtual int NumAssetsPending() const { return m_NumAssetsPending; }
+
 
 	// actions
 	// TODO: move these
@@ -4,6 +4,7 @@
 #define GAME_CLIENT_RENDER_H
 
 #include <base/vmath.h>
+#include <engine/graphics.h>
 #include <game/mapitems.h>
 #include "ui.h"
 
@@ -39,6 +40,48 @@ enum
 	TILERENDERFLAG_EXTEND=4,
 };
 
+// prebuilt quads of a tile layer, split into chunks of CHUNK_SIZE*CHUNK_SIZE tiles
+// so rendering only has to pick the visible chunks and submit them
+class CTilemapCache
+{
+public:
+	enum
+	{
+		CHUNK_SIZE=32,
+
+		QUADS_OPAQUE=0,
+		QUADS_TRANSPARENT,
+		NUM_QUADTYPES
+	};
+
+	struct CChunk
+	{
+		// quads are sorted by type and then by row, this is the first quad of every row
+		int m_aRowStart[NUM_QUADTYPES][CHUNK_SIZE+1];
+	};
+
+	CTile *m_pTiles;
+	int m_Width;
+	int m_Height;
+	float m_Scale;
+	float m_TilesetScale; // the texture coordinates are adjusted for this scale
+
+	int m_NumChunksX;
+	int m_NumChunksY;
+	CChunk *m_pChunks;
+
+	int m_NumQuads;
+	IGraphics::CQuadVertex *m_pVertices;
+	CTile *m_pQuadTiles;
+
+	CTilemapCache();
+	~CTilemapCache();
+
+	void Init(CTile *pTiles, int Width, int Height, float Scale);
+	void Clear();
+	void UpdateTexCoords(float TilesetScale);
+};
+
 typedef void (*ENVELOPE_EVAL)(float TimeOffset, int Env, float *pChannels, void *pUser);
 
 class CRenderTools
@@ -73,6 +116,7 @@ public:
 	static void RenderEvalEnvelope(CEnvPoint *pPoints, int NumPoints, int Channels, float Time, float *pResult);
 	void RenderQuads(CQuad *pQuads, int NumQuads, int Flags, ENVELOPE_EVAL pfnEval, void *pUser);
 	void RenderTilemap(CTile *pTiles, int w, int h, float Scale, vec4 Color, int RenderFlags, ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset);
+	void RenderTilemapCached(CTilemapCache *pCache, vec4 Color, int RenderFlags, ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset);
 
 	// helpers
 	void MapscreenToWorld(float CenterX, float CenterY, float ParallaxX, float ParallaxY,
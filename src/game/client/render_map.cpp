@@ -137,10 +137,10 @@ void CRenderTools::RenderQuads(CQuad *pQuads, int NumQuads, int RenderFlags, ENV
 		Graphics()->SetColorVertex(Array, 4);
 
 		CPoint *pPoints = q->m_aPoints;
+		CPoint aRotated[4];
 
 		if(Rot != 0)
 		{
-			static CPoint aRotated[4];
 			aRotated[0] = q->m_aPoints[0];
 			aRotated[1] = q->m_aPoints[1];
 			aRotated[2] = q->m_aPoints[2];
@@ -163,6 +163,62 @@ void CRenderTools::RenderQuads(CQuad *pQuads, int NumQuads, int RenderFlags, ENV
 	Graphics()->QuadsEnd();
 }
 
+// texture coordinates of the four corners of a tile, nudged inwards so the neighbouring tiles of the tileset don't bleed in
+static void GetTileTexCoords(int Index, int Flags, float Frac, float Nudge, float *pCoords)
+{
+	float TexSize = 1024.0f;
+	int tx = Index%16;
+	int ty = Index/16;
+	int Px0 = tx*(1024/16);
+	int Py0 = ty*(1024/16);
+	int Px1 = Px0+(1024/16)-1;
+	int Py1 = Py0+(1024/16)-1;
+
+	float x0 = Nudge + Px0/TexSize+Frac;
+	float y0 = Nudge + Py0/TexSize+Frac;
+	float x1 = Nudge + Px1/TexSize-Frac;
+	float y1 = Nudge + Py0/TexSize+Frac;
+	float x2 = Nudge + Px1/TexSize-Frac;
+	float y2 = Nudge + Py1/TexSize-Frac;
+	float x3 = Nudge + Px0/TexSize+Frac;
+	float y3 = Nudge + Py1/TexSize-Frac;
+
+	if(Flags&TILEFLAG_VFLIP)
+	{
+		x0 = x2;
+		x1 = x3;
+		x2 = x3;
+		x3 = x0;
+	}
+
+	if(Flags&TILEFLAG_HFLIP)
+	{
+		y0 = y3;
+		y2 = y1;
+		y3 = y1;
+		y1 = y0;
+	}
+
+	if(Flags&TILEFLAG_ROTATE)
+	{
+		float Tmp = x0;
+		x0 = x3;
+		x3 = x2;
+		x2 = x1;
+		x1 = Tmp;
+		Tmp = y0;
+		y0 = y3;
+		y3 = y2;
+		y2 = y1;
+		y1 = Tmp;
+	}
+
+	pCoords[0] = x0; pCoords[1] = y0;
+	pCoords[2] = x1; pCoords[3] = y1;
+	pCoords[4] = x2; pCoords[5] = y2;
+	pCoords[6] = x3; pCoords[7] = y3;
+}
+
 void CRenderTools::RenderTilemap(CTile *pTiles, int w, int h, float Scale, vec4 Color, int RenderFlags,
 									ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset)
 {
@@ -250,60 +306,244 @@ void CRenderTools::RenderTilemap(CTile *pTiles, int w, int h, float Scale, vec4
 
 				if(Render)
 				{
+					float aCoords[8];
+					GetTileTexCoords(Index, Flags, Frac, Nudge, aCoords);
 
-					int tx = Index%16;
-					int ty = Index/16;
-					int Px0 = tx*(1024/16);
-					int Py0 = ty*(1024/16);
-					int Px1 = Px0+(1024/16)-1;
-					int Py1 = Py0+(1024/16)-1;
-
-					float x0 = Nudge + Px0/TexSize+Frac;
-					float y0 = Nudge + Py0/TexSize+Frac;
-					float x1 = Nudge + Px1/TexSize-Frac;
-					float y1 = Nudge + Py0/TexSize+Frac;
-					float x2 = Nudge + Px1/TexSize-Frac;
-					float y2 = Nudge + Py1/TexSize-Frac;
-					float x3 = Nudge + Px0/TexSize+Frac;
-					float y3 = Nudge + Py1/TexSize-Frac;
-
-					if(Flags&TILEFLAG_VFLIP)
-					{
-						x0 = x2;
-						x1 = x3;
-						x2 = x3;
-						x3 = x0;
-					}
+					Graphics()->QuadsSetSubsetFree(aCoords[0], aCoords[1], aCoords[2], aCoords[3], aCoords[4], aCoords[5], aCoords[6], aCoords[7]);
+					IGraphics::CQuadItem QuadItem(x*Scale, y*Scale, Scale, Scale);
+					Graphics()->QuadsDrawTL(&QuadItem, 1);
+				}
+			}
+			x += pTiles[c].m_Skip;
+		}
 
-					if(Flags&TILEFLAG_HFLIP)
+	Graphics()->QuadsEnd();
+	Graphics()->MapScreen(ScreenX0, ScreenY0, ScreenX1, ScreenY1);
+}
+
+CTilemapCache::CTilemapCache()
+{
+	m_pTiles = 0;
+	m_Width = 0;
+	m_Height = 0;
+	m_Scale = 0.0f;
+	m_TilesetScale = 0.0f;
+	m_NumChunksX = 0;
+	m_NumChunksY = 0;
+	m_pChunks = 0;
+	m_NumQuads = 0;
+	m_pVertices = 0;
+	m_pQuadTiles = 0;
+}
+
+CTilemapCache::~CTilemapCache()
+{
+	Clear();
+}
+
+void CTilemapCache::Clear()
+{
+	delete [] m_pChunks;
+	delete [] m_pVertices;
+	delete [] m_pQuadTiles;
+	m_pChunks = 0;
+	m_pVertices = 0;
+	m_pQuadTiles = 0;
+	m_NumChunksX = 0;
+	m_NumChunksY = 0;
+	m_NumQuads = 0;
+}
+
+void CTilemapCache::Init(CTile *pTiles, int Width, int Height, float Scale)
+{
+	Clear();
+
+	m_pTiles = pTiles;
+	m_Width = Width;
+	m_Height = Height;
+	m_Scale = Scale;
+	m_TilesetScale = 0.0f; // texture coordinates get filled in on first use
+	m_NumChunksX = (Width+CHUNK_SIZE-1)/CHUNK_SIZE;
+	m_NumChunksY = (Height+CHUNK_SIZE-1)/CHUNK_SIZE;
+	m_pChunks = new CChunk[m_NumChunksX*m_NumChunksY];
+
+	for(int i = 0; i < Width*Height; i++)
+		if(pTiles[i].m_Index)
+			m_NumQuads++;
+	m_pVertices = new IGraphics::CQuadVertex[m_NumQuads*4];
+	m_pQuadTiles = new CTile[m_NumQuads];
+
+	int Quad = 0;
+	for(int cy = 0; cy < m_NumChunksY; cy++)
+		for(int cx = 0; cx < m_NumChunksX; cx++)
+		{
+			CChunk *pChunk = &m_pChunks[cy*m_NumChunksX+cx];
+			int EndX = min((cx+1)*(int)CHUNK_SIZE, Width);
+
+			for(int Type = 0; Type < NUM_QUADTYPES; Type++)
+			{
+				for(int r = 0; r < CHUNK_SIZE; r++)
+				{
+					pChunk->m_aRowStart[Type][r] = Quad;
+
+					int y = cy*CHUNK_SIZE+r;
+					if(y >= Height)
+						continue;
+
+					for(int x = cx*CHUNK_SIZE; x < EndX; x++)
 					{
-						y0 = y3;
-						y2 = y1;
-						y3 = y1;
-						y1 = y0;
+						CTile *pTile = &pTiles[y*Width+x];
+						if(!pTile->m_Index || (pTile->m_Flags&TILEFLAG_OPAQUE ? QUADS_OPAQUE : QUADS_TRANSPARENT) != Type)
+							continue;
+
+						IGraphics::CQuadVertex *pVertices = &m_pVertices[Quad*4];
+						pVertices[0] = IGraphics::CQuadVertex(x*Scale, y*Scale, 0.0f, 0.0f);
+						pVertices[1] = IGraphics::CQuadVertex(x*Scale+Scale, y*Scale, 0.0f, 0.0f);
+						pVertices[2] = IGraphics::CQuadVertex(x*Scale+Scale, y*Scale+Scale, 0.0f, 0.0f);
+						pVertices[3] = IGraphics::CQuadVertex(x*Scale, y*Scale+Scale, 0.0f, 0.0f);
+						m_pQuadTiles[Quad] = *pTile;
+						Quad++;
 					}
+				}
+				pChunk->m_aRowStart[Type][CHUNK_SIZE] = Quad;
+			}
+		}
+}
 
-					if(Flags&TILEFLAG_ROTATE)
-					{
-						float Tmp = x0;
-						x0 = x3;
-						x3 = x2;
-						x2 = x1;
-						x1 = Tmp;
-						Tmp = y0;
-						y0 = y3;
-						y3 = y2;
-						y2 = y1;
-						y1 = Tmp;
- 					}
-
-					Graphics()->QuadsSetSubsetFree(x0, y0, x1, y1, x2, y2, x3, y3);
-					IGraphics::CQuadItem QuadItem(x*Scale, y*Scale, Scale, Scale);
-					Graphics()->QuadsDrawTL(&QuadItem, 1);
+void CTilemapCache::UpdateTexCoords(float TilesetScale)
+{
+	// adjust the texture shift according to mipmap level
+	float TexSize = 1024.0f;
+	float Frac = (1.25f/TexSize) * (1/TilesetScale);
+	float Nudge = (0.5f/TexSize) * (1/TilesetScale);
+
+	for(int i = 0; i < m_NumQuads; i++)
+	{
+		float aCoords[8];
+		GetTileTexCoords(m_pQuadTiles[i].m_Index, m_pQuadTiles[i].m_Flags, Frac, Nudge, aCoords);
+		for(int c = 0; c < 4; c++)
+		{
+			m_pVertices[i*4+c].m_U = aCoords[c*2];
+			m_pVertices[i*4+c].m_V = aCoords[c*2+1];
+		}
+	}
+
+	m_TilesetScale = TilesetScale;
+}
+
+void CRenderTools::RenderTilemapCached(CTilemapCache *pCache, vec4 Color, int RenderFlags,
+									ENVELOPE_EVAL pfnEval, void *pUser, int ColorEnv, int ColorEnvOffset)
+{
+	float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
+	Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
+
+	// calculate the final pixelsize for the tiles
+	float Scale = pCache->m_Scale;
+	float TilePixelSize = 1024/32.0f;
+	float FinalTileSize = Scale/(ScreenX1-ScreenX0) * Graphics()->ScreenWidth();
+	float FinalTilesetScale = FinalTileSize/TilePixelSize;
+
+	float r=1, g=1, b=1, a=1;
+	if(ColorEnv >= 0)
+	{
+		float aChannels[4];
+		pfnEval(ColorEnvOffset/1000.0f, ColorEnv, aChannels, pUser);
+		r = aChannels[0];
+		g = aChannels[1];
+		b = aChannels[2];
+		a = aChannels[3];
+	}
+
+	// opaque tiles only count as such while the whole layer is opaque
+	bool aRender[CTilemapCache::NUM_QUADTYPES];
+	if(Color.a*a > 254.0f/255.0f)
+	{
+		aRender[CTilemapCache::QUADS_OPAQUE] = (RenderFlags&LAYERRENDERFLAG_OPAQUE) != 0;
+		aRender[CTilemapCache::QUADS_TRANSPARENT] = (RenderFlags&LAYERRENDERFLAG_TRANSPARENT) != 0;
+	}
+	else
+	{
+		aRender[CTilemapCache::QUADS_OPAQUE] = (RenderFlags&LAYERRENDERFLAG_TRANSPARENT) != 0;
+		aRender[CTilemapCache::QUADS_TRANSPARENT] = (RenderFlags&LAYERRENDERFLAG_TRANSPARENT) != 0;
+	}
+
+	if(!aRender[CTilemapCache::QUADS_OPAQUE] && !aRender[CTilemapCache::QUADS_TRANSPARENT])
+		return;
+
+	if(pCache->m_TilesetScale != FinalTilesetScale)
+		pCache->UpdateTexCoords(FinalTilesetScale);
+
+	Graphics()->QuadsBegin();
+	Graphics()->SetColor(Color.r*r, Color.g*g, Color.b*b, Color.a*a);
+
+	int StartY = (int)(ScreenY0/Scale)-1;
+	int StartX = (int)(ScreenX0/Scale)-1;
+	int EndY = (int)(ScreenY1/Scale)+1;
+	int EndX = (int)(ScreenX1/Scale)+1;
+
+	int w = pCache->m_Width;
+	int h = pCache->m_Height;
+
+	// the part inside the map comes straight from the visible chunks
+	int MapStartX = max(StartX, 0);
+	int MapStartY = max(StartY, 0);
+	int MapEndX = min(EndX, w);
+	int MapEndY = min(EndY, h);
+	if(MapStartX < MapEndX && MapStartY < MapEndY)
+	{
+		for(int cy = MapStartY/CTilemapCache::CHUNK_SIZE; cy <= (MapEndY-1)/CTilemapCache::CHUNK_SIZE; cy++)
+		{
+			int FirstRow = max(MapStartY-cy*CTilemapCache::CHUNK_SIZE, 0);
+			int EndRow = min(MapEndY-cy*CTilemapCache::CHUNK_SIZE, (int)CTilemapCache::CHUNK_SIZE);
+
+			for(int cx = MapStartX/CTilemapCache::CHUNK_SIZE; cx <= (MapEndX-1)/CTilemapCache::CHUNK_SIZE; cx++)
+			{
+				const CTilemapCache::CChunk *pChunk = &pCache->m_pChunks[cy*pCache->m_NumChunksX+cx];
+				for(int Type = 0; Type < CTilemapCache::NUM_QUADTYPES; Type++)
+				{
+					if(!aRender[Type])
+						continue;
+
+					int First = pChunk->m_aRowStart[Type][FirstRow];
+					int Num = pChunk->m_aRowStart[Type][EndRow] - First;
+					if(Num)
+						Graphics()->QuadsDrawVertices(&pCache->m_pVertices[First*4], Num);
 				}
 			}
-			x += pTiles[c].m_Skip;
 		}
+	}
+
+	// outside of the map the border tiles get repeated
+	if(RenderFlags&TILERENDERFLAG_EXTEND)
+	{
+		float TexSize = 1024.0f;
+		float Frac = (1.25f/TexSize) * (1/FinalTilesetScale);
+		float Nudge = (0.5f/TexSize) * (1/FinalTilesetScale);
+
+		for(int y = StartY; y < EndY; y++)
+		{
+			bool InsideY = y >= 0 && y < h;
+			for(int x = StartX; x < EndX; x++)
+			{
+				// skip the part that came from the chunks
+				if(InsideY && x >= 0 && x < w)
+				{
+					x = w-1;
+					continue;
+				}
+
+				CTile *pTile = &pCache->m_pTiles[clamp(y, 0, h-1)*w + clamp(x, 0, w-1)];
+				if(!pTile->m_Index || !aRender[pTile->m_Flags&TILEFLAG_OPAQUE ? CTilemapCache::QUADS_OPAQUE : CTilemapCache::QUADS_TRANSPARENT])
+					continue;
+
+				float aCoords[8];
+				GetTileTexCoords(pTile->m_Index, pTile->m_Flags, Frac, Nudge, aCoords);
+				Graphics()->QuadsSetSubsetFree(aCoords[0], aCoords[1], aCoords[2], aCoords[3], aCoords[4], aCoords[5], aCoords[6], aCoords[7]);
+				IGraphics::CQuadItem QuadItem(x*Scale, y*Scale, Scale, Scale);
+				Graphics()->QuadsDrawTL(&QuadItem, 1);
+			}
+		}
+	}
 
 	Graphics()->QuadsEnd();
 	Graphics()->MapScreen(ScreenX0, ScreenY0, ScreenX1, ScreenY1);
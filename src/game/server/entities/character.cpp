@@ -258,6 +258,7 @@ void CCharacter::FireWeapon()
 					if(GameServer()->IsBomb(m_pPlayer->GetCID()) && !GameServer()->IsBomb(pTarget->GetPlayer()->GetCID())) {
 //						if (GameServer()->CanHammerBack(pTarget->GetPlayer()->GetCID())) {
 							GameServer()->PassBID(pTarget->GetPlayer()->GetCID(), m_pPlayer->GetCID());
+							Server()->SendEvent(IServer::EVENT_BOMBPASS, pTarget->GetPlayer()->GetCID(), m_pPlayer->GetCID());
 //							GameServer()->SetHammerBack(g_Config.m_SvHammerBackDelay*Server()->TickSpeed()/1000);
 							if (pTarget->GetPlayer()->m_StunTick >= -100*Server()->TickSpeed()/1000)
 							{
@@ -605,7 +606,8 @@ void CCharacter::Tick()
 		if (g_Config.m_SvBombBroadcast)
 		{
 			char bBuf[128];
-			if (GameServer()->IsBomb(m_pPlayer->GetCID()))
+			bool IsCountdown = GameServer()->IsBomb(m_pPlayer->GetCID());
+			if (IsCountdown)
 			{
 				str_format(bBuf, sizeof(bBuf), "You are the bomb! Hit someone in %d seconds or you'll explode!", (int) CurrentFuse);
 			}
@@ -636,7 +638,7 @@ void CCharacter::Tick()
 
 //				}
 			}
-			GameServer()->SendBroadcast(bBuf,m_pPlayer->GetCID());
+			GameServer()->SendBroadcast(bBuf,m_pPlayer->GetCID(), !IsCountdown);
 		}
 
 		//TODO: update to handle multiple bombs
@@ -784,6 +786,8 @@ void CCharacter::Die(int Killer, int Weapon)
 		m_pPlayer->GetCID(), Server()->ClientName(m_pPlayer->GetCID()), Weapon, ModeSpecial);
 	GameServer()->Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "game", aBuf);
 
+	Server()->SendEvent(IServer::EVENT_KILL, m_pPlayer->GetCID(), Killer, Weapon);
+
 	// send the kill message
 	CNetMsg_Sv_KillMsg Msg;
 	Msg.m_Killer = Killer;
@@ -34,8 +34,18 @@ void CGameContext::Construct(int Resetting)
 	m_VoteCloseTime = 0;
 	m_pVoteOptionFirst = 0;
 	m_pVoteOptionLast = 0;
+	m_pVoteOptionPending = 0;
+	mem_zero(m_apVoteOptionHash, sizeof(m_apVoteOptionHash));
 	m_NumVoteOptions = 0;
+	m_NumVoteOptionsRemoved = 0;
 	m_LockTeams = 0;
+	m_TuningChanged = false;
+	mem_zero(m_aVoteIPs, sizeof(m_aVoteIPs));
+	m_VoteTotal = 0;
+	m_VoteYes = 0;
+	m_VoteNo = 0;
+	mem_zero(m_aBroadcasts, sizeof(m_aBroadcasts));
+	m_GlobalBroadcastPending = false;
 
 	m_BombIDs = -1;
 
@@ -58,7 +68,11 @@ CGameContext::~CGameContext()
 	for(int i = 0; i < MAX_CLIENTS; i++)
 		delete m_apPlayers[i];
 	if(!m_Resetting)
+	{
+		for(CVoteOptionServer *pOption = m_pVoteOptionFirst; pOption; pOption = pOption->m_pNext)
+			delete pOption->m_pCompiled;
 		delete m_pVoteOptionHeap;
+	}
 }
 
 void CGameContext::Clear()
@@ -66,7 +80,11 @@ void CGameContext::Clear()
 	CHeap *pVoteOptionHeap = m_pVoteOptionHeap;
 	CVoteOptionServer *pVoteOptionFirst = m_pVoteOptionFirst;
 	CVoteOptionServer *pVoteOptionLast = m_pVoteOptionLast;
+	CVoteOptionServer *pVoteOptionPending = m_pVoteOptionPending;
+	CVoteOptionServer *apVoteOptionHash[VOTE_OPTION_HASH_SIZE];
+	mem_copy(apVoteOptionHash, m_apVoteOptionHash, sizeof(apVoteOptionHash));
 	int NumVoteOptions = m_NumVoteOptions;
+	int NumVoteOptionsRemoved = m_NumVoteOptionsRemoved;
 	CTuningParams Tuning = m_Tuning;
 
 	m_Resetting = true;
@@ -77,7 +95,10 @@ void CGameContext::Clear()
 	m_pVoteOptionHeap = pVoteOptionHeap;
 	m_pVoteOptionFirst = pVoteOptionFirst;
 	m_pVoteOptionLast = pVoteOptionLast;
+	m_pVoteOptionPending = pVoteOptionPending;
+	mem_copy(m_apVoteOptionHash, apVoteOptionHash, sizeof(m_apVoteOptionHash));
 	m_NumVoteOptions = NumVoteOptions;
+	m_NumVoteOptionsRemoved = NumVoteOptionsRemoved;
 	m_Tuning = Tuning;
 }
 
@@ -291,11 +312,44 @@ void CGameContext::SendWeaponPickup(int ClientID, int Weapon)
 }
 
 
-void CGameContext::SendBroadcast(const char *pText, int ClientID)
+void CGameContext::SendBroadcast(const char *pText, int ClientID, bool IsImportant)
 {
+	// global broadcasts get sent once at the end of the tick
+	if(ClientID == -1)
+	{
+		str_copy(m_aGlobalBroadcast, pText, sizeof(m_aGlobalBroadcast));
+		m_GlobalBroadcastPending = true;
+		return;
+	}
+
+	// skip texts the client already shows, empty ones don't need a refresh
+	CBroadcastState *pState = &m_aBroadcasts[ClientID];
+	if(str_comp(pState->m_aText, pText) == 0 && (!pText[0] || pState->m_SendTick+Server()->TickSpeed()*BROADCAST_REFRESH_TIME > Server()->Tick()))
+		return;
+	str_copy(pState->m_aText, pText, sizeof(pState->m_aText));
+	pState->m_SendTick = Server()->Tick();
+
+	// unimportant ones (e.g. countdowns) get replaced soon anyway, so losing them is fine
 	CNetMsg_Sv_Broadcast Msg;
 	Msg.m_pMessage = pText;
-	Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, ClientID);
+	Server()->SendPackMsg(&Msg, IsImportant ? MSGFLAG_VITAL : 0, ClientID);
+}
+
+void CGameContext::FlushBroadcasts()
+{
+	if(!m_GlobalBroadcastPending)
+		return;
+
+	CNetMsg_Sv_Broadcast Msg;
+	Msg.m_pMessage = m_aGlobalBroadcast;
+	Server()->SendPackMsg(&Msg, MSGFLAG_VITAL, -1);
+	m_GlobalBroadcastPending = false;
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		str_copy(m_aBroadcasts[i].m_aText, m_aGlobalBroadcast, sizeof(m_aBroadcasts[i].m_aText));
+		m_aBroadcasts[i].m_SendTick = Server()->Tick();
+	}
 }
 
 //
@@ -314,7 +368,11 @@ void CGameContext::StartVote(const char *pDesc, const char *pCommand, const char
 			m_apPlayers[i]->m_Vote = 0;
 			m_apPlayers[i]->m_VotePos = 0;
 		}
+		m_aVoteIPs[i].m_Vote = 0;
+		m_aVoteIPs[i].m_VotePos = 0;
 	}
+	m_VoteYes = 0;
+	m_VoteNo = 0;
 
 	// start vote
 	m_VoteCloseTime = time_get() + time_freq()*25;
@@ -369,6 +427,259 @@ void CGameContext::AbortVoteKickOnDisconnect(int ClientID)
 		m_VoteCloseTime = -1;
 }
 
+void CGameContext::SetPlayerVote(int ClientID, int Vote)
+{
+	CPlayer *pPlayer = m_apPlayers[ClientID];
+	pPlayer->m_Vote = Vote;
+	pPlayer->m_VotePos = ++m_VotePos;
+	m_VoteUpdate = true;
+
+	if(pPlayer->m_VoteIP == -1)
+		return;
+
+	// only the first vote from an address counts
+	CVoteIP *pIP = &m_aVoteIPs[pPlayer->m_VoteIP];
+	if(pIP->m_Vote)
+		return;
+	pIP->m_Vote = pPlayer->m_Vote;
+	pIP->m_VotePos = pPlayer->m_VotePos;
+	if(pIP->m_NumActive)
+	{
+		if(pIP->m_Vote > 0)
+			m_VoteYes++;
+		else
+			m_VoteNo++;
+	}
+}
+
+void CGameContext::UpdateVoteIP(int Slot)
+{
+	CVoteIP *pIP = &m_aVoteIPs[Slot];
+
+	// remove the old contribution
+	if(pIP->m_NumActive)
+	{
+		m_VoteTotal--;
+		if(pIP->m_Vote > 0)
+			m_VoteYes--;
+		else if(pIP->m_Vote < 0)
+			m_VoteNo--;
+	}
+
+	// recount the clients of this address, only happens on enter, drop and team changes
+	pIP->m_NumClients = 0;
+	pIP->m_NumActive = 0;
+	pIP->m_Vote = 0;
+	pIP->m_VotePos = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(!m_apPlayers[i] || m_apPlayers[i]->m_VoteIP != Slot)
+			continue;
+
+		pIP->m_NumClients++;
+		if(m_apPlayers[i]->m_PreferredTeam != TEAM_SPECTATORS)	// don't count in votes by spectators
+			pIP->m_NumActive++;
+		if(m_apPlayers[i]->m_Vote && (!pIP->m_Vote || pIP->m_VotePos > m_apPlayers[i]->m_VotePos))
+		{
+			pIP->m_Vote = m_apPlayers[i]->m_Vote;
+			pIP->m_VotePos = m_apPlayers[i]->m_VotePos;
+		}
+	}
+
+	// add the new one
+	if(pIP->m_NumActive)
+	{
+		m_VoteTotal++;
+		if(pIP->m_Vote > 0)
+			m_VoteYes++;
+		else if(pIP->m_Vote < 0)
+			m_VoteNo++;
+	}
+
+	m_VoteUpdate = true;
+}
+
+
+static unsigned VoteOptionHash(const char *pDescription)
+{
+	// case insensitive, option descriptions are compared with str_comp_nocase
+	unsigned Hash = 5381;
+	for(; *pDescription; pDescription++)
+		Hash = ((Hash << 5) + Hash) + str_uppercase(*pDescription);
+	return Hash%CGameContext::VOTE_OPTION_HASH_SIZE;
+}
+
+CVoteOptionServer *CGameContext::FindVoteOption(const char *pDescription)
+{
+	CVoteOptionServer *pOption = m_apVoteOptionHash[VoteOptionHash(pDescription)];
+	while(pOption && str_comp_nocase(pDescription, pOption->m_aDescription) != 0)
+		pOption = pOption->m_pHashNext;
+	return pOption;
+}
+
+CVoteOptionServer *CGameContext::AddVoteOption(const char *pDescription, const char *pCommand)
+{
+	int Len = str_length(pCommand);
+	CVoteOptionServer *pOption = (CVoteOptionServer *)m_pVoteOptionHeap->Allocate(sizeof(CVoteOptionServer) + Len);
+	pOption->m_pNext = 0;
+	pOption->m_pPrev = m_pVoteOptionLast;
+	if(pOption->m_pPrev)
+		pOption->m_pPrev->m_pNext = pOption;
+	m_pVoteOptionLast = pOption;
+	if(!m_pVoteOptionFirst)
+		m_pVoteOptionFirst = pOption;
+	if(!m_pVoteOptionPending)
+		m_pVoteOptionPending = pOption;
+	pOption->m_Announced = false;
+	pOption->m_pCompiled = 0;
+
+	str_copy(pOption->m_aDescription, pDescription, sizeof(pOption->m_aDescription));
+	mem_copy(pOption->m_aCommand, pCommand, Len+1);
+
+	unsigned Hash = VoteOptionHash(pOption->m_aDescription);
+	pOption->m_pHashNext = m_apVoteOptionHash[Hash];
+	m_apVoteOptionHash[Hash] = pOption;
+
+	++m_NumVoteOptions;
+	return pOption;
+}
+
+void CGameContext::RemoveVoteOption(CVoteOptionServer *pOption)
+{
+	// unlink it
+	if(m_pVoteOptionPending == pOption)
+		m_pVoteOptionPending = pOption->m_pNext;
+	if(m_pVoteOptionFirst == pOption)
+		m_pVoteOptionFirst = pOption->m_pNext;
+	if(m_pVoteOptionLast == pOption)
+		m_pVoteOptionLast = pOption->m_pPrev;
+	if(pOption->m_pPrev)
+		pOption->m_pPrev->m_pNext = pOption->m_pNext;
+	if(pOption->m_pNext)
+		pOption->m_pNext->m_pPrev = pOption->m_pPrev;
+
+	CVoteOptionServer **ppHash = &m_apVoteOptionHash[VoteOptionHash(pOption->m_aDescription)];
+	while(*ppHash != pOption)
+		ppHash = &(*ppHash)->m_pHashNext;
+	*ppHash = pOption->m_pHashNext;
+
+	delete pOption->m_pCompiled;
+	--m_NumVoteOptions;
+	++m_NumVoteOptionsRemoved;
+
+	// the heap can't free single allocations, so rebuild it once more than half of it is unused
+	if(m_NumVoteOptionsRemoved <= m_NumVoteOptions)
+		return;
+
+	CHeap *pOldHeap = m_pVoteOptionHeap;
+	CVoteOptionServer *pSrc = m_pVoteOptionFirst;
+	CVoteOptionServer *pPending = m_pVoteOptionPending;
+	m_pVoteOptionHeap = new CHeap();
+	m_pVoteOptionFirst = 0;
+	m_pVoteOptionLast = 0;
+	m_pVoteOptionPending = 0;
+	mem_zero(m_apVoteOptionHash, sizeof(m_apVoteOptionHash));
+	m_NumVoteOptions = 0;
+	m_NumVoteOptionsRemoved = 0;
+	CVoteOptionServer *pNewPending = 0;
+	for(; pSrc; pSrc = pSrc->m_pNext)
+	{
+		CVoteOptionServer *pDst = AddVoteOption(pSrc->m_aDescription, pSrc->m_aCommand);
+		pDst->m_Announced = pSrc->m_Announced;
+		pDst->m_pCompiled = pSrc->m_pCompiled;
+		if(pSrc == pPending)
+			pNewPending = pDst;
+	}
+	m_pVoteOptionPending = pNewPending;
+	delete pOldHeap;
+}
+
+void CGameContext::ClearVoteOptions()
+{
+	for(CVoteOptionServer *pOption = m_pVoteOptionFirst; pOption; pOption = pOption->m_pNext)
+		delete pOption->m_pCompiled;
+	m_pVoteOptionHeap->Reset();
+	m_pVoteOptionFirst = 0;
+	m_pVoteOptionLast = 0;
+	m_pVoteOptionPending = 0;
+	mem_zero(m_apVoteOptionHash, sizeof(m_apVoteOptionHash));
+	m_NumVoteOptions = 0;
+	m_NumVoteOptionsRemoved = 0;
+}
+
+void CGameContext::ExecuteVoteOption(const char *pDescription, const char *pCommand)
+{
+	// kick and spectate votes or options whose command didn't compile get parsed
+	CVoteOptionServer *pOption = FindVoteOption(pDescription);
+	if(!pOption || !pOption->m_pCompiled || str_comp(pOption->m_aCommand, pCommand) != 0)
+	{
+		Console()->ExecuteLine(pCommand);
+		return;
+	}
+
+	// the command can remove its own option, so hold on to the compiled line while it runs
+	IConsole::ICompiledLine *pCompiled = pOption->m_pCompiled;
+	pOption->m_pCompiled = 0;
+	Console()->ExecuteCompiled(pCompiled);
+
+	pOption = FindVoteOption(pDescription);
+	if(pOption && !pOption->m_pCompiled && str_comp(pOption->m_aCommand, pCommand) == 0)
+		pOption->m_pCompiled = pCompiled;
+	else
+		delete pCompiled;
+}
+
+void CGameContext::SendVoteOptions(int ClientID, CVoteOptionServer *pFirst, CVoteOptionServer *pStop, int Flags)
+{
+	CVoteOptionServer *pCurrent = pFirst;
+	while(pCurrent != pStop)
+	{
+		// pack as many options as the message can carry
+		const char *apDescriptions[VOTE_OPTIONS_PER_MSG];
+		int NumOptions = 0;
+		for(; pCurrent != pStop && NumOptions < VOTE_OPTIONS_PER_MSG; pCurrent = pCurrent->m_pNext)
+			apDescriptions[NumOptions++] = pCurrent->m_aDescription;
+		for(int i = NumOptions; i < VOTE_OPTIONS_PER_MSG; i++)
+			apDescriptions[i] = "";
+
+		CNetMsg_Sv_VoteOptionListAdd OptionMsg;
+		OptionMsg.m_NumOptions = NumOptions;
+		OptionMsg.m_pDescription0 = apDescriptions[0];
+		OptionMsg.m_pDescription1 = apDescriptions[1];
+		OptionMsg.m_pDescription2 = apDescriptions[2];
+		OptionMsg.m_pDescription3 = apDescriptions[3];
+		OptionMsg.m_pDescription4 = apDescriptions[4];
+		OptionMsg.m_pDescription5 = apDescriptions[5];
+		OptionMsg.m_pDescription6 = apDescriptions[6];
+		OptionMsg.m_pDescription7 = apDescriptions[7];
+		OptionMsg.m_pDescription8 = apDescriptions[8];
+		OptionMsg.m_pDescription9 = apDescriptions[9];
+		OptionMsg.m_pDescription10 = apDescriptions[10];
+		OptionMsg.m_pDescription11 = apDescriptions[11];
+		OptionMsg.m_pDescription12 = apDescriptions[12];
+		OptionMsg.m_pDescription13 = apDescriptions[13];
+		OptionMsg.m_pDescription14 = apDescriptions[14];
+		Server()->SendPackMsg(&OptionMsg, Flags, ClientID);
+	}
+}
+
+void CGameContext::FlushVoteOptions()
+{
+	if(!m_pVoteOptionPending)
+		return;
+
+	// announce the options added since the last tick in batches
+	SendVoteOptions(-1, m_pVoteOptionPending, 0, MSGFLAG_VITAL);
+
+	// clients that already got the option list but aren't ingame yet
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		if(m_apPlayers[i] && m_apPlayers[i]->m_IsReady && !Server()->ClientIngame(i))
+			SendVoteOptions(i, m_pVoteOptionPending, 0, MSGFLAG_VITAL|MSGFLAG_NORECORD);
+
+	for(CVoteOptionServer *pOption = m_pVoteOptionPending; pOption; pOption = pOption->m_pNext)
+		pOption->m_Announced = true;
+	m_pVoteOptionPending = 0;
+}
 
 void CGameContext::CheckPureTuning()
 {
@@ -437,6 +748,14 @@ void CGameContext::OnTick()
 		}
 	}
 
+	FlushVoteOptions();
+
+	if(m_TuningChanged)
+	{
+		SendTuningParams(-1);
+		m_TuningChanged = false;
+	}
+
 	// update voting
 	if(m_VoteCloseTime)
 	{
@@ -448,54 +767,18 @@ void CGameContext::OnTick()
 		}
 		else
 		{
-			int Total = 0, Yes = 0, No = 0;
 			if(m_VoteUpdate)
 			{
-				// count votes
-				char aaBuf[MAX_CLIENTS][NETADDR_MAXSTRSIZE] = {{0}};
-				for(int i = 0; i < MAX_CLIENTS; i++)
-					if(m_apPlayers[i])
-						Server()->GetClientAddr(i, aaBuf[i], NETADDR_MAXSTRSIZE);
-				bool aVoteChecked[MAX_CLIENTS] = {0};
-				for(int i = 0; i < MAX_CLIENTS; i++)
-				{
-					if(!m_apPlayers[i] || m_apPlayers[i]->m_PreferredTeam == TEAM_SPECTATORS || aVoteChecked[i])	// don't count in votes by spectators
-						continue;
-
-					int ActVote = m_apPlayers[i]->m_Vote;
-					int ActVotePos = m_apPlayers[i]->m_VotePos;
-
-					// check for more players with the same ip (only use the vote of the one who voted first)
-					for(int j = i+1; j < MAX_CLIENTS; ++j)
-					{
-						if(!m_apPlayers[j] || aVoteChecked[j] || str_comp(aaBuf[j], aaBuf[i]))
-							continue;
-
-						aVoteChecked[j] = true;
-						if(m_apPlayers[j]->m_Vote && (!ActVote || ActVotePos > m_apPlayers[j]->m_VotePos))
-						{
-							ActVote = m_apPlayers[j]->m_Vote;
-							ActVotePos = m_apPlayers[j]->m_VotePos;
-						}
-					}
-
-					Total++;
-					if(ActVote > 0)
-						Yes++;
-					else if(ActVote < 0)
-						No++;
-				}
-
-				if(Yes >= Total/2+1)
+				if(m_VoteYes >= m_VoteTotal/2+1)
 					m_VoteEnforce = VOTE_ENFORCE_YES;
-				else if(No >= (Total+1)/2)
+				else if(m_VoteNo >= (m_VoteTotal+1)/2)
 					m_VoteEnforce = VOTE_ENFORCE_NO;
 			}
 
 			if(m_VoteEnforce == VOTE_ENFORCE_YES)
 			{
 				Server()->SetRconCID(IServer::RCON_CID_VOTE);
-				Console()->ExecuteLine(m_aVoteCommand);
+				ExecuteVoteOption(m_aVoteDescription, m_aVoteCommand);
 				Server()->SetRconCID(IServer::RCON_CID_SERV);
 				EndVote();
 				SendChat(-1, CGameContext::CHAT_ALL, "Vote passed");
@@ -511,12 +794,14 @@ void CGameContext::OnTick()
 			else if(m_VoteUpdate)
 			{
 				m_VoteUpdate = false;
-				SendVoteStatus(-1, Total, Yes, No);
+				SendVoteStatus(-1, m_VoteTotal, m_VoteYes, m_VoteNo);
 			}
 		}
 	}
 
 
+	FlushBroadcasts();
+
 #ifdef CONF_DEBUG
 	if(g_Config.m_DbgDummies)
 	{
@@ -553,8 +838,25 @@ void CGameContext::OnClientEnter(int ClientID)
 
 	str_format(aBuf, sizeof(aBuf), "team_join player='%d:%s' team=%d", ClientID, Server()->ClientName(ClientID), m_apPlayers[ClientID]->GetTeam());
 	Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "game", aBuf);
+	Server()->SendEvent(IServer::EVENT_ENTER, ClientID, -1, m_apPlayers[ClientID]->GetTeam());
 
-	m_VoteUpdate = true;
+	// add the client to the vote tally of its address
+	char aAddrStr[NETADDR_MAXSTRSIZE] = {0};
+	Server()->GetClientAddr(ClientID, aAddrStr, sizeof(aAddrStr));
+	int Slot = -1;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(m_aVoteIPs[i].m_NumClients && str_comp(m_aVoteIPs[i].m_aAddr, aAddrStr) == 0)
+		{
+			Slot = i;
+			break;
+		}
+		if(Slot == -1 && !m_aVoteIPs[i].m_NumClients)
+			Slot = i;
+	}
+	str_copy(m_aVoteIPs[Slot].m_aAddr, aAddrStr, sizeof(m_aVoteIPs[Slot].m_aAddr));
+	m_apPlayers[ClientID]->m_VoteIP = Slot;
+	UpdateVoteIP(Slot);
 }
 
 void CGameContext::OnClientConnected(int ClientID)
@@ -563,6 +865,8 @@ void CGameContext::OnClientConnected(int ClientID)
 	const int StartTeam = g_Config.m_SvTournamentMode ? TEAM_SPECTATORS : m_pController->GetAutoTeam(ClientID);
 
 	m_apPlayers[ClientID] = new(ClientID) CPlayer(this, ClientID, StartTeam);
+	m_aBroadcasts[ClientID].m_aText[0] = 0;
+	m_aBroadcasts[ClientID].m_SendTick = 0;
 	//players[client_id].init(client_id);
 	//players[client_id].client_id = client_id;
 
@@ -588,12 +892,16 @@ void CGameContext::OnClientConnected(int ClientID)
 
 void CGameContext::OnClientDrop(int ClientID, const char *pReason)
 {
+	Server()->SendEvent(IServer::EVENT_DROP, ClientID);
 	AbortVoteKickOnDisconnect(ClientID);
 	m_apPlayers[ClientID]->OnDisconnect(pReason);
+	int VoteIP = m_apPlayers[ClientID]->m_VoteIP;
 	delete m_apPlayers[ClientID];
 	m_apPlayers[ClientID] = 0;
 
 	(void)m_pController->CheckTeamBalance();
+	if(VoteIP != -1)
+		UpdateVoteIP(VoteIP);
 	m_VoteUpdate = true;
 
 	// update spectator modes
@@ -702,27 +1010,18 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 
 			if(str_comp_nocase(pMsg->m_Type, "option") == 0)
 			{
-				CVoteOptionServer *pOption = m_pVoteOptionFirst;
-				while(pOption)
-				{
-					if(str_comp_nocase(pMsg->m_Value, pOption->m_aDescription) == 0)
-					{
-						str_format(aChatmsg, sizeof(aChatmsg), "'%s' called vote to change server option '%s' (%s)", Server()->ClientName(ClientID),
-									pOption->m_aDescription, pReason);
-						str_format(aDesc, sizeof(aDesc), "%s", pOption->m_aDescription);
-						str_format(aCmd, sizeof(aCmd), "%s", pOption->m_aCommand);
-						break;
-					}
-
-					pOption = pOption->m_pNext;
-				}
-
+				CVoteOptionServer *pOption = FindVoteOption(pMsg->m_Value);
 				if(!pOption)
 				{
 					str_format(aChatmsg, sizeof(aChatmsg), "'%s' isn't an option on this server", pMsg->m_Value);
 					SendChatTarget(ClientID, aChatmsg);
 					return;
 				}
+
+				str_format(aChatmsg, sizeof(aChatmsg), "'%s' called vote to change server option '%s' (%s)", Server()->ClientName(ClientID),
+							pOption->m_aDescription, pReason);
+				str_format(aDesc, sizeof(aDesc), "%s", pOption->m_aDescription);
+				str_format(aCmd, sizeof(aCmd), "%s", pOption->m_aCommand);
 			}
 			else if(str_comp_nocase(pMsg->m_Type, "kick") == 0)
 			{
@@ -807,8 +1106,8 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 			{
 				SendChat(-1, CGameContext::CHAT_ALL, aChatmsg);
 				StartVote(aDesc, aCmd, pReason);
-				pPlayer->m_Vote = 1;
-				pPlayer->m_VotePos = m_VotePos = 1;
+				m_VotePos = 0;
+				SetPlayerVote(ClientID, 1);
 				m_VoteCreator = ClientID;
 				pPlayer->m_LastVoteCall = Now;
 			}
@@ -824,9 +1123,7 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 				if(!pMsg->m_Vote)
 					return;
 
-				pPlayer->m_Vote = pMsg->m_Vote;
-				pPlayer->m_VotePos = ++m_VotePos;
-				m_VoteUpdate = true;
+				SetPlayerVote(ClientID, pMsg->m_Vote);
 			}
 		}
 		else if (MsgID == NETMSGTYPE_CL_SETTEAM && !m_World.m_Paused)
@@ -843,6 +1140,7 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 				return;
 			}
 
+			int PreferredTeam = pPlayer->m_PreferredTeam;
 			if(pMsg->m_Team == TEAM_SPECTATORS) {
 				pPlayer->m_PreferredTeam = TEAM_SPECTATORS;
 			}
@@ -850,6 +1148,8 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 			{
 				pPlayer->m_PreferredTeam = 0;
 			}
+			if(pPlayer->m_PreferredTeam != PreferredTeam && pPlayer->m_VoteIP != -1)
+				UpdateVoteIP(pPlayer->m_VoteIP);
 
 			if(pPlayer->m_TeamChangeTick > Server()->Tick())
 			{
@@ -926,15 +1226,6 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 			Server()->SetClientClan(ClientID, pMsg->m_pClan);
 			Server()->SetClientCountry(ClientID, pMsg->m_Country);
 			str_copy(pPlayer->m_TeeInfos.m_SkinName, pMsg->m_pSkin, sizeof(pPlayer->m_TeeInfos.m_SkinName));
-			// Additions for BombX, to prevent player confusion.
-			if (strncmp("bomb", pMsg->m_pSkin, 4) == 0)
-			{
-				str_copy(pPlayer->m_OriginalSkinName, g_Config.m_SvDefaultSkin, sizeof(pPlayer->m_OriginalSkinName));
-			}
-			else
-			{
-				str_copy(pPlayer->m_OriginalSkinName, pMsg->m_pSkin, sizeof(pPlayer->m_OriginalSkinName));
-			}
 			pPlayer->m_TeeInfos.m_UseCustomColor = pMsg->m_UseCustomColor;
 			// This line is commented because coloration of tee body is used by the mode to represent information about the states of tees.
 //			pPlayer->m_TeeInfos.m_ColorBody = pMsg->m_ColorBody;
@@ -976,15 +1267,6 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 			Server()->SetClientClan(ClientID, pMsg->m_pClan);
 			Server()->SetClientCountry(ClientID, pMsg->m_Country);
 			str_copy(pPlayer->m_TeeInfos.m_SkinName, pMsg->m_pSkin, sizeof(pPlayer->m_TeeInfos.m_SkinName));
-			// Additions for BombX, to prevent player confusion.
-			if (strncmp("bomb", pMsg->m_pSkin, 4) == 0)
-			{
-				str_copy(pPlayer->m_OriginalSkinName, g_Config.m_SvDefaultSkin, sizeof(pPlayer->m_OriginalSkinName));
-			}
-			else
-			{
-				str_copy(pPlayer->m_OriginalSkinName, pMsg->m_pSkin, sizeof(pPlayer->m_OriginalSkinName));
-			}
 			pPlayer->m_TeeInfos.m_UseCustomColor = pMsg->m_UseCustomColor;
 			pPlayer->m_TeeInfos.m_ColorBody = pMsg->m_ColorBody;
 			pPlayer->m_TeeInfos.m_ColorFeet = pMsg->m_ColorFeet;
@@ -993,73 +1275,7 @@ void CGameContext::OnMessage(int MsgID, CUnpacker *pUnpacker, int ClientID)
 			// send vote options
 			CNetMsg_Sv_VoteClearOptions ClearMsg;
 			Server()->SendPackMsg(&ClearMsg, MSGFLAG_VITAL, ClientID);
-
-			CNetMsg_Sv_VoteOptionListAdd OptionMsg;
-			int NumOptions = 0;
-			OptionMsg.m_pDescription0 = "";
-			OptionMsg.m_pDescription1 = "";
-			OptionMsg.m_pDescription2 = "";
-			OptionMsg.m_pDescription3 = "";
-			OptionMsg.m_pDescription4 = "";
-			OptionMsg.m_pDescription5 = "";
-			OptionMsg.m_pDescription6 = "";
-			OptionMsg.m_pDescription7 = "";
-			OptionMsg.m_pDescription8 = "";
-			OptionMsg.m_pDescription9 = "";
-			OptionMsg.m_pDescription10 = "";
-			OptionMsg.m_pDescription11 = "";
-			OptionMsg.m_pDescription12 = "";
-			OptionMsg.m_pDescription13 = "";
-			OptionMsg.m_pDescription14 = "";
-			CVoteOptionServer *pCurrent = m_pVoteOptionFirst;
-			while(pCurrent)
-			{
-				switch(NumOptions++)
-				{
-				case 0: OptionMsg.m_pDescription0 = pCurrent->m_aDescription; break;
-				case 1: OptionMsg.m_pDescription1 = pCurrent->m_aDescription; break;
-				case 2: OptionMsg.m_pDescription2 = pCurrent->m_aDescription; break;
-				case 3: OptionMsg.m_pDescription3 = pCurrent->m_aDescription; break;
-				case 4: OptionMsg.m_pDescription4 = pCurrent->m_aDescription; break;
-				case 5: OptionMsg.m_pDescription5 = pCurrent->m_aDescription; break;
-				case 6: OptionMsg.m_pDescription6 = pCurrent->m_aDescription; break;
-				case 7: OptionMsg.m_pDescription7 = pCurrent->m_aDescription; break;
-				case 8: OptionMsg.m_pDescription8 = pCurrent->m_aDescription; break;
-				case 9: OptionMsg.m_pDescription9 = pCurrent->m_aDescription; break;
-				case 10: OptionMsg.m_pDescription10 = pCurrent->m_aDescription; break;
-				case 11: OptionMsg.m_pDescription11 = pCurrent->m_aDescription; break;
-				case 12: OptionMsg.m_pDescription12 = pCurrent->m_aDescription; break;
-				case 13: OptionMsg.m_pDescription13 = pCurrent->m_aDescription; break;
-				case 14:
-					{
-						OptionMsg.m_pDescription14 = pCurrent->m_aDescription;
-						OptionMsg.m_NumOptions = NumOptions;
-						Server()->SendPackMsg(&OptionMsg, MSGFLAG_VITAL, ClientID);
-						OptionMsg = CNetMsg_Sv_VoteOptionListAdd();
-						NumOptions = 0;
-						OptionMsg.m_pDescription1 = "";
-						OptionMsg.m_pDescription2 = "";
-						OptionMsg.m_pDescription3 = "";
-						OptionMsg.m_pDescription4 = "";
-						OptionMsg.m_pDescription5 = "";
-						OptionMsg.m_pDescription6 = "";
-						OptionMsg.m_pDescription7 = "";
-						OptionMsg.m_pDescription8 = "";
-						OptionMsg.m_pDescription9 = "";
-						OptionMsg.m_pDescription10 = "";
-						OptionMsg.m_pDescription11 = "";
-						OptionMsg.m_pDescription12 = "";
-						OptionMsg.m_pDescription13 = "";
-						OptionMsg.m_pDescription14 = "";
-					}
-				}
-				pCurrent = pCurrent->m_pNext;
-			}
-			if(NumOptions > 0)
-			{
-				OptionMsg.m_NumOptions = NumOptions;
-				Server()->SendPackMsg(&OptionMsg, MSGFLAG_VITAL, ClientID);
-			}
+			SendVoteOptions(ClientID, m_pVoteOptionFirst, m_pVoteOptionPending, MSGFLAG_VITAL);
 
 			// send tuning parameters to client
 			SendTuningParams(ClientID);
@@ -1083,7 +1299,7 @@ void CGameContext::ConTuneParam(IConsole::IResult *pResult, void *pUserData)
 		char aBuf[256];
 		str_format(aBuf, sizeof(aBuf), "%s changed to %.2f", pParamName, NewValue);
 		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "tuning", aBuf);
-		pSelf->SendTuningParams(-1);
+		pSelf->m_TuningChanged = true;
 	}
 	else
 		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "tuning", "No such tuning parameter");
@@ -1094,7 +1310,7 @@ void CGameContext::ConTuneReset(IConsole::IResult *pResult, void *pUserData)
 	CGameContext *pSelf = (CGameContext *)pUserData;
 	CTuningParams TuningParams;
 	*pSelf->Tuning() = TuningParams;
-	pSelf->SendTuningParams(-1);
+	pSelf->m_TuningChanged = true;
 	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "tuning", "Tuning reset");
 }
 
@@ -1272,42 +1488,20 @@ void CGameContext::ConAddVote(IConsole::IResult *pResult, void *pUserData)
 	}
 
 	// check for duplicate entry
-	CVoteOptionServer *pOption = pSelf->m_pVoteOptionFirst;
-	while(pOption)
+	if(pSelf->FindVoteOption(pDescription))
 	{
-		if(str_comp_nocase(pDescription, pOption->m_aDescription) == 0)
-		{
-			char aBuf[256];
-			str_format(aBuf, sizeof(aBuf), "option '%s' already exists", pDescription);
-			pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
-			return;
-		}
-		pOption = pOption->m_pNext;
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "option '%s' already exists", pDescription);
+		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+		return;
 	}
 
-	// add the option
-	++pSelf->m_NumVoteOptions;
-	int Len = str_length(pCommand);
-
-	pOption = (CVoteOptionServer *)pSelf->m_pVoteOptionHeap->Allocate(sizeof(CVoteOptionServer) + Len);
-	pOption->m_pNext = 0;
-	pOption->m_pPrev = pSelf->m_pVoteOptionLast;
-	if(pOption->m_pPrev)
-		pOption->m_pPrev->m_pNext = pOption;
-	pSelf->m_pVoteOptionLast = pOption;
-	if(!pSelf->m_pVoteOptionFirst)
-		pSelf->m_pVoteOptionFirst = pOption;
-
-	str_copy(pOption->m_aDescription, pDescription, sizeof(pOption->m_aDescription));
-	mem_copy(pOption->m_aCommand, pCommand, Len+1);
+	// add the option, clients get informed in batches on the next tick
+	CVoteOptionServer *pOption = pSelf->AddVoteOption(pDescription, pCommand);
+	pOption->m_pCompiled = pSelf->Console()->CompileLine(pCommand);
 	char aBuf[256];
 	str_format(aBuf, sizeof(aBuf), "added option '%s' '%s'", pOption->m_aDescription, pOption->m_aCommand);
 	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
-
-	// inform clients about added option
-	CNetMsg_Sv_VoteOptionAdd OptionMsg;
-	OptionMsg.m_pDescription = pOption->m_aDescription;
-	pSelf->Server()->SendPackMsg(&OptionMsg, MSGFLAG_VITAL, -1);
 }
 
 void CGameContext::ConRemoveVote(IConsole::IResult *pResult, void *pUserData)
@@ -1316,13 +1510,7 @@ void CGameContext::ConRemoveVote(IConsole::IResult *pResult, void *pUserData)
 	const char *pDescription = pResult->GetString(0);
 
 	// check for valid option
-	CVoteOptionServer *pOption = pSelf->m_pVoteOptionFirst;
-	while(pOption)
-	{
-		if(str_comp_nocase(pDescription, pOption->m_aDescription) == 0)
-			break;
-		pOption = pOption->m_pNext;
-	}
+	CVoteOptionServer *pOption = pSelf->FindVoteOption(pDescription);
 	if(!pOption)
 	{
 		char aBuf[256];
@@ -1332,47 +1520,18 @@ void CGameContext::ConRemoveVote(IConsole::IResult *pResult, void *pUserData)
 	}
 
 	// inform clients about removed option
-	CNetMsg_Sv_VoteOptionRemove OptionMsg;
-	OptionMsg.m_pDescription = pOption->m_aDescription;
-	pSelf->Server()->SendPackMsg(&OptionMsg, MSGFLAG_VITAL, -1);
+	if(pOption->m_Announced)
+	{
+		CNetMsg_Sv_VoteOptionRemove OptionMsg;
+		OptionMsg.m_pDescription = pOption->m_aDescription;
+		pSelf->Server()->SendPackMsg(&OptionMsg, MSGFLAG_VITAL, -1);
+	}
 
-	// TODO: improve this
 	// remove the option
-	--pSelf->m_NumVoteOptions;
 	char aBuf[256];
 	str_format(aBuf, sizeof(aBuf), "removed option '%s' '%s'", pOption->m_aDescription, pOption->m_aCommand);
 	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
-
-	CHeap *pVoteOptionHeap = new CHeap();
-	CVoteOptionServer *pVoteOptionFirst = 0;
-	CVoteOptionServer *pVoteOptionLast = 0;
-	int NumVoteOptions = pSelf->m_NumVoteOptions;
-	for(CVoteOptionServer *pSrc = pSelf->m_pVoteOptionFirst; pSrc; pSrc = pSrc->m_pNext)
-	{
-		if(pSrc == pOption)
-			continue;
-
-		// copy option
-		int Len = str_length(pSrc->m_aCommand);
-		CVoteOptionServer *pDst = (CVoteOptionServer *)pVoteOptionHeap->Allocate(sizeof(CVoteOptionServer) + Len);
-		pDst->m_pNext = 0;
-		pDst->m_pPrev = pVoteOptionLast;
-		if(pDst->m_pPrev)
-			pDst->m_pPrev->m_pNext = pDst;
-		pVoteOptionLast = pDst;
-		if(!pVoteOptionFirst)
-			pVoteOptionFirst = pDst;
-
-		str_copy(pDst->m_aDescription, pSrc->m_aDescription, sizeof(pDst->m_aDescription));
-		mem_copy(pDst->m_aCommand, pSrc->m_aCommand, Len+1);
-	}
-
-	// clean up
-	delete pSelf->m_pVoteOptionHeap;
-	pSelf->m_pVoteOptionHeap = pVoteOptionHeap;
-	pSelf->m_pVoteOptionFirst = pVoteOptionFirst;
-	pSelf->m_pVoteOptionLast = pVoteOptionLast;
-	pSelf->m_NumVoteOptions = NumVoteOptions;
+	pSelf->RemoveVoteOption(pOption);
 }
 
 void CGameContext::ConForceVote(IConsole::IResult *pResult, void *pUserData)
@@ -1385,26 +1544,19 @@ void CGameContext::ConForceVote(IConsole::IResult *pResult, void *pUserData)
 
 	if(str_comp_nocase(pType, "option") == 0)
 	{
-		CVoteOptionServer *pOption = pSelf->m_pVoteOptionFirst;
-		while(pOption)
-		{
-			if(str_comp_nocase(pValue, pOption->m_aDescription) == 0)
-			{
-				str_format(aBuf, sizeof(aBuf), "admin forced server option '%s' (%s)", pValue, pReason);
-				pSelf->SendChatTarget(-1, aBuf);
-				pSelf->Console()->ExecuteLine(pOption->m_aCommand);
-				break;
-			}
-
-			pOption = pOption->m_pNext;
-		}
-
+		CVoteOptionServer *pOption = pSelf->FindVoteOption(pValue);
 		if(!pOption)
 		{
 			str_format(aBuf, sizeof(aBuf), "'%s' isn't an option on this server", pValue);
 			pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 			return;
 		}
+
+		str_format(aBuf, sizeof(aBuf), "admin forced server option '%s' (%s)", pValue, pReason);
+		pSelf->SendChatTarget(-1, aBuf);
+		char aCommand[VOTE_CMD_LENGTH];
+		str_copy(aCommand, pOption->m_aCommand, sizeof(aCommand));
+		pSelf->ExecuteVoteOption(pValue, aCommand);
 	}
 	else if(str_comp_nocase(pType, "kick") == 0)
 	{
@@ -1451,10 +1603,7 @@ void CGameContext::ConClearVotes(IConsole::IResult *pResult, void *pUserData)
 	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "cleared votes");
 	CNetMsg_Sv_VoteClearOptions VoteClearOptionsMsg;
 	pSelf->Server()->SendPackMsg(&VoteClearOptionsMsg, MSGFLAG_VITAL, -1);
-	pSelf->m_pVoteOptionHeap->Reset();
-	pSelf->m_pVoteOptionFirst = 0;
-	pSelf->m_pVoteOptionLast = 0;
-	pSelf->m_NumVoteOptions = 0;
+	pSelf->ClearVoteOptions();
 }
 
 void CGameContext::ConVote(IConsole::IResult *pResult, void *pUserData)
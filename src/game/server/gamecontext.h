@@ -47,6 +47,7 @@ class CGameContext : public IGameServer
 	CCollision m_Collision;
 	CNetObjHandler m_NetObjHandler;
 	CTuningParams m_Tuning;
+	bool m_TuningChanged; // sent to the clients once per tick
 
 	static void ConTuneParam(IConsole::IResult *pResult, void *pUserData);
 	static void ConTuneReset(IConsole::IResult *pResult, void *pUserData);
@@ -121,6 +122,8 @@ public:
 	void SendVoteSet(int ClientID);
 	void SendVoteStatus(int ClientID, int Total, int Yes, int No);
 	void AbortVoteKickOnDisconnect(int ClientID);
+	void SetPlayerVote(int ClientID, int Vote);
+	void UpdateVoteIP(int Slot);
 
 	int m_VoteCreator;
 	int64 m_VoteCloseTime;
@@ -137,9 +140,40 @@ public:
 		VOTE_ENFORCE_NO,
 		VOTE_ENFORCE_YES,
 	};
+
+	// vote tally, clients sharing an address only count once (the first vote cast from it wins)
+	struct CVoteIP
+	{
+		char m_aAddr[NETADDR_MAXSTRSIZE];
+		int m_NumClients;
+		int m_NumActive; // clients not preferring to spectate
+		int m_Vote;
+		int m_VotePos;
+	};
+	CVoteIP m_aVoteIPs[MAX_CLIENTS];
+	int m_VoteTotal;
+	int m_VoteYes;
+	int m_VoteNo;
+
+	enum
+	{
+		VOTE_OPTION_HASH_SIZE=256,
+		VOTE_OPTIONS_PER_MSG=15, // descriptions in one NETMSGTYPE_SV_VOTEOPTIONLISTADD
+	};
 	CHeap *m_pVoteOptionHeap;
 	CVoteOptionServer *m_pVoteOptionFirst;
 	CVoteOptionServer *m_pVoteOptionLast;
+	CVoteOptionServer *m_pVoteOptionPending; // first option not yet announced to the clients
+	CVoteOptionServer *m_apVoteOptionHash[VOTE_OPTION_HASH_SIZE];
+	int m_NumVoteOptionsRemoved; // removed options still taking up heap space
+
+	CVoteOptionServer *FindVoteOption(const char *pDescription);
+	CVoteOptionServer *AddVoteOption(const char *pDescription, const char *pCommand);
+	void RemoveVoteOption(CVoteOptionServer *pOption);
+	void ClearVoteOptions();
+	void ExecuteVoteOption(const char *pDescription, const char *pCommand);
+	void SendVoteOptions(int ClientID, CVoteOptionServer *pFirst, CVoteOptionServer *pStop, int Flags);
+	void FlushVoteOptions();
 
 	// helper functions
 	void CreateDamageInd(vec2 Pos, float AngleMod, int Amount);
@@ -164,7 +198,23 @@ public:
 	void SendChat(int ClientID, int Team, const char *pText);
 	void SendEmoticon(int ClientID, int Emoticon);
 	void SendWeaponPickup(int ClientID, int Weapon);
-	void SendBroadcast(const char *pText, int ClientID);
+	void SendBroadcast(const char *pText, int ClientID, bool IsImportant=true);
+	void FlushBroadcasts();
+
+	// broadcasts, a text the client already shows is only resent to refresh it
+	enum
+	{
+		BROADCAST_LENGTH=1024,
+		BROADCAST_REFRESH_TIME=5, // seconds, clients show a broadcast for 10
+	};
+	struct CBroadcastState
+	{
+		char m_aText[BROADCAST_LENGTH];
+		int m_SendTick;
+	};
+	CBroadcastState m_aBroadcasts[MAX_CLIENTS];
+	char m_aGlobalBroadcast[BROADCAST_LENGTH];
+	bool m_GlobalBroadcastPending;
 
 
 	//
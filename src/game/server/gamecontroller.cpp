@@ -321,6 +321,8 @@ void IGameController::PostReset()
 
 void IGameController::OnPlayerInfoChange(class CPlayer *pP)
 {
+	pP->m_ClientInfoDirty = true;
+
 	const int aTeamColors[2] = {65387, 10223467};
 	if(IsTeamplay())
 	{
@@ -338,6 +340,11 @@ void IGameController::OnPlayerInfoChange(class CPlayer *pP)
 	}
 }
 
+int IGameController::GetPlayerAppearance(class CPlayer *pP)
+{
+	return 0;
+}
+
 
 int IGameController::OnCharacterDeath(class CCharacter *pVictim, class CPlayer *pKiller, int Weapon)
 {
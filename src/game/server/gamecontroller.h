@@ -128,6 +128,15 @@ public:
 
 	virtual void OnPlayerInfoChange(class CPlayer *pP);
 
+	/*
+		Function: get_player_appearance
+			Called when the player gets snapped.
+
+		Returns:
+			CPlayer::APPEARANCE_* flags altering how the player looks.
+	*/
+	virtual int GetPlayerAppearance(class CPlayer *pP);
+
 	//
 	virtual bool CanSpawn(int Team, vec2 *pPos);
 
@@ -25,6 +25,7 @@ CGameControllerBOMBX::CGameControllerBOMBX(class CGameContext *pGameServer)
 	// DM, TDM and CTF are reserved for teeworlds original modes.
 	m_pGameType = "BombX";
 	g_Config.m_SvTournamentMode = 0;
+	m_RoundEndReported = true;
 
 	srand(time(0));
 
@@ -79,6 +80,7 @@ void CGameControllerBOMBX::Tick()
 			for (int i = 0; i < MAX_CLIENTS; ++i) {
 				if (GameServer()->m_apPlayers[i]) {
 					if ((GameServer()->GetFuse(i) <= 0) && GameServer()->IsBomb(i)) {
+						Server()->SendEvent(IServer::EVENT_FUSE, i);
 						GameServer()->m_apPlayers[i]->GetCharacter()->Die(i, WEAPON_GRENADE);
 					}
 					// attempt to fix BID ghosting that leads to server crashes.
@@ -100,41 +102,6 @@ void CGameControllerBOMBX::Tick()
 		} else { // If it's the start of a round, then make players bombs. Has not been edited yet to work for multiple, though.
 			ChooseBomb();
 		}
-
-		// Make the bomb player look special.
-		//TODO: update to handle multiple bombs
-		if (GameServer()->GetBIDs() > 0){
-
-			for (int i = 0; i < MAX_CLIENTS; ++i) {
-				if ((GameServer()->GetFuse(i) > 0) && GameServer()->IsBomb(i)) {
-					str_copy(GameServer()->m_apPlayers[i]->m_TeeInfos.m_SkinName, "bomb",
-							sizeof(GameServer()->m_apPlayers[i]->m_TeeInfos.m_SkinName));
-
-					GameServer()->m_apPlayers[i]->m_TeeInfos.m_ColorBody = 16776960;
-					GameServer()->m_apPlayers[i]->m_TeeInfos.m_UseCustomColor = 1;
-				}
-			}
-		}
-
-		//TODO: update to handle multiple bombs
-		for(int j = 0; j < MAX_CLIENTS; j++) {
-			if(GameServer()->m_apPlayers[j] && !GameServer()->IsBomb(j)) {
-
-				// If the player looks like a bomb, fix that...
-				if (strncmp("bomb", GameServer()->m_apPlayers[j]->m_TeeInfos.m_SkinName, 4) == 0)
-				{
-					str_copy(GameServer()->m_apPlayers[j]->m_TeeInfos.m_SkinName,
-							GameServer()->m_apPlayers[j]->m_OriginalSkinName, sizeof(GameServer()->m_apPlayers[j]->m_TeeInfos.m_SkinName));
-				}
-				if (GameServer()->m_apPlayers[j]->m_StunTick > 0) {
-					GameServer()->m_apPlayers[j]->m_TeeInfos.m_ColorBody = 8978178;
-					GameServer()->m_apPlayers[j]->m_TeeInfos.m_UseCustomColor = 1;
-				} else {
-					GameServer()->m_apPlayers[j]->m_TeeInfos.m_ColorBody = 16119285;
-					GameServer()->m_apPlayers[j]->m_TeeInfos.m_UseCustomColor = 1;
-				}
-			}
-		}
 	}
 }
 
@@ -213,12 +180,18 @@ void CGameControllerBOMBX::DoWincheck()
 		EnumerateLivePlayers();
 		if (m_LivePlayers <= 1 ||
 				(g_Config.m_SvTimelimit > 0 && (Server()->Tick()-m_RoundStartTick) >= g_Config.m_SvTimelimit*Server()->TickSpeed()*60)) {
+			int Winner = -1;
 			if (m_LivePlayers > 0 && GameServer()->m_apPlayers[m_LiveIDs[0]] &&
 					GameServer()->m_apPlayers[m_LiveIDs[0]] == GameServer()->m_apPlayers[m_LiveIDs[0]] && m_ActivePlayers > 1)
 			{
 				GameServer()->m_apPlayers[m_LiveIDs[0]]->m_Score++; // Reward last surviving player.
+				Winner = m_LiveIDs[0];
 			}
 			if (m_ActivePlayers < 2) { //If there aren't enough people, do safety stuff but don't start a warmup.
+				if (!m_RoundEndReported) {
+					Server()->SendEvent(IServer::EVENT_ROUNDEND, Winner, -1, m_ActivePlayers);
+					m_RoundEndReported = true;
+				}
 				g_Config.m_SvSpectatorSlots = 0;
 				GameServer()->ResetBIDs();
 				if (m_LivePlayers == 1) { //...and if someone is around, tell them they need more people.
@@ -227,8 +200,16 @@ void CGameControllerBOMBX::DoWincheck()
 					GameServer()->SendBroadcast(bBuf,m_LiveIDs[0]);
 				}
 			}
-			else DoWarmup(g_Config.m_SvWarmup); //normal behavior when players are around; let people join for a limited time before next round
+			else {
+				if (!m_RoundEndReported) { //with sv_warmup 0 this branch runs every tick
+					Server()->SendEvent(IServer::EVENT_ROUNDEND, Winner, -1, m_ActivePlayers);
+					m_RoundEndReported = true;
+				}
+				DoWarmup(g_Config.m_SvWarmup); //normal behavior when players are around; let people join for a limited time before next round
+			}
 		}
+		else
+			m_RoundEndReported = false;
 	}
 }
 
@@ -245,6 +226,27 @@ void CGameControllerBOMBX::PostReset()
 	}
 }
 
+void CGameControllerBOMBX::OnPlayerInfoChange(class CPlayer *pP)
+{
+	IGameController::OnPlayerInfoChange(pP);
+
+	// bomb skins are reserved for the bomb, to prevent player confusion. The body color shows the state of the tee.
+	if(str_comp_num(pP->m_TeeInfos.m_SkinName, "bomb", 4) == 0)
+		str_copy(pP->m_TeeInfos.m_SkinName, g_Config.m_SvDefaultSkin, sizeof(pP->m_TeeInfos.m_SkinName));
+	pP->m_TeeInfos.m_UseCustomColor = 1;
+	pP->m_TeeInfos.m_ColorBody = 16119285;
+}
+
+int CGameControllerBOMBX::GetPlayerAppearance(class CPlayer *pP)
+{
+	//TODO: update to handle multiple bombs
+	if(GameServer()->IsBomb(pP->GetCID()) && GameServer()->GetFuse(pP->GetCID()) > 0)
+		return CPlayer::APPEARANCE_BOMB;
+	if(pP->m_StunTick > 0)
+		return CPlayer::APPEARANCE_STUNNED;
+	return 0;
+}
+
 void CGameControllerBOMBX::ChooseBomb() {
 	int BombChoice = (rand() % m_NotBombs.size());
 	GameServer()->SetBID(BombChoice);
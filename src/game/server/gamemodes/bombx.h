@@ -21,9 +21,12 @@ public:
 	virtual void DoWarmup(int Seconds);
 	virtual void DoWincheck();
 	virtual void PostReset();
+	virtual void OnPlayerInfoChange(class CPlayer *pP);
+	virtual int GetPlayerAppearance(class CPlayer *pP);
 
 	int m_ActivePlayers;
 	int m_LivePlayers;
+	bool m_RoundEndReported; // a round without enough players keeps ending every tick
 	std::vector<int> m_LiveIDs;
 	std::vector<int> m_NotBombs; // Used to make bomb selection easy.
 	void EnumerateLivePlayers();
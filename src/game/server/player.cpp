@@ -24,6 +24,8 @@ CPlayer::CPlayer(CGameContext *pGameServer, int ClientID, int Team)
 	m_TeamChangeTick = Server()->Tick();
 
 	m_PreferredTeam = 0;
+	m_VoteIP = -1;
+	m_ClientInfoDirty = true;
 }
 
 CPlayer::~CPlayer()
@@ -132,13 +134,31 @@ void CPlayer::Snap(int SnappingClient)
 	if(!pClientInfo)
 		return;
 
-	StrToInts(&pClientInfo->m_Name0, 4, Server()->ClientName(m_ClientID));
-	StrToInts(&pClientInfo->m_Clan0, 3, Server()->ClientClan(m_ClientID));
-	pClientInfo->m_Country = Server()->ClientCountry(m_ClientID);
-	StrToInts(&pClientInfo->m_Skin0, 6, m_TeeInfos.m_SkinName);
-	pClientInfo->m_UseCustomColor = m_TeeInfos.m_UseCustomColor;
-	pClientInfo->m_ColorBody = m_TeeInfos.m_ColorBody;
-	pClientInfo->m_ColorFeet = m_TeeInfos.m_ColorFeet;
+	// only pack the strings again if something changed
+	int Appearance = GameServer()->m_pController->GetPlayerAppearance(this);
+	if(m_ClientInfoDirty || Appearance != m_ClientInfoAppearance)
+	{
+		StrToInts(&m_ClientInfo.m_Name0, 4, Server()->ClientName(m_ClientID));
+		StrToInts(&m_ClientInfo.m_Clan0, 3, Server()->ClientClan(m_ClientID));
+		m_ClientInfo.m_Country = Server()->ClientCountry(m_ClientID);
+		if(Appearance&APPEARANCE_BOMB)
+		{
+			StrToInts(&m_ClientInfo.m_Skin0, 6, "bomb");
+			m_ClientInfo.m_UseCustomColor = 1;
+			m_ClientInfo.m_ColorBody = 16776960;
+		}
+		else
+		{
+			StrToInts(&m_ClientInfo.m_Skin0, 6, m_TeeInfos.m_SkinName);
+			m_ClientInfo.m_UseCustomColor = (Appearance&APPEARANCE_STUNNED) ? 1 : m_TeeInfos.m_UseCustomColor;
+			m_ClientInfo.m_ColorBody = (Appearance&APPEARANCE_STUNNED) ? 8978178 : m_TeeInfos.m_ColorBody;
+		}
+		m_ClientInfo.m_ColorFeet = m_TeeInfos.m_ColorFeet;
+
+		m_ClientInfoDirty = false;
+		m_ClientInfoAppearance = Appearance;
+	}
+	mem_copy(pClientInfo, &m_ClientInfo, sizeof(m_ClientInfo));
 
 	CNetObj_PlayerInfo *pPlayerInfo = static_cast<CNetObj_PlayerInfo *>(Server()->SnapNewItem(NETOBJTYPE_PLAYERINFO, m_ClientID, sizeof(CNetObj_PlayerInfo)));
 	if(!pPlayerInfo)
@@ -277,6 +297,8 @@ void CPlayer::SetTeam(int Team, bool DoChatMsg)
 		str_format(aBuf, sizeof(aBuf), "'%s' joined the %s", Server()->ClientName(m_ClientID), GameServer()->m_pController->GetTeamName(Team));
 		GameServer()->SendChat(-1, CGameContext::CHAT_ALL, aBuf);
 		m_PreferredTeam = Team;
+		if(m_VoteIP != -1)
+			GameServer()->UpdateVoteIP(m_VoteIP);
 	}
 
 	KillCharacter();
@@ -55,6 +55,7 @@ public:
 	//
 	int m_Vote;
 	int m_VotePos;
+	int m_VoteIP; // slot in CGameContext::m_aVoteIPs, -1 until the client entered
 	//
 	int m_LastVoteCall;
 	int m_LastVoteTry;
@@ -69,7 +70,16 @@ public:
 	int m_PreferredTeam;
 
 	int m_StunTick;
-	char m_OriginalSkinName[64];
+
+	// appearance the game mode puts on top of the tee info
+	enum
+	{
+		APPEARANCE_BOMB=1,
+		APPEARANCE_STUNNED=2,
+	};
+
+	// set when name, clan, country or tee info changed, the snapped client info gets rebuilt then
+	bool m_ClientInfoDirty;
 
 	// TODO: clean this up
 	struct
@@ -117,6 +127,9 @@ private:
 	int m_ClientID;
 	int m_Team;
 
+	CNetObj_ClientInfo m_ClientInfo;
+	int m_ClientInfoAppearance;
+
 };
 
 #endif
@@ -18,6 +18,8 @@ MACRO_CONFIG_INT(ClShowChatFriends, cl_show_chat_friends, 0, 0, 1, CFGFLAG_CLIEN
 MACRO_CONFIG_INT(ClShowfps, cl_showfps, 0, 0, 1, CFGFLAG_CLIENT|CFGFLAG_SAVE, "Show ingame FPS counter")
 
 MACRO_CONFIG_INT(ClAirjumpindicator, cl_airjumpindicator, 1, 0, 1, CFGFLAG_CLIENT|CFGFLAG_SAVE, "")
+MACRO_CONFIG_INT(ClRenderThreads, cl_render_threads, 0, 0, 8, CFGFLAG_CLIENT|CFGFLAG_SAVE, "Number of threads recording map layers in parallel (needs gfx_threaded, takes effect on restart)")
+MACRO_CONFIG_INT(ClAssetThreads, cl_asset_threads, 2, 0, 8, CFGFLAG_CLIENT|CFGFLAG_SAVE, "Number of threads decoding images and sounds in the background at startup, 0 loads them before the menu shows up")
 MACRO_CONFIG_INT(ClThreadsoundloading, cl_threadsoundloading, 0, 0, 1, CFGFLAG_CLIENT|CFGFLAG_SAVE, "Load sound files threaded")
 
 MACRO_CONFIG_INT(ClWarningTeambalance, cl_warning_teambalance, 1, 0, 1, CFGFLAG_CLIENT|CFGFLAG_SAVE, "Warn about team balance")
@@ -3,6 +3,8 @@
 #ifndef GAME_VOTING_H
 #define GAME_VOTING_H
 
+#include <engine/console.h>
+
 enum
 {
 	VOTE_DESC_LENGTH=64,
@@ -23,6 +25,9 @@ struct CVoteOptionServer
 {
 	CVoteOptionServer *m_pNext;
 	CVoteOptionServer *m_pPrev;
+	CVoteOptionServer *m_pHashNext;
+	bool m_Announced;
+	IConsole::ICompiledLine *m_pCompiled; // 0 if the command can't be compiled
 	char m_aDescription[VOTE_DESC_LENGTH];
 	char m_aCommand[1];
 };
@@ -1,6 +1,8 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
 #include <base/system.h>
+#include <base/tl/threading.h>
 
 #include <engine/config.h>
 #include <engine/console.h>
@@ -17,9 +19,101 @@
 enum {
 	MTU = 1400,
 	MAX_SERVERS_PER_PACKET=75,
-	MAX_PACKETS=16,
-	MAX_SERVERS=MAX_SERVERS_PER_PACKET*MAX_PACKETS,
-	EXPIRE_TIME = 90
+	EXPIRE_TIME = 90,
+	CHECK_RETRY_TIME = 5, // seconds between the tries of a firewall check, ten of them before it fails
+	MIN_TABLE_SIZE = 1024,
+	CHANGELOG_SIZE = 4096, // power of two
+	HEARTBEAT_QUEUE_SIZE = 4096
+};
+
+// maps addresses to indices, open addressed and always at most half full
+class CAddrTable
+{
+	struct CSlot
+	{
+		NETADDR m_Addr;
+		int m_Index; // -1 if the slot is empty
+	};
+
+	CSlot *m_pSlots;
+	int m_Size;
+	int m_Num;
+
+	int Slot(const NETADDR *pAddr) const
+	{
+		// the slot holding the address or the empty one where it belongs
+		int i = net_addr_hash(pAddr, true)&(m_Size-1);
+		while(m_pSlots[i].m_Index != -1 && net_addr_comp(&m_pSlots[i].m_Addr, pAddr) != 0)
+			i = (i+1)&(m_Size-1);
+		return i;
+	}
+
+	void Grow()
+	{
+		CSlot *pOldSlots = m_pSlots;
+		int OldSize = m_Size;
+		m_Size = max(OldSize*2, (int)MIN_TABLE_SIZE);
+		m_pSlots = (CSlot *)mem_alloc(m_Size*sizeof(CSlot), 1);
+		for(int i = 0; i < m_Size; i++)
+			m_pSlots[i].m_Index = -1;
+		for(int i = 0; i < OldSize; i++)
+		{
+			if(pOldSlots[i].m_Index != -1)
+				m_pSlots[Slot(&pOldSlots[i].m_Addr)] = pOldSlots[i];
+		}
+		mem_free(pOldSlots);
+	}
+
+public:
+	CAddrTable() : m_pSlots(0), m_Size(0), m_Num(0) {}
+
+	int Find(const NETADDR *pAddr) const
+	{
+		if(!m_Size)
+			return -1;
+		return m_pSlots[Slot(pAddr)].m_Index;
+	}
+
+	void Set(const NETADDR *pAddr, int Index)
+	{
+		if((m_Num+1)*2 > m_Size)
+			Grow();
+		int i = Slot(pAddr);
+		if(m_pSlots[i].m_Index == -1)
+		{
+			m_pSlots[i].m_Addr = *pAddr;
+			m_Num++;
+		}
+		m_pSlots[i].m_Index = Index;
+	}
+
+	void Remove(const NETADDR *pAddr)
+	{
+		if(!m_Size)
+			return;
+		int i = Slot(pAddr);
+		if(m_pSlots[i].m_Index == -1)
+			return;
+		m_Num--;
+
+		// shift the rest of the cluster back so no lookup stops at the hole
+		int j = i;
+		while(1)
+		{
+			m_pSlots[i].m_Index = -1;
+			int Home;
+			do
+			{
+				j = (j+1)&(m_Size-1);
+				if(m_pSlots[j].m_Index == -1)
+					return;
+				Home = net_addr_hash(&m_pSlots[j].m_Addr, true)&(m_Size-1);
+			}
+			while(i <= j ? (i < Home && Home <= j) : (i < Home || Home <= j));
+			m_pSlots[i] = m_pSlots[j];
+			i = j;
+		}
+	}
 };
 
 struct CCheckServer
@@ -31,18 +125,33 @@ struct CCheckServer
 	int64 m_TryTime;
 };
 
-static CCheckServer m_aCheckServers[MAX_SERVERS];
+static CCheckServer *m_pCheckServers = 0;
 static int m_NumCheckServers = 0;
+static int m_CheckServerCapacity = 0;
+static CAddrTable m_CheckServerTable; // both addresses of every server being checked
 
 struct CServerEntry
 {
 	enum ServerType m_Type;
 	NETADDR m_Address;
 	int64 m_Expire;
+
+	int m_PrevExpire; // expire list, the servers that expire first come first
+	int m_NextExpire;
+
+	int m_ListPos; // position in the list packets of its type
 };
 
-static CServerEntry m_aServers[MAX_SERVERS];
+static CServerEntry *m_pServers = 0;
 static int m_NumServers = 0;
+static int m_ServerCapacity = 0;
+static CAddrTable m_ServerTable;
+static int m_FirstExpire = -1;
+static int m_LastExpire = -1;
+
+static int m_NumHeartbeats = 0;
+static int m_NumAdded = 0;
+static int m_NumExpired = 0;
 
 struct CPacketData
 {
@@ -53,7 +162,7 @@ struct CPacketData
 	} m_Data;
 };
 
-CPacketData m_aPackets[MAX_PACKETS];
+static CPacketData *m_pPackets = 0;
 static int m_NumPackets = 0;
 
 // legacy code
@@ -66,9 +175,33 @@ struct CPacketDataLegacy
 	} m_Data;
 };
 
-CPacketDataLegacy m_aPacketsLegacy[MAX_PACKETS];
+static CPacketDataLegacy *m_pPacketsLegacy = 0;
 static int m_NumPacketsLegacy = 0;
+static int m_PacketCapacity = 0;
+
+// server index for every position in the list packets
+static int *m_pListServers = 0;
+static int m_NumListServers = 0;
+static int *m_pListServersLegacy = 0;
+static int m_NumListServersLegacy = 0;
 
+// recent changes to the 0.6 list, so clients can ask for what changed since their last request
+struct CListChange
+{
+	NETADDR m_Address;
+	bool m_Removed;
+};
+
+static CListChange m_aChangeLog[CHANGELOG_SIZE]; // the change to version v is at v&(CHANGELOG_SIZE-1)
+static int m_NumChanges = 0;
+static unsigned m_ListVersion = 0;
+
+struct CDeltaPacketData
+{
+	unsigned char m_aHeader[sizeof(SERVERBROWSE_LIST_DELTA)];
+	CMastersrvListDelta m_Info;
+	CMastersrvDeltaAddr m_aServers[MAX_SERVERS_PER_DELTA_PACKET];
+};
 
 struct CCountPacketData
 {
@@ -77,8 +210,55 @@ struct CCountPacketData
 	unsigned char m_Low;
 };
 
-static CCountPacketData m_CountData;
-static CCountPacketData m_CountDataLegacy;
+// everything list requests are answered from
+struct CListSnapshot
+{
+	const CPacketData *m_pPackets;
+	int m_NumPackets;
+	const CPacketDataLegacy *m_pPacketsLegacy;
+	int m_NumPacketsLegacy;
+	int m_NumServers; // all registered servers, for the count replies
+	int m_NumListServers; // the servers in m_pPackets
+	const CListChange *m_pChangeLog;
+	int m_NumChanges;
+	unsigned m_ListVersion;
+};
+
+struct CHeartbeat
+{
+	NETADDR m_Address;
+	NETADDR m_AltAddress;
+	ServerType m_Type;
+};
+
+// extra threads answering list requests on their own socket bound to the same port
+struct CWorker
+{
+	CNetClient m_Net;
+	volatile unsigned m_Quiescent; // counts the rounds, between rounds the worker holds no snapshot
+	volatile int m_NumListRequests;
+	int m_ReportedListRequests; // only used by the main thread
+};
+
+static CWorker *m_pWorkers = 0;
+static int m_NumWorkers = 0;
+
+// the workers only read the published snapshot, the main thread replaces it with a new copy
+// and frees the old one once every worker finished a round since then
+static CListSnapshot * volatile m_pSnapshot = 0;
+static CListSnapshot *m_pRetiredSnapshot = 0;
+static unsigned *m_pRetiredQuiescent = 0;
+static int m_ListChanges = 0;
+static int m_SnapshotChanges = 0;
+static volatile int m_PauseWorkers = 0;
+
+// heartbeats the workers received, added to the check list by the main thread
+static LOCK m_HeartbeatLock = 0;
+static CHeartbeat m_aHeartbeatQueue[HEARTBEAT_QUEUE_SIZE];
+static int m_NumQueuedHeartbeats = 0;
+static CHeartbeat m_aHeartbeats[HEARTBEAT_QUEUE_SIZE];
+
+static int m_NumListRequests = 0;
 
 
 CNetBan m_NetBan;
@@ -88,84 +268,362 @@ static CNetClient m_NetOp; // main
 
 IConsole *m_pConsole;
 
-void BuildPackets()
+void RemoveFromList(int Index);
+
+void RemoveServer(int Index)
 {
-	CServerEntry *pCurrent = &m_aServers[0];
-	int ServersLeft = m_NumServers;
-	m_NumPackets = 0;
-	m_NumPacketsLegacy = 0;
-	int PacketIndex = 0;
-	int PacketIndexLegacy = 0;
-	while(ServersLeft-- && (m_NumPackets + m_NumPacketsLegacy) < MAX_PACKETS)
+	CServerEntry *pEntry = &m_pServers[Index];
+
+	RemoveFromList(Index);
+
+	// unlink from the expire list
+	if(pEntry->m_PrevExpire != -1)
+		m_pServers[pEntry->m_PrevExpire].m_NextExpire = pEntry->m_NextExpire;
+	else
+		m_FirstExpire = pEntry->m_NextExpire;
+	if(pEntry->m_NextExpire != -1)
+		m_pServers[pEntry->m_NextExpire].m_PrevExpire = pEntry->m_PrevExpire;
+	else
+		m_LastExpire = pEntry->m_PrevExpire;
+
+	m_ServerTable.Remove(&pEntry->m_Address);
+
+	// move the last server into the gap
+	m_NumServers--;
+	if(Index == m_NumServers)
+		return;
+	*pEntry = m_pServers[m_NumServers];
+	if(pEntry->m_PrevExpire != -1)
+		m_pServers[pEntry->m_PrevExpire].m_NextExpire = Index;
+	else
+		m_FirstExpire = Index;
+	if(pEntry->m_NextExpire != -1)
+		m_pServers[pEntry->m_NextExpire].m_PrevExpire = Index;
+	else
+		m_LastExpire = Index;
+	m_ServerTable.Set(&pEntry->m_Address, Index);
+	if(pEntry->m_Type == SERVERTYPE_NORMAL)
+		m_pListServers[pEntry->m_ListPos] = Index;
+	else
+		m_pListServersLegacy[pEntry->m_ListPos] = Index;
+}
+
+void RemoveCheckServer(int Index)
+{
+	CCheckServer *pCheck = &m_pCheckServers[Index];
+
+	// the alternative address can be shared with another server, only drop our own entries
+	if(m_CheckServerTable.Find(&pCheck->m_Address) == Index)
+		m_CheckServerTable.Remove(&pCheck->m_Address);
+	if(m_CheckServerTable.Find(&pCheck->m_AltAddress) == Index)
+		m_CheckServerTable.Remove(&pCheck->m_AltAddress);
+
+	// move the last server into the gap
+	m_NumCheckServers--;
+	if(Index == m_NumCheckServers)
+		return;
+	*pCheck = m_pCheckServers[m_NumCheckServers];
+	if(m_CheckServerTable.Find(&pCheck->m_Address) == m_NumCheckServers)
+		m_CheckServerTable.Set(&pCheck->m_Address, Index);
+	if(m_CheckServerTable.Find(&pCheck->m_AltAddress) == m_NumCheckServers)
+		m_CheckServerTable.Set(&pCheck->m_AltAddress, Index);
+}
+
+void WriteAddr(CMastersrvAddr *pOut, const NETADDR *pAddr)
+{
+	if(pAddr->type == NETTYPE_IPV6)
+		mem_copy(pOut->m_aIp, pAddr->ip, sizeof(pOut->m_aIp));
+	else
 	{
-		if(pCurrent->m_Type == SERVERTYPE_NORMAL)
-		{
-			if(PacketIndex % MAX_SERVERS_PER_PACKET == 0)
-			{
-				PacketIndex = 0;
-				m_NumPackets++;
-			}
+		static char IPV4Mapping[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF };
 
-			// copy header
-			mem_copy(m_aPackets[m_NumPackets-1].m_Data.m_aHeader, SERVERBROWSE_LIST, sizeof(SERVERBROWSE_LIST));
+		mem_copy(pOut->m_aIp, IPV4Mapping, sizeof(IPV4Mapping));
+		pOut->m_aIp[12] = pAddr->ip[0];
+		pOut->m_aIp[13] = pAddr->ip[1];
+		pOut->m_aIp[14] = pAddr->ip[2];
+		pOut->m_aIp[15] = pAddr->ip[3];
+	}
 
-			// copy server addresses
-			if(pCurrent->m_Address.type == NETTYPE_IPV6)
-			{
-				mem_copy(m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp, pCurrent->m_Address.ip,
-					sizeof(m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp));
-			}
-			else
-			{
-				static char IPV4Mapping[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF };
+	pOut->m_aPort[0] = (pAddr->port>>8)&0xff;
+	pOut->m_aPort[1] = pAddr->port&0xff;
+}
 
-				mem_copy(m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp, IPV4Mapping, sizeof(IPV4Mapping));
-				m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp[12] = pCurrent->m_Address.ip[0];
-				m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp[13] = pCurrent->m_Address.ip[1];
-				m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp[14] = pCurrent->m_Address.ip[2];
-				m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aIp[15] = pCurrent->m_Address.ip[3];
-			}
+void LogChange(const NETADDR *pAddr, bool Removed)
+{
+	// version 0 is what clients without a list send
+	if(++m_ListVersion == 0)
+	{
+		m_ListVersion = 1;
+		m_NumChanges = 0;
+	}
+	m_aChangeLog[m_ListVersion&(CHANGELOG_SIZE-1)].m_Address = *pAddr;
+	m_aChangeLog[m_ListVersion&(CHANGELOG_SIZE-1)].m_Removed = Removed;
+	m_NumChanges = min(m_NumChanges+1, (int)CHANGELOG_SIZE);
+	m_ListChanges++;
+}
 
-			m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aPort[0] = (pCurrent->m_Address.port>>8)&0xff;
-			m_aPackets[m_NumPackets-1].m_Data.m_aServers[PacketIndex].m_aPort[1] = pCurrent->m_Address.port&0xff;
+void WriteListEntry(const CServerEntry *pEntry)
+{
+	int Packet = pEntry->m_ListPos/MAX_SERVERS_PER_PACKET;
+	int Index = pEntry->m_ListPos%MAX_SERVERS_PER_PACKET;
 
-			PacketIndex++;
+	if(pEntry->m_Type == SERVERTYPE_NORMAL)
+		WriteAddr(&m_pPackets[Packet].m_Data.m_aServers[Index], &pEntry->m_Address);
+	else
+	{
+		CMastersrvAddrLegacy *pOut = &m_pPacketsLegacy[Packet].m_Data.m_aServers[Index];
+		mem_copy(pOut->m_aIp, pEntry->m_Address.ip, sizeof(pOut->m_aIp));
+		// 0.5 has the port in little endian on the network
+		pOut->m_aPort[0] = pEntry->m_Address.port&0xff;
+		pOut->m_aPort[1] = (pEntry->m_Address.port>>8)&0xff;
+	}
+}
+
+void UpdateListSize(ServerType Type)
+{
+	// only the last packet and the one before it can change their size when a server is added or removed
+	if(Type == SERVERTYPE_NORMAL)
+	{
+		m_NumPackets = (m_NumListServers+MAX_SERVERS_PER_PACKET-1)/MAX_SERVERS_PER_PACKET;
+		if(m_NumPackets > 1)
+			m_pPackets[m_NumPackets-2].m_Size = sizeof(SERVERBROWSE_LIST) + sizeof(CMastersrvAddr)*MAX_SERVERS_PER_PACKET;
+		if(m_NumPackets > 0)
+			m_pPackets[m_NumPackets-1].m_Size = sizeof(SERVERBROWSE_LIST) +
+				sizeof(CMastersrvAddr)*(m_NumListServers-(m_NumPackets-1)*MAX_SERVERS_PER_PACKET);
+	}
+	else
+	{
+		m_NumPacketsLegacy = (m_NumListServersLegacy+MAX_SERVERS_PER_PACKET-1)/MAX_SERVERS_PER_PACKET;
+		if(m_NumPacketsLegacy > 1)
+			m_pPacketsLegacy[m_NumPacketsLegacy-2].m_Size = sizeof(SERVERBROWSE_LIST_LEGACY) + sizeof(CMastersrvAddrLegacy)*MAX_SERVERS_PER_PACKET;
+		if(m_NumPacketsLegacy > 0)
+			m_pPacketsLegacy[m_NumPacketsLegacy-1].m_Size = sizeof(SERVERBROWSE_LIST_LEGACY) +
+				sizeof(CMastersrvAddrLegacy)*(m_NumListServersLegacy-(m_NumPacketsLegacy-1)*MAX_SERVERS_PER_PACKET);
+	}
+}
 
-			m_aPackets[m_NumPackets-1].m_Size = sizeof(SERVERBROWSE_LIST) + sizeof(CMastersrvAddr)*PacketIndex;
+void AddToList(int Index)
+{
+	CServerEntry *pEntry = &m_pServers[Index];
+	int *pNum = pEntry->m_Type == SERVERTYPE_NORMAL ? &m_NumListServers : &m_NumListServersLegacy;
 
-			pCurrent++;
+	// both kinds of packets grow together
+	if(*pNum == m_PacketCapacity*MAX_SERVERS_PER_PACKET)
+	{
+		int OldCapacity = m_PacketCapacity;
+		m_PacketCapacity = max(m_PacketCapacity*2, 16);
+		CPacketData *pNewPackets = (CPacketData *)mem_alloc(m_PacketCapacity*sizeof(CPacketData), 1);
+		CPacketDataLegacy *pNewPacketsLegacy = (CPacketDataLegacy *)mem_alloc(m_PacketCapacity*sizeof(CPacketDataLegacy), 1);
+		if(OldCapacity)
+		{
+			mem_copy(pNewPackets, m_pPackets, OldCapacity*sizeof(CPacketData));
+			mem_copy(pNewPacketsLegacy, m_pPacketsLegacy, OldCapacity*sizeof(CPacketDataLegacy));
+		}
+		for(int i = OldCapacity; i < m_PacketCapacity; i++)
+		{
+			mem_copy(pNewPackets[i].m_Data.m_aHeader, SERVERBROWSE_LIST, sizeof(SERVERBROWSE_LIST));
+			mem_copy(pNewPacketsLegacy[i].m_Data.m_aHeader, SERVERBROWSE_LIST_LEGACY, sizeof(SERVERBROWSE_LIST_LEGACY));
 		}
-		else if(pCurrent->m_Type == SERVERTYPE_LEGACY)
+		mem_free(m_pPackets);
+		mem_free(m_pPacketsLegacy);
+		m_pPackets = pNewPackets;
+		m_pPacketsLegacy = pNewPacketsLegacy;
+	}
+
+	pEntry->m_ListPos = (*pNum)++;
+	if(pEntry->m_Type == SERVERTYPE_NORMAL)
+	{
+		m_pListServers[pEntry->m_ListPos] = Index;
+		LogChange(&pEntry->m_Address, false);
+	}
+	else
+	{
+		m_pListServersLegacy[pEntry->m_ListPos] = Index;
+		m_ListChanges++;
+	}
+	WriteListEntry(pEntry);
+	UpdateListSize(pEntry->m_Type);
+}
+
+void RemoveFromList(int Index)
+{
+	CServerEntry *pEntry = &m_pServers[Index];
+	int *pList = pEntry->m_Type == SERVERTYPE_NORMAL ? m_pListServers : m_pListServersLegacy;
+	int *pNum = pEntry->m_Type == SERVERTYPE_NORMAL ? &m_NumListServers : &m_NumListServersLegacy;
+
+	// move the last listed server into the gap
+	(*pNum)--;
+	if(pEntry->m_ListPos != *pNum)
+	{
+		CServerEntry *pMoved = &m_pServers[pList[*pNum]];
+		pMoved->m_ListPos = pEntry->m_ListPos;
+		pList[pMoved->m_ListPos] = pList[*pNum];
+		WriteListEntry(pMoved);
+	}
+
+	if(pEntry->m_Type == SERVERTYPE_NORMAL)
+		LogChange(&pEntry->m_Address, true);
+	else
+		m_ListChanges++;
+	UpdateListSize(pEntry->m_Type);
+}
+
+void SendListDelta(CNetClient *pNet, NETADDR *pAddr, unsigned Version, const CListSnapshot *pList)
+{
+	// the whole list if the client has none, the changes it missed already left the log or they are more than the list
+	unsigned Behind = pList->m_ListVersion-Version;
+	bool Full = Version == 0 || Behind > (unsigned)pList->m_NumChanges || Behind >= (unsigned)pList->m_NumListServers;
+	int NumServers = Full ? pList->m_NumListServers : (int)Behind;
+	int NumPackets = max((NumServers+MAX_SERVERS_PER_DELTA_PACKET-1)/MAX_SERVERS_PER_DELTA_PACKET, 1);
+
+	CDeltaPacketData DeltaPacket;
+	mem_copy(DeltaPacket.m_aHeader, SERVERBROWSE_LIST_DELTA, sizeof(SERVERBROWSE_LIST_DELTA));
+	unsigned BaseVersion = Full ? 0 : Version;
+	DeltaPacket.m_Info.m_aBaseVersion[0] = (BaseVersion>>24)&0xff;
+	DeltaPacket.m_Info.m_aBaseVersion[1] = (BaseVersion>>16)&0xff;
+	DeltaPacket.m_Info.m_aBaseVersion[2] = (BaseVersion>>8)&0xff;
+	DeltaPacket.m_Info.m_aBaseVersion[3] = BaseVersion&0xff;
+	DeltaPacket.m_Info.m_aVersion[0] = (pList->m_ListVersion>>24)&0xff;
+	DeltaPacket.m_Info.m_aVersion[1] = (pList->m_ListVersion>>16)&0xff;
+	DeltaPacket.m_Info.m_aVersion[2] = (pList->m_ListVersion>>8)&0xff;
+	DeltaPacket.m_Info.m_aVersion[3] = pList->m_ListVersion&0xff;
+	DeltaPacket.m_Info.m_aNumPackets[0] = (NumPackets>>8)&0xff;
+	DeltaPacket.m_Info.m_aNumPackets[1] = NumPackets&0xff;
+
+	CNetChunk p;
+	p.m_ClientID = -1;
+	p.m_Address = *pAddr;
+	p.m_Flags = NETSENDFLAG_CONNLESS;
+	p.m_pData = &DeltaPacket;
+
+	for(int i = 0; i < NumPackets; i++)
+	{
+		int Num = min(NumServers-i*MAX_SERVERS_PER_DELTA_PACKET, (int)MAX_SERVERS_PER_DELTA_PACKET);
+		for(int j = 0; j < Num; j++)
 		{
-			if(PacketIndexLegacy % MAX_SERVERS_PER_PACKET == 0)
+			int Change = i*MAX_SERVERS_PER_DELTA_PACKET+j;
+			if(Full)
 			{
-				PacketIndexLegacy = 0;
-				m_NumPacketsLegacy++;
+				// the list packets hold the addresses already
+				DeltaPacket.m_aServers[j].m_Addr = pList->m_pPackets[Change/MAX_SERVERS_PER_PACKET].m_Data.m_aServers[Change%MAX_SERVERS_PER_PACKET];
+				DeltaPacket.m_aServers[j].m_Removed = 0;
 			}
+			else
+			{
+				const CListChange *pChange = &pList->m_pChangeLog[(Version+1+Change)&(CHANGELOG_SIZE-1)];
+				WriteAddr(&DeltaPacket.m_aServers[j].m_Addr, &pChange->m_Address);
+				DeltaPacket.m_aServers[j].m_Removed = pChange->m_Removed;
+			}
+		}
 
-			// copy header
-			mem_copy(m_aPacketsLegacy[m_NumPacketsLegacy-1].m_Data.m_aHeader, SERVERBROWSE_LIST_LEGACY, sizeof(SERVERBROWSE_LIST_LEGACY));
+		DeltaPacket.m_Info.m_aPacket[0] = (i>>8)&0xff;
+		DeltaPacket.m_Info.m_aPacket[1] = i&0xff;
+		p.m_DataSize = sizeof(DeltaPacket.m_aHeader) + sizeof(DeltaPacket.m_Info) + sizeof(CMastersrvDeltaAddr)*Num;
+		pNet->Send(&p);
+	}
+}
 
-			// copy server addresses
-			mem_copy(m_aPacketsLegacy[m_NumPacketsLegacy-1].m_Data.m_aServers[PacketIndexLegacy].m_aIp, pCurrent->m_Address.ip,
-				sizeof(m_aPacketsLegacy[m_NumPacketsLegacy-1].m_Data.m_aServers[PacketIndexLegacy].m_aIp));
-			// 0.5 has the port in little endian on the network
-			m_aPacketsLegacy[m_NumPacketsLegacy-1].m_Data.m_aServers[PacketIndexLegacy].m_aPort[0] = pCurrent->m_Address.port&0xff;
-			m_aPacketsLegacy[m_NumPacketsLegacy-1].m_Data.m_aServers[PacketIndexLegacy].m_aPort[1] = (pCurrent->m_Address.port>>8)&0xff;
+void SendCount(CNetClient *pNet, NETADDR *pAddr, const unsigned char *pHeader, int NumServers)
+{
+	CCountPacketData CountData;
+	mem_copy(CountData.m_Header, pHeader, sizeof(CountData.m_Header));
+	CountData.m_High = (NumServers>>8)&0xff;
+	CountData.m_Low = NumServers&0xff;
+
+	CNetChunk p;
+	p.m_ClientID = -1;
+	p.m_Address = *pAddr;
+	p.m_Flags = NETSENDFLAG_CONNLESS;
+	p.m_DataSize = sizeof(CountData);
+	p.m_pData = &CountData;
+	pNet->Send(&p);
+}
+
+bool ProcessListRequest(CNetClient *pNet, CNetChunk *pPacket, const CListSnapshot *pList)
+{
+	if(pPacket->m_DataSize == sizeof(SERVERBROWSE_GETCOUNT) &&
+		mem_comp(pPacket->m_pData, SERVERBROWSE_GETCOUNT, sizeof(SERVERBROWSE_GETCOUNT)) == 0)
+	{
+		dbg_msg("mastersrv", "count requested, responding with %d", pList->m_NumServers);
+
+		SendCount(pNet, &pPacket->m_Address, SERVERBROWSE_COUNT, pList->m_NumServers);
+	}
+	else if(pPacket->m_DataSize == sizeof(SERVERBROWSE_GETCOUNT_LEGACY) &&
+		mem_comp(pPacket->m_pData, SERVERBROWSE_GETCOUNT_LEGACY, sizeof(SERVERBROWSE_GETCOUNT_LEGACY)) == 0)
+	{
+		dbg_msg("mastersrv", "count requested, responding with %d", pList->m_NumServers);
 
-			PacketIndexLegacy++;
+		SendCount(pNet, &pPacket->m_Address, SERVERBROWSE_COUNT_LEGACY, pList->m_NumServers);
+	}
+	else if(pPacket->m_DataSize == sizeof(SERVERBROWSE_GETLIST) &&
+		mem_comp(pPacket->m_pData, SERVERBROWSE_GETLIST, sizeof(SERVERBROWSE_GETLIST)) == 0)
+	{
+		// someone requested the list
+		dbg_msg("mastersrv", "requested, responding with %d m_aServers", pList->m_NumServers);
 
-			m_aPacketsLegacy[m_NumPacketsLegacy-1].m_Size = sizeof(SERVERBROWSE_LIST_LEGACY) + sizeof(CMastersrvAddrLegacy)*PacketIndexLegacy;
+		CNetChunk p;
+		p.m_ClientID = -1;
+		p.m_Address = pPacket->m_Address;
+		p.m_Flags = NETSENDFLAG_CONNLESS;
 
-			pCurrent++;
+		for(int i = 0; i < pList->m_NumPackets; i++)
+		{
+			p.m_DataSize = pList->m_pPackets[i].m_Size;
+			p.m_pData = &pList->m_pPackets[i].m_Data;
+			pNet->Send(&p);
 		}
-		else
+	}
+	else if(pPacket->m_DataSize == sizeof(SERVERBROWSE_GETLIST_DELTA)+4 &&
+		mem_comp(pPacket->m_pData, SERVERBROWSE_GETLIST_DELTA, sizeof(SERVERBROWSE_GETLIST_DELTA)) == 0)
+	{
+		// someone requested the changes since its last list
+		unsigned char *d = (unsigned char *)pPacket->m_pData+sizeof(SERVERBROWSE_GETLIST_DELTA);
+		unsigned Version = (d[0]<<24) | (d[1]<<16) | (d[2]<<8) | d[3];
+		dbg_msg("mastersrv", "requested changes since %u, now at %u", Version, pList->m_ListVersion);
+
+		SendListDelta(pNet, &pPacket->m_Address, Version, pList);
+	}
+	else if(pPacket->m_DataSize == sizeof(SERVERBROWSE_GETLIST_LEGACY) &&
+		mem_comp(pPacket->m_pData, SERVERBROWSE_GETLIST_LEGACY, sizeof(SERVERBROWSE_GETLIST_LEGACY)) == 0)
+	{
+		// someone requested the list
+		dbg_msg("mastersrv", "requested, responding with %d m_aServers", pList->m_NumServers);
+
+		CNetChunk p;
+		p.m_ClientID = -1;
+		p.m_Address = pPacket->m_Address;
+		p.m_Flags = NETSENDFLAG_CONNLESS;
+
+		for(int i = 0; i < pList->m_NumPacketsLegacy; i++)
 		{
-			*pCurrent = m_aServers[m_NumServers-1];
-			m_NumServers--;
-			dbg_msg("mastersrv", "error: server of invalid type, dropping it");
+			p.m_DataSize = pList->m_pPacketsLegacy[i].m_Size;
+			p.m_pData = &pList->m_pPacketsLegacy[i].m_Data;
+			pNet->Send(&p);
 		}
 	}
+	else
+		return false;
+	return true;
+}
+
+bool ParseHeartbeat(CNetChunk *pPacket, CHeartbeat *pHeartbeat)
+{
+	if(pPacket->m_DataSize == sizeof(SERVERBROWSE_HEARTBEAT)+2 &&
+		mem_comp(pPacket->m_pData, SERVERBROWSE_HEARTBEAT, sizeof(SERVERBROWSE_HEARTBEAT)) == 0)
+		pHeartbeat->m_Type = SERVERTYPE_NORMAL;
+	else if(pPacket->m_DataSize == sizeof(SERVERBROWSE_HEARTBEAT_LEGACY)+2 &&
+		mem_comp(pPacket->m_pData, SERVERBROWSE_HEARTBEAT_LEGACY, sizeof(SERVERBROWSE_HEARTBEAT_LEGACY)) == 0)
+		pHeartbeat->m_Type = SERVERTYPE_LEGACY;
+	else
+		return false;
+
+	unsigned char *d = (unsigned char *)pPacket->m_pData;
+	pHeartbeat->m_Address = pPacket->m_Address;
+	pHeartbeat->m_AltAddress = pPacket->m_Address;
+	pHeartbeat->m_AltAddress.port =
+		(d[sizeof(SERVERBROWSE_HEARTBEAT)]<<8) |
+		d[sizeof(SERVERBROWSE_HEARTBEAT)+1];
+	return true;
 }
 
 void SendOk(NETADDR *pAddr)
@@ -206,11 +664,19 @@ void SendCheck(NETADDR *pAddr)
 
 void AddCheckserver(NETADDR *pInfo, NETADDR *pAlt, ServerType Type)
 {
+	// already being checked, the running check answers this heartbeat too
+	if(m_CheckServerTable.Find(pInfo) != -1)
+		return;
+
 	// add server
-	if(m_NumCheckServers == MAX_SERVERS)
+	if(m_NumCheckServers == m_CheckServerCapacity)
 	{
-		dbg_msg("mastersrv", "error: mastersrv is full");
-		return;
+		m_CheckServerCapacity = max(m_CheckServerCapacity*2, 64);
+		CCheckServer *pNewCheckServers = (CCheckServer *)mem_alloc(m_CheckServerCapacity*sizeof(CCheckServer), 1);
+		if(m_NumCheckServers)
+			mem_copy(pNewCheckServers, m_pCheckServers, m_NumCheckServers*sizeof(CCheckServer));
+		mem_free(m_pCheckServers);
+		m_pCheckServers = pNewCheckServers;
 	}
 
 	char aAddrStr[NETADDR_MAXSTRSIZE];
@@ -218,43 +684,84 @@ void AddCheckserver(NETADDR *pInfo, NETADDR *pAlt, ServerType Type)
 	char aAltAddrStr[NETADDR_MAXSTRSIZE];
 	net_addr_str(pAlt, aAltAddrStr, sizeof(aAltAddrStr), true);
 	dbg_msg("mastersrv", "checking: %s (%s)", aAddrStr, aAltAddrStr);
-	m_aCheckServers[m_NumCheckServers].m_Address = *pInfo;
-	m_aCheckServers[m_NumCheckServers].m_AltAddress = *pAlt;
-	m_aCheckServers[m_NumCheckServers].m_TryCount = 0;
-	m_aCheckServers[m_NumCheckServers].m_TryTime = 0;
-	m_aCheckServers[m_NumCheckServers].m_Type = Type;
+	m_pCheckServers[m_NumCheckServers].m_Address = *pInfo;
+	m_pCheckServers[m_NumCheckServers].m_AltAddress = *pAlt;
+	m_pCheckServers[m_NumCheckServers].m_TryCount = 0;
+	m_pCheckServers[m_NumCheckServers].m_TryTime = 0;
+	m_pCheckServers[m_NumCheckServers].m_Type = Type;
+	m_CheckServerTable.Set(pInfo, m_NumCheckServers);
+	if(m_CheckServerTable.Find(pAlt) == -1)
+		m_CheckServerTable.Set(pAlt, m_NumCheckServers);
 	m_NumCheckServers++;
 }
 
 void AddServer(NETADDR *pInfo, ServerType Type)
 {
 	// see if server already exists in list
-	for(int i = 0; i < m_NumServers; i++)
+	int Index = m_ServerTable.Find(pInfo);
+	if(Index != -1)
 	{
-		if(net_addr_comp(&m_aServers[i].m_Address, pInfo) == 0)
+		char aAddrStr[NETADDR_MAXSTRSIZE];
+		net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
+		dbg_msg("mastersrv", "updated: %s", aAddrStr);
+
+		// it expires last now, move it to the end of the expire list
+		CServerEntry *pEntry = &m_pServers[Index];
+		pEntry->m_Expire = time_get()+time_freq()*EXPIRE_TIME;
+		if(m_LastExpire != Index)
 		{
-			char aAddrStr[NETADDR_MAXSTRSIZE];
-			net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
-			dbg_msg("mastersrv", "updated: %s", aAddrStr);
-			m_aServers[i].m_Expire = time_get()+time_freq()*EXPIRE_TIME;
-			return;
+			if(pEntry->m_PrevExpire != -1)
+				m_pServers[pEntry->m_PrevExpire].m_NextExpire = pEntry->m_NextExpire;
+			else
+				m_FirstExpire = pEntry->m_NextExpire;
+			m_pServers[pEntry->m_NextExpire].m_PrevExpire = pEntry->m_PrevExpire;
+
+			pEntry->m_PrevExpire = m_LastExpire;
+			pEntry->m_NextExpire = -1;
+			m_pServers[m_LastExpire].m_NextExpire = Index;
+			m_LastExpire = Index;
 		}
+		return;
 	}
 
 	// add server
-	if(m_NumServers == MAX_SERVERS)
+	if(m_NumServers == m_ServerCapacity)
 	{
-		dbg_msg("mastersrv", "error: mastersrv is full");
-		return;
+		m_ServerCapacity = max(m_ServerCapacity*2, 1024);
+		CServerEntry *pNewServers = (CServerEntry *)mem_alloc(m_ServerCapacity*sizeof(CServerEntry), 1);
+		int *pNewListServers = (int *)mem_alloc(m_ServerCapacity*sizeof(int), 1);
+		int *pNewListServersLegacy = (int *)mem_alloc(m_ServerCapacity*sizeof(int), 1);
+		if(m_NumServers)
+		{
+			mem_copy(pNewServers, m_pServers, m_NumServers*sizeof(CServerEntry));
+			mem_copy(pNewListServers, m_pListServers, m_NumListServers*sizeof(int));
+			mem_copy(pNewListServersLegacy, m_pListServersLegacy, m_NumListServersLegacy*sizeof(int));
+		}
+		mem_free(m_pServers);
+		mem_free(m_pListServers);
+		mem_free(m_pListServersLegacy);
+		m_pServers = pNewServers;
+		m_pListServers = pNewListServers;
+		m_pListServersLegacy = pNewListServersLegacy;
 	}
 
 	char aAddrStr[NETADDR_MAXSTRSIZE];
 	net_addr_str(pInfo, aAddrStr, sizeof(aAddrStr), true);
 	dbg_msg("mastersrv", "added: %s", aAddrStr);
-	m_aServers[m_NumServers].m_Address = *pInfo;
-	m_aServers[m_NumServers].m_Expire = time_get()+time_freq()*EXPIRE_TIME;
-	m_aServers[m_NumServers].m_Type = Type;
-	m_NumServers++;
+	Index = m_NumServers++;
+	m_pServers[Index].m_Address = *pInfo;
+	m_pServers[Index].m_Expire = time_get()+time_freq()*EXPIRE_TIME;
+	m_pServers[Index].m_Type = Type;
+	m_pServers[Index].m_PrevExpire = m_LastExpire;
+	m_pServers[Index].m_NextExpire = -1;
+	if(m_LastExpire != -1)
+		m_pServers[m_LastExpire].m_NextExpire = Index;
+	else
+		m_FirstExpire = Index;
+	m_LastExpire = Index;
+	m_ServerTable.Set(pInfo, Index);
+	AddToList(Index);
+	m_NumAdded++;
 }
 
 void UpdateServers()
@@ -263,30 +770,29 @@ void UpdateServers()
 	int64 Freq = time_freq();
 	for(int i = 0; i < m_NumCheckServers; i++)
 	{
-		if(Now > m_aCheckServers[i].m_TryTime+Freq)
+		if(Now > m_pCheckServers[i].m_TryTime+Freq*CHECK_RETRY_TIME)
 		{
-			if(m_aCheckServers[i].m_TryCount == 10)
+			if(m_pCheckServers[i].m_TryCount == 10)
 			{
 				char aAddrStr[NETADDR_MAXSTRSIZE];
-				net_addr_str(&m_aCheckServers[i].m_Address, aAddrStr, sizeof(aAddrStr), true);
+				net_addr_str(&m_pCheckServers[i].m_Address, aAddrStr, sizeof(aAddrStr), true);
 				char aAltAddrStr[NETADDR_MAXSTRSIZE];
-				net_addr_str(&m_aCheckServers[i].m_AltAddress, aAltAddrStr, sizeof(aAltAddrStr), true);
+				net_addr_str(&m_pCheckServers[i].m_AltAddress, aAltAddrStr, sizeof(aAltAddrStr), true);
 				dbg_msg("mastersrv", "check failed: %s (%s)", aAddrStr, aAltAddrStr);
 
 				// FAIL!!
-				SendError(&m_aCheckServers[i].m_Address);
-				m_aCheckServers[i] = m_aCheckServers[m_NumCheckServers-1];
-				m_NumCheckServers--;
+				SendError(&m_pCheckServers[i].m_Address);
+				RemoveCheckServer(i);
 				i--;
 			}
 			else
 			{
-				m_aCheckServers[i].m_TryCount++;
-				m_aCheckServers[i].m_TryTime = Now;
-				if(m_aCheckServers[i].m_TryCount&1)
-					SendCheck(&m_aCheckServers[i].m_Address);
+				m_pCheckServers[i].m_TryCount++;
+				m_pCheckServers[i].m_TryTime = Now;
+				if(m_pCheckServers[i].m_TryCount&1)
+					SendCheck(&m_pCheckServers[i].m_Address);
 				else
-					SendCheck(&m_aCheckServers[i].m_AltAddress);
+					SendCheck(&m_pCheckServers[i].m_AltAddress);
 			}
 		}
 	}
@@ -294,41 +800,202 @@ void UpdateServers()
 
 void PurgeServers()
 {
+	// every server gets the same expire time, so the expire list is sorted and only its head needs checking
 	int64 Now = time_get();
-	int i = 0;
-	while(i < m_NumServers)
+	while(m_FirstExpire != -1 && m_pServers[m_FirstExpire].m_Expire < Now)
+	{
+		// remove server
+		char aAddrStr[NETADDR_MAXSTRSIZE];
+		net_addr_str(&m_pServers[m_FirstExpire].m_Address, aAddrStr, sizeof(aAddrStr), true);
+		dbg_msg("mastersrv", "expired: %s", aAddrStr);
+		RemoveServer(m_FirstExpire);
+		m_NumExpired++;
+	}
+}
+
+void GetLiveList(CListSnapshot *pList)
+{
+	pList->m_pPackets = m_pPackets;
+	pList->m_NumPackets = m_NumPackets;
+	pList->m_pPacketsLegacy = m_pPacketsLegacy;
+	pList->m_NumPacketsLegacy = m_NumPacketsLegacy;
+	pList->m_NumServers = m_NumServers;
+	pList->m_NumListServers = m_NumListServers;
+	pList->m_pChangeLog = m_aChangeLog;
+	pList->m_NumChanges = m_NumChanges;
+	pList->m_ListVersion = m_ListVersion;
+}
+
+CListSnapshot *CreateSnapshot()
+{
+	CListSnapshot *pSnapshot = (CListSnapshot *)mem_alloc(sizeof(CListSnapshot), 1);
+	GetLiveList(pSnapshot);
+
+	CPacketData *pPackets = (CPacketData *)mem_alloc(max(m_NumPackets, 1)*sizeof(CPacketData), 1);
+	mem_copy(pPackets, m_pPackets, m_NumPackets*sizeof(CPacketData));
+	pSnapshot->m_pPackets = pPackets;
+	CPacketDataLegacy *pPacketsLegacy = (CPacketDataLegacy *)mem_alloc(max(m_NumPacketsLegacy, 1)*sizeof(CPacketDataLegacy), 1);
+	mem_copy(pPacketsLegacy, m_pPacketsLegacy, m_NumPacketsLegacy*sizeof(CPacketDataLegacy));
+	pSnapshot->m_pPacketsLegacy = pPacketsLegacy;
+	CListChange *pChangeLog = (CListChange *)mem_alloc(sizeof(m_aChangeLog), 1);
+	mem_copy(pChangeLog, m_aChangeLog, sizeof(m_aChangeLog));
+	pSnapshot->m_pChangeLog = pChangeLog;
+	return pSnapshot;
+}
+
+void FreeSnapshot(CListSnapshot *pSnapshot)
+{
+	mem_free((void *)pSnapshot->m_pPackets);
+	mem_free((void *)pSnapshot->m_pPacketsLegacy);
+	mem_free((void *)pSnapshot->m_pChangeLog);
+	mem_free(pSnapshot);
+}
+
+void UpdateSnapshot()
+{
+	// the workers might still read the previous snapshot, only replace it once it is gone
+	if(m_pRetiredSnapshot)
+	{
+		for(int i = 0; i < m_NumWorkers; i++)
+		{
+			if(m_pWorkers[i].m_Quiescent == m_pRetiredQuiescent[i])
+				return;
+		}
+		FreeSnapshot(m_pRetiredSnapshot);
+		m_pRetiredSnapshot = 0;
+	}
+
+	if(m_ListChanges == m_SnapshotChanges)
+		return;
+
+	CListSnapshot *pSnapshot = CreateSnapshot();
+	m_pRetiredSnapshot = m_pSnapshot;
+	sync_barrier(); // the copy must be complete before the workers can see it
+	m_pSnapshot = pSnapshot;
+	sync_barrier();
+	for(int i = 0; i < m_NumWorkers; i++)
+		m_pRetiredQuiescent[i] = m_pWorkers[i].m_Quiescent;
+	m_SnapshotChanges = m_ListChanges;
+}
+
+void PauseWorkers(bool Pause)
+{
+	sync_barrier();
+	m_PauseWorkers = Pause;
+	if(!Pause)
+		return;
+
+	// wait until every worker finished the round it was in
+	sync_barrier();
+	for(int i = 0; i < m_NumWorkers; i++)
+	{
+		unsigned Quiescent = m_pWorkers[i].m_Quiescent;
+		while(m_pWorkers[i].m_Quiescent == Quiescent)
+			thread_sleep(1);
+	}
+}
+
+void QueueHeartbeat(const CHeartbeat *pHeartbeat)
+{
+	// servers send heartbeats again, dropping some when the main thread falls behind is fine
+	lock_wait(m_HeartbeatLock);
+	if(m_NumQueuedHeartbeats < HEARTBEAT_QUEUE_SIZE)
+		m_aHeartbeatQueue[m_NumQueuedHeartbeats++] = *pHeartbeat;
+	lock_release(m_HeartbeatLock);
+}
+
+void ProcessQueuedHeartbeats()
+{
+	lock_wait(m_HeartbeatLock);
+	int NumHeartbeats = m_NumQueuedHeartbeats;
+	mem_copy(m_aHeartbeats, m_aHeartbeatQueue, NumHeartbeats*sizeof(CHeartbeat));
+	m_NumQueuedHeartbeats = 0;
+	lock_release(m_HeartbeatLock);
+
+	for(int i = 0; i < NumHeartbeats; i++)
+		AddCheckserver(&m_aHeartbeats[i].m_Address, &m_aHeartbeats[i].m_AltAddress, m_aHeartbeats[i].m_Type);
+	m_NumHeartbeats += NumHeartbeats;
+}
+
+void WorkerThread(void *pUser)
+{
+	CWorker *pWorker = (CWorker *)pUser;
+
+	while(1)
+	{
+		if(!m_PauseWorkers)
+		{
+			const CListSnapshot *pList = m_pSnapshot;
+			pWorker->m_Net.Update();
+
+			CNetChunk Packet;
+			while(pWorker->m_Net.Recv(&Packet))
+			{
+				// check if the server is banned
+				if(m_NetBan.IsBanned(&Packet.m_Address, 0, 0))
+					continue;
+
+				CHeartbeat Heartbeat;
+				if(ParseHeartbeat(&Packet, &Heartbeat))
+					QueueHeartbeat(&Heartbeat);
+				else if(ProcessListRequest(&pWorker->m_Net, &Packet, pList))
+					pWorker->m_NumListRequests++;
+			}
+		}
+
+		// done with the snapshot
+		sync_barrier();
+		pWorker->m_Quiescent++;
+
+		// be nice to the CPU
+		thread_sleep(1);
+	}
+}
+
+void StartWorkers(NETADDR BindAddr, int NumWorkers)
+{
+	m_pWorkers = new CWorker[NumWorkers];
+	m_pRetiredQuiescent = (unsigned *)mem_alloc(NumWorkers*sizeof(unsigned), 1);
+	m_HeartbeatLock = lock_create();
+	m_pSnapshot = CreateSnapshot();
+	m_SnapshotChanges = m_ListChanges;
+
+	for(int i = 0; i < NumWorkers; i++)
 	{
-		if(m_aServers[i].m_Expire < Now)
+		if(!m_pWorkers[m_NumWorkers].m_Net.Open(BindAddr, NETCREATE_FLAG_REUSEPORT))
 		{
-			// remove server
-			char aAddrStr[NETADDR_MAXSTRSIZE];
-			net_addr_str(&m_aServers[i].m_Address, aAddrStr, sizeof(aAddrStr), true);
-			dbg_msg("mastersrv", "expired: %s", aAddrStr);
-			m_aServers[i] = m_aServers[m_NumServers-1];
-			m_NumServers--;
+			dbg_msg("mastersrv", "couldn't start network (worker %d)", i);
+			break;
 		}
-		else
-			i++;
+		m_pWorkers[m_NumWorkers].m_Quiescent = 0;
+		m_pWorkers[m_NumWorkers].m_NumListRequests = 0;
+		m_pWorkers[m_NumWorkers].m_ReportedListRequests = 0;
+		thread_detach(thread_create(WorkerThread, &m_pWorkers[m_NumWorkers]));
+		m_NumWorkers++;
 	}
+	dbg_msg("mastersrv", "answering list requests on %d threads", m_NumWorkers+1);
 }
 
 void ReloadBans()
 {
+	// the workers check bans too
+	PauseWorkers(true);
 	m_NetBan.UnbanAll();
 	m_pConsole->ExecuteFile("master.cfg");
+	PauseWorkers(false);
 }
 
 int main(int argc, const char **argv) // ignore_convention
 {
-	int64 LastBuild = 0, LastBanReload = 0;
+	int64 LastBuild = 0, LastBanReload = 0, LastCheck = 0, LastSnapshot = 0;
 	ServerType Type = SERVERTYPE_INVALID;
 	NETADDR BindAddr;
 
 	dbg_logger_stdout();
 	net_init();
 
-	mem_copy(m_CountData.m_Header, SERVERBROWSE_COUNT, sizeof(SERVERBROWSE_COUNT));
-	mem_copy(m_CountDataLegacy.m_Header, SERVERBROWSE_COUNT_LEGACY, sizeof(SERVERBROWSE_COUNT_LEGACY));
+	// start every run at a different version, so clients never mistake a list of an earlier run for the current one
+	m_ListVersion = ((unsigned)time_timestamp()^(unsigned)time_get())*2654435761u;
 
 	IKernel *pKernel = IKernel::Create();
 	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
@@ -360,11 +1027,14 @@ int main(int argc, const char **argv) // ignore_convention
 		BindAddr.port = MASTERSERVER_PORT;
 	}
 
-	if(!m_NetOp.Open(BindAddr, 0))
+	// the workers share the port with the main socket
+	if(!m_NetOp.Open(BindAddr, g_Config.m_MsWorkers ? NETCREATE_FLAG_REUSEPORT : 0))
 	{
 		dbg_msg("mastersrv", "couldn't start network (op)");
 		return -1;
 	}
+	if(g_Config.m_MsWorkers)
+		StartWorkers(BindAddr, g_Config.m_MsWorkers);
 	BindAddr.port = MASTERSERVER_PORT+1;
 	if(!m_NetChecker.Open(BindAddr, 0))
 	{
@@ -383,6 +1053,8 @@ int main(int argc, const char **argv) // ignore_convention
 		m_NetChecker.Update();
 
 		// process m_aPackets
+		CListSnapshot LiveList;
+		GetLiveList(&LiveList);
 		CNetChunk Packet;
 		while(m_NetOp.Recv(&Packet))
 		{
@@ -390,101 +1062,20 @@ int main(int argc, const char **argv) // ignore_convention
 			if(m_NetBan.IsBanned(&Packet.m_Address, 0, 0))
 				continue;
 
-			if(Packet.m_DataSize == sizeof(SERVERBROWSE_HEARTBEAT)+2 &&
-				mem_comp(Packet.m_pData, SERVERBROWSE_HEARTBEAT, sizeof(SERVERBROWSE_HEARTBEAT)) == 0)
-			{
-				NETADDR Alt;
-				unsigned char *d = (unsigned char *)Packet.m_pData;
-				Alt = Packet.m_Address;
-				Alt.port =
-					(d[sizeof(SERVERBROWSE_HEARTBEAT)]<<8) |
-					d[sizeof(SERVERBROWSE_HEARTBEAT)+1];
-
-				// add it
-				AddCheckserver(&Packet.m_Address, &Alt, SERVERTYPE_NORMAL);
-			}
-			else if(Packet.m_DataSize == sizeof(SERVERBROWSE_HEARTBEAT_LEGACY)+2 &&
-				mem_comp(Packet.m_pData, SERVERBROWSE_HEARTBEAT_LEGACY, sizeof(SERVERBROWSE_HEARTBEAT_LEGACY)) == 0)
+			CHeartbeat Heartbeat;
+			if(ParseHeartbeat(&Packet, &Heartbeat))
 			{
-				NETADDR Alt;
-				unsigned char *d = (unsigned char *)Packet.m_pData;
-				Alt = Packet.m_Address;
-				Alt.port =
-					(d[sizeof(SERVERBROWSE_HEARTBEAT)]<<8) |
-					d[sizeof(SERVERBROWSE_HEARTBEAT)+1];
-
 				// add it
-				AddCheckserver(&Packet.m_Address, &Alt, SERVERTYPE_LEGACY);
-			}
-
-			else if(Packet.m_DataSize == sizeof(SERVERBROWSE_GETCOUNT) &&
-				mem_comp(Packet.m_pData, SERVERBROWSE_GETCOUNT, sizeof(SERVERBROWSE_GETCOUNT)) == 0)
-			{
-				dbg_msg("mastersrv", "count requested, responding with %d", m_NumServers);
-
-				CNetChunk p;
-				p.m_ClientID = -1;
-				p.m_Address = Packet.m_Address;
-				p.m_Flags = NETSENDFLAG_CONNLESS;
-				p.m_DataSize = sizeof(m_CountData);
-				p.m_pData = &m_CountData;
-				m_CountData.m_High = (m_NumServers>>8)&0xff;
-				m_CountData.m_Low = m_NumServers&0xff;
-				m_NetOp.Send(&p);
-			}
-			else if(Packet.m_DataSize == sizeof(SERVERBROWSE_GETCOUNT_LEGACY) &&
-				mem_comp(Packet.m_pData, SERVERBROWSE_GETCOUNT_LEGACY, sizeof(SERVERBROWSE_GETCOUNT_LEGACY)) == 0)
-			{
-				dbg_msg("mastersrv", "count requested, responding with %d", m_NumServers);
-
-				CNetChunk p;
-				p.m_ClientID = -1;
-				p.m_Address = Packet.m_Address;
-				p.m_Flags = NETSENDFLAG_CONNLESS;
-				p.m_DataSize = sizeof(m_CountData);
-				p.m_pData = &m_CountDataLegacy;
-				m_CountDataLegacy.m_High = (m_NumServers>>8)&0xff;
-				m_CountDataLegacy.m_Low = m_NumServers&0xff;
-				m_NetOp.Send(&p);
-			}
-			else if(Packet.m_DataSize == sizeof(SERVERBROWSE_GETLIST) &&
-				mem_comp(Packet.m_pData, SERVERBROWSE_GETLIST, sizeof(SERVERBROWSE_GETLIST)) == 0)
-			{
-				// someone requested the list
-				dbg_msg("mastersrv", "requested, responding with %d m_aServers", m_NumServers);
-
-				CNetChunk p;
-				p.m_ClientID = -1;
-				p.m_Address = Packet.m_Address;
-				p.m_Flags = NETSENDFLAG_CONNLESS;
-
-				for(int i = 0; i < m_NumPackets; i++)
-				{
-					p.m_DataSize = m_aPackets[i].m_Size;
-					p.m_pData = &m_aPackets[i].m_Data;
-					m_NetOp.Send(&p);
-				}
-			}
-			else if(Packet.m_DataSize == sizeof(SERVERBROWSE_GETLIST_LEGACY) &&
-				mem_comp(Packet.m_pData, SERVERBROWSE_GETLIST_LEGACY, sizeof(SERVERBROWSE_GETLIST_LEGACY)) == 0)
-			{
-				// someone requested the list
-				dbg_msg("mastersrv", "requested, responding with %d m_aServers", m_NumServers);
-
-				CNetChunk p;
-				p.m_ClientID = -1;
-				p.m_Address = Packet.m_Address;
-				p.m_Flags = NETSENDFLAG_CONNLESS;
-
-				for(int i = 0; i < m_NumPacketsLegacy; i++)
-				{
-					p.m_DataSize = m_aPacketsLegacy[i].m_Size;
-					p.m_pData = &m_aPacketsLegacy[i].m_Data;
-					m_NetOp.Send(&p);
-				}
+				AddCheckserver(&Heartbeat.m_Address, &Heartbeat.m_AltAddress, Heartbeat.m_Type);
+				m_NumHeartbeats++;
 			}
+			else if(ProcessListRequest(&m_NetOp, &Packet, &LiveList))
+				m_NumListRequests++;
 		}
 
+		if(m_NumWorkers)
+			ProcessQueuedHeartbeats();
+
 		// process m_aPackets
 		while(m_NetChecker.Recv(&Packet))
 		{
@@ -497,16 +1088,11 @@ int main(int argc, const char **argv) // ignore_convention
 			{
 				Type = SERVERTYPE_INVALID;
 				// remove it from checking
-				for(int i = 0; i < m_NumCheckServers; i++)
+				int Index = m_CheckServerTable.Find(&Packet.m_Address);
+				if(Index != -1)
 				{
-					if(net_addr_comp(&m_aCheckServers[i].m_Address, &Packet.m_Address) == 0 ||
-						net_addr_comp(&m_aCheckServers[i].m_AltAddress, &Packet.m_Address) == 0)
-					{
-						Type = m_aCheckServers[i].m_Type;
-						m_NumCheckServers--;
-						m_aCheckServers[i] = m_aCheckServers[m_NumCheckServers];
-						break;
-					}
+					Type = m_pCheckServers[Index].m_Type;
+					RemoveCheckServer(Index);
 				}
 
 				// drops servers that were not in the CheckServers list
@@ -527,11 +1113,52 @@ int main(int argc, const char **argv) // ignore_convention
 
 		if(time_get()-LastBuild > time_freq()*5)
 		{
+			float Seconds = (time_get()-LastBuild)/(float)time_freq();
+			if(m_NumHeartbeats)
+			{
+				dbg_msg("mastersrv", "%d servers, %d checking, %.0f heartbeats/s, %d added, %d expired",
+					m_NumServers, m_NumCheckServers, m_NumHeartbeats/Seconds, m_NumAdded, m_NumExpired);
+				m_NumHeartbeats = 0;
+				m_NumAdded = 0;
+				m_NumExpired = 0;
+			}
+
+			// list requests answered by every thread, the main one first
+			int NumListRequests = m_NumListRequests;
+			char aThreads[256];
+			str_format(aThreads, sizeof(aThreads), "%.0f", m_NumListRequests/Seconds);
+			m_NumListRequests = 0;
+			for(int i = 0; i < m_NumWorkers; i++)
+			{
+				int Num = m_pWorkers[i].m_NumListRequests-m_pWorkers[i].m_ReportedListRequests;
+				m_pWorkers[i].m_ReportedListRequests += Num;
+				NumListRequests += Num;
+				char aBuf[32];
+				str_format(aBuf, sizeof(aBuf), " %.0f", Num/Seconds);
+				str_append(aThreads, aBuf, sizeof(aThreads));
+			}
+			if(NumListRequests)
+				dbg_msg("mastersrv", "%.0f list requests/s, %.0f per thread (%s)",
+					NumListRequests/Seconds, NumListRequests/Seconds/(m_NumWorkers+1), aThreads);
 			LastBuild = time_get();
 
 			PurgeServers();
+		}
+
+		// check often, sending every check at once makes the answers overflow the socket buffer
+		if(time_get()-LastCheck > time_freq()/10)
+		{
+			LastCheck = time_get();
+
 			UpdateServers();
-			BuildPackets();
+		}
+
+		// the workers answer from a copy of the list, don't copy it for every change
+		if(m_NumWorkers && time_get()-LastSnapshot > time_freq()/10)
+		{
+			LastSnapshot = time_get();
+
+			UpdateSnapshot();
 		}
 
 		// be nice to the CPU
@@ -11,17 +11,39 @@ enum ServerType
 	SERVERTYPE_LEGACY
 };
 
+static const int MAX_SERVERS_PER_DELTA_PACKET = 70;
+static const int MAX_DELTA_PACKETS = 256; // clients ignore longer answers
+
 struct CMastersrvAddr
 {
 	unsigned char m_aIp[16];
 	unsigned char m_aPort[2];
 };
 
+// header of every list delta packet, all numbers big endian
+struct CMastersrvListDelta
+{
+	unsigned char m_aBaseVersion[4]; // the changes apply to this version, 0 if the packets hold the whole list
+	unsigned char m_aVersion[4]; // version of the list after applying them
+	unsigned char m_aNumPackets[2];
+	unsigned char m_aPacket[2];
+};
+
+struct CMastersrvDeltaAddr
+{
+	CMastersrvAddr m_Addr;
+	unsigned char m_Removed;
+};
+
 static const unsigned char SERVERBROWSE_HEARTBEAT[] = {255, 255, 255, 255, 'b', 'e', 'a', '2'};
 
 static const unsigned char SERVERBROWSE_GETLIST[] = {255, 255, 255, 255, 'r', 'e', 'q', '2'};
 static const unsigned char SERVERBROWSE_LIST[] = {255, 255, 255, 255, 'l', 'i', 's', '2'};
 
+// followed by the 4 byte version of the list the client has, 0 for none
+static const unsigned char SERVERBROWSE_GETLIST_DELTA[] = {255, 255, 255, 255, 'r', 'e', 'q', 'd'};
+static const unsigned char SERVERBROWSE_LIST_DELTA[] = {255, 255, 255, 255, 'l', 'i', 's', 'd'};
+
 static const unsigned char SERVERBROWSE_GETCOUNT[] = {255, 255, 255, 255, 'c', 'o', 'u', '2'};
 static const unsigned char SERVERBROWSE_COUNT[] = {255, 255, 255, 255, 's', 'i', 'z', '2'};
 
@@ -0,0 +1,182 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/config.h>
+#include <engine/console.h>
+#include <engine/kernel.h>
+#include <engine/storage.h>
+#include <engine/shared/config.h>
+#include <engine/shared/netban.h>
+
+// loads a generated banlist and measures how fast addresses are checked against it
+// usage: ban_benchmark [bans] [lookups]
+
+static unsigned s_Seed = 2463534242u;
+
+static unsigned Random()
+{
+	// xorshift
+	s_Seed ^= s_Seed<<13;
+	s_Seed ^= s_Seed>>17;
+	s_Seed ^= s_Seed<<5;
+	return s_Seed;
+}
+
+static void RandomAddr(NETADDR *pAddr, int Type)
+{
+	mem_zero(pAddr, sizeof(NETADDR));
+	pAddr->type = Type;
+	for(int i = 0; i < (Type == NETTYPE_IPV4 ? 4 : 16); i++)
+		pAddr->ip[i] = Random()&0xff;
+}
+
+class CBenchmarkBan : public CNetBan
+{
+public:
+	// the slow way, to check the results
+	bool IsBannedLinear(const NETADDR *pAddr) const
+	{
+		for(CBanAddr *pBan = m_BanAddrPool.First(); pBan; pBan = pBan->m_pNext)
+		{
+			if(NetMatch(&pBan->m_Data, pAddr))
+				return true;
+		}
+		for(CBanRange *pBan = m_BanRangePool.First(); pBan; pBan = pBan->m_pNext)
+		{
+			if(NetMatch(&pBan->m_Data, pAddr))
+				return true;
+		}
+		return false;
+	}
+
+	int NumBans() const { return m_BanAddrPool.Num()+m_BanRangePool.Num(); }
+};
+
+static bool WriteBanlist(IStorage *pStorage, const char *pFilename, int NumBans)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+		return false;
+
+	// mostly single addresses like a blocklist, some subnets and odd ranges
+	char aBuf[256], aAddrStr1[NETADDR_MAXSTRSIZE], aAddrStr2[NETADDR_MAXSTRSIZE];
+	for(int i = 0; i < NumBans; i++)
+	{
+		int Kind = Random()%10;
+		int Type = Kind == 9 ? NETTYPE_IPV6 : NETTYPE_IPV4;
+		int Length = Type == NETTYPE_IPV4 ? 4 : 16;
+		NETADDR LB, UB;
+		RandomAddr(&LB, Type);
+		UB = LB;
+		if(Kind < 7)
+		{
+			net_addr_str(&LB, aAddrStr1, sizeof(aAddrStr1), false);
+			str_format(aBuf, sizeof(aBuf), "ban %s -1 generated", aAddrStr1);
+		}
+		else
+		{
+			if(Kind == 7)
+			{
+				// subnet
+				int HostBits = 4+Random()%(Length*2);
+				for(int b = 0; b < HostBits; b++)
+				{
+					LB.ip[Length-1-b/8] &= ~(1<<(b%8));
+					UB.ip[Length-1-b/8] |= 1<<(b%8);
+				}
+			}
+			else
+			{
+				// anything
+				UB.ip[Length-1] = Random()&0xff;
+				UB.ip[Length-2] = Random()&0xff;
+				if(mem_comp(UB.ip, LB.ip, Length) == 0)
+					UB.ip[Length-1] ^= 1;
+				if(mem_comp(UB.ip, LB.ip, Length) < 0)
+				{
+					NETADDR Temp = LB;
+					LB = UB;
+					UB = Temp;
+				}
+			}
+			net_addr_str(&LB, aAddrStr1, sizeof(aAddrStr1), false);
+			net_addr_str(&UB, aAddrStr2, sizeof(aAddrStr2), false);
+			str_format(aBuf, sizeof(aBuf), "ban_range %s %s -1 generated", aAddrStr1, aAddrStr2);
+		}
+		io_write(File, aBuf, str_length(aBuf));
+		io_write_newline(File);
+	}
+
+	io_close(File);
+	return true;
+}
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+
+	int NumBans = 100000;
+	int NumLookups = 1000000;
+	if(argc > 1)
+		NumBans = max(str_toint(argv[1]), 1);
+	if(argc > 2)
+		NumLookups = max(str_toint(argv[2]), 1);
+
+	IKernel *pKernel = IKernel::Create();
+	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+	IConfig *pConfig = CreateConfig();
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+
+	bool RegisterFail = !pKernel->RegisterInterface(pStorage);
+	RegisterFail |= !pKernel->RegisterInterface(pConsole);
+	RegisterFail |= !pKernel->RegisterInterface(pConfig);
+	if(RegisterFail)
+		return -1;
+
+	pConfig->Init();
+	CBenchmarkBan NetBan;
+	NetBan.Init(pConsole, pStorage);
+	pConsole->StoreCommands(false);
+
+	if(!WriteBanlist(pStorage, "ban_benchmark.cfg", NumBans))
+	{
+		dbg_msg("ban_benchmark", "failed to write banlist");
+		return -1;
+	}
+	pConsole->ExecuteLine("bans_load ban_benchmark.cfg");
+	pStorage->RemoveFile("ban_benchmark.cfg", IStorage::TYPE_SAVE);
+
+	// random addresses, mostly not banned
+	NETADDR *pAddrs = (NETADDR *)mem_alloc(NumLookups*sizeof(NETADDR), 1);
+	for(int i = 0; i < NumLookups; i++)
+		RandomAddr(&pAddrs[i], Random()%10 == 9 ? NETTYPE_IPV6 : NETTYPE_IPV4);
+
+	int NumBanned = 0;
+	int64 StartTime = time_get();
+	for(int i = 0; i < NumLookups; i++)
+	{
+		if(NetBan.IsBanned(&pAddrs[i], 0, 0))
+			NumBanned++;
+	}
+	int64 Time = time_get()-StartTime;
+	dbg_msg("ban_benchmark", "%d bans, %d lookups in %.2f ms, %.0f ns per lookup, %d banned", NetBan.NumBans(), NumLookups,
+		Time*1000.0/time_freq(), Time*1000000000.0/time_freq()/NumLookups, NumBanned);
+
+	// compare a part of them with the slow way
+	int NumChecks = min(NumLookups, 2000);
+	int NumWrong = 0;
+	for(int i = 0; i < NumChecks; i++)
+	{
+		if(NetBan.IsBanned(&pAddrs[i], 0, 0) != NetBan.IsBannedLinear(&pAddrs[i]))
+			NumWrong++;
+	}
+	dbg_msg("ban_benchmark", "checked %d lookups against a linear scan, %d wrong", NumChecks, NumWrong);
+
+	StartTime = time_get();
+	pConsole->ExecuteLine("unban_all");
+	dbg_msg("ban_benchmark", "unbanned all in %.2f ms", (time_get()-StartTime)*1000.0/time_freq());
+
+	mem_free(pAddrs);
+	return NumWrong ? 1 : 0;
+}
@@ -1,12 +1,15 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <stdlib.h> //rand
+#include <base/math.h>
 #include <base/system.h>
 #include <engine/shared/config.h>
 #include <engine/shared/network.h>
 #include <mastersrv/mastersrv.h>
 
-CNetServer *pNet;
+NETSOCKET *pSockets; // one for every simulated server
+int NumServers = 1;
+int HeartbeatRate = 0; // heartbeats per second over all servers, 0 for one every 15-30 seconds each
 
 int Progression = 50;
 int GameType = 0;
@@ -27,26 +30,26 @@ int MaxPlayers = 0;
 char aInfoMsg[1024];
 int aInfoMsgSize;
 
-static void SendHeartBeats()
+// load statistics, reported every few seconds when simulating more than one server
+int NumHeartbeats = 0;
+int NumChecks = 0;
+int NumOks = 0;
+int NumErrors = 0;
+
+static void SendHeartBeats(int Server)
 {
 	static unsigned char aData[sizeof(SERVERBROWSE_HEARTBEAT) + 2];
-	CNetChunk Packet;
 
 	mem_copy(aData, SERVERBROWSE_HEARTBEAT, sizeof(SERVERBROWSE_HEARTBEAT));
 
-	Packet.m_ClientID = -1;
-	Packet.m_Flags = NETSENDFLAG_CONNLESS;
-	Packet.m_DataSize = sizeof(SERVERBROWSE_HEARTBEAT) + 2;
-	Packet.m_pData = &aData;
-
 	/* supply the set port that the master can use if it has problems */
 	aData[sizeof(SERVERBROWSE_HEARTBEAT)] = 0;
 	aData[sizeof(SERVERBROWSE_HEARTBEAT)+1] = 0;
 
 	for(int i = 0; i < NumMasters; i++)
 	{
-		Packet.m_Address = aMasterServers[i];
-		pNet->Send(&Packet);
+		CNetBase::SendPacketConnless(pSockets[Server], &aMasterServers[i], aData, sizeof(aData));
+		NumHeartbeats++;
 	}
 }
 
@@ -86,76 +89,127 @@ static void BuildInfoMsg()
 	}
 }
 
-static void SendServerInfo(NETADDR *pAddr)
+static void SendServerInfo(int Server, NETADDR *pAddr)
 {
-	CNetChunk p;
-	p.m_ClientID = -1;
-	p.m_Address = *pAddr;
-	p.m_Flags = NETSENDFLAG_CONNLESS;
-	p.m_DataSize = aInfoMsgSize;
-	p.m_pData = aInfoMsg;
-	pNet->Send(&p);
+	CNetBase::SendPacketConnless(pSockets[Server], pAddr, aInfoMsg, aInfoMsgSize);
 }
 
-static void SendFWCheckResponse(NETADDR *pAddr)
+static void SendFWCheckResponse(int Server, NETADDR *pAddr)
 {
-	CNetChunk p;
-	p.m_ClientID = -1;
-	p.m_Address = *pAddr;
-	p.m_Flags = NETSENDFLAG_CONNLESS;
-	p.m_DataSize = sizeof(SERVERBROWSE_FWRESPONSE);
-	p.m_pData = SERVERBROWSE_FWRESPONSE;
-	pNet->Send(&p);
+	CNetBase::SendPacketConnless(pSockets[Server], pAddr, SERVERBROWSE_FWRESPONSE, sizeof(SERVERBROWSE_FWRESPONSE));
+}
+
+static void ProcessPackets(int Server)
+{
+	static unsigned char aBuffer[NET_MAX_PACKETSIZE];
+	static CNetPacketConstruct Packet;
+	NETADDR Addr;
+	int Bytes;
+
+	while((Bytes = net_udp_recv(pSockets[Server], &Addr, aBuffer, sizeof(aBuffer))) > 0)
+	{
+		if(CNetBase::UnpackPacket(aBuffer, Bytes, &Packet) != 0 || !(Packet.m_Flags&NET_PACKETFLAG_CONNLESS))
+			continue;
+
+		if(Packet.m_DataSize == sizeof(SERVERBROWSE_GETINFO) &&
+			mem_comp(Packet.m_aChunkData, SERVERBROWSE_GETINFO, sizeof(SERVERBROWSE_GETINFO)) == 0)
+		{
+			SendServerInfo(Server, &Addr);
+		}
+		else if(Packet.m_DataSize == sizeof(SERVERBROWSE_FWCHECK) &&
+			mem_comp(Packet.m_aChunkData, SERVERBROWSE_FWCHECK, sizeof(SERVERBROWSE_FWCHECK)) == 0)
+		{
+			SendFWCheckResponse(Server, &Addr);
+			NumChecks++;
+		}
+		else if(Packet.m_DataSize == sizeof(SERVERBROWSE_FWOK) &&
+			mem_comp(Packet.m_aChunkData, SERVERBROWSE_FWOK, sizeof(SERVERBROWSE_FWOK)) == 0)
+		{
+			NumOks++;
+		}
+		else if(Packet.m_DataSize == sizeof(SERVERBROWSE_FWERROR) &&
+			mem_comp(Packet.m_aChunkData, SERVERBROWSE_FWERROR, sizeof(SERVERBROWSE_FWERROR)) == 0)
+		{
+			NumErrors++;
+		}
+	}
 }
 
 static int Run()
 {
-	int64 NextHeartBeat = 0;
 	NETADDR BindAddr = {NETTYPE_IPV4, {0},0};
+	int64 *pNextHeartBeat = new int64[NumServers];
+	int64 NextHeartBeat = time_get();
+	int64 LastReport = time_get();
+	int NextServer = 0;
 
-	if(!pNet->Open(BindAddr, 0, 0, 0, 0))
-		return 0;
+	pSockets = new NETSOCKET[NumServers];
+	for(int i = 0; i < NumServers; i++)
+	{
+		pSockets[i] = net_udp_create(BindAddr);
+		if(!pSockets[i].type)
+		{
+			dbg_msg("fake_server", "couldn't open socket %d of %d", i+1, NumServers);
+			return 0;
+		}
+		pNextHeartBeat[i] = 0;
+	}
 
 	while(1)
 	{
-		CNetChunk p;
-		pNet->Update();
-		while(pNet->Recv(&p))
+		for(int i = 0; i < NumServers; i++)
+			ProcessPackets(i);
+
+		/* send heartbeats if needed */
+		if(HeartbeatRate)
 		{
-			if(p.m_ClientID == -1)
+			// spread the heartbeats evenly over the servers, but don't try to catch up on more than a second
+			int64 Now = time_get();
+			if(NextHeartBeat < Now-time_freq())
+				NextHeartBeat = Now-time_freq();
+			while(NextHeartBeat < Now)
 			{
-				if(p.m_DataSize == sizeof(SERVERBROWSE_GETINFO) &&
-					mem_comp(p.m_pData, SERVERBROWSE_GETINFO, sizeof(SERVERBROWSE_GETINFO)) == 0)
-				{
-					SendServerInfo(&p.m_Address);
-				}
-				else if(p.m_DataSize == sizeof(SERVERBROWSE_FWCHECK) &&
-					mem_comp(p.m_pData, SERVERBROWSE_FWCHECK, sizeof(SERVERBROWSE_FWCHECK)) == 0)
+				SendHeartBeats(NextServer);
+				NextServer = (NextServer+1)%NumServers;
+				NextHeartBeat += time_freq()/HeartbeatRate;
+			}
+		}
+		else
+		{
+			for(int i = 0; i < NumServers; i++)
+			{
+				if(pNextHeartBeat[i] < time_get())
 				{
-					SendFWCheckResponse(&p.m_Address);
+					pNextHeartBeat[i] = time_get()+time_freq()*(15+(rand()%15));
+					SendHeartBeats(i);
 				}
 			}
 		}
 
-		/* send heartbeats if needed */
-		if(NextHeartBeat < time_get())
+		if(NumServers > 1 && time_get()-LastReport > time_freq()*5)
 		{
-			NextHeartBeat = time_get()+time_freq()*(15+(rand()%15));
-			SendHeartBeats();
+			float Seconds = (time_get()-LastReport)/(float)time_freq();
+			dbg_msg("fake_server", "%.0f heartbeats/s, %.0f checks/s, %.0f registered/s, %d errors",
+				NumHeartbeats/Seconds, NumChecks/Seconds, NumOks/Seconds, NumErrors);
+			NumHeartbeats = 0;
+			NumChecks = 0;
+			NumOks = 0;
+			NumErrors = 0;
+			LastReport = time_get();
 		}
 
-		thread_sleep(100);
+		thread_sleep(HeartbeatRate ? 10 : 100);
 	}
 }
 
 int main(int argc, char **argv)
 {
-	pNet = new CNetServer;
+	dbg_logger_stdout();
+	net_init();
 
 	while(argc)
 	{
-		// ?
-		/*if(str_comp(*argv, "-m") == 0)
+		if(str_comp(*argv, "-m") == 0 && NumMasters < 16)
 		{
 			argc--; argv++;
 			net_host_lookup(*argv, &aMasterServers[NumMasters], NETTYPE_IPV4);
@@ -163,7 +217,17 @@ int main(int argc, char **argv)
 			aMasterServers[NumMasters].port = str_toint(*argv);
 			NumMasters++;
 		}
-		else */if(str_comp(*argv, "-p") == 0)
+		else if(str_comp(*argv, "-s") == 0)
+		{
+			argc--; argv++;
+			NumServers = max(str_toint(*argv), 1);
+		}
+		else if(str_comp(*argv, "-r") == 0)
+		{
+			argc--; argv++;
+			HeartbeatRate = max(str_toint(*argv), 0);
+		}
+		else if(str_comp(*argv, "-p") == 0)
 		{
 			argc--; argv++;
 			PlayerNames[NumPlayers++] = *argv;
@@ -205,9 +269,6 @@ int main(int argc, char **argv)
 	}
 
 	BuildInfoMsg();
-	int RunReturn = Run();
-
-	delete pNet;
-	return RunReturn;
+	return Run();
 }
 
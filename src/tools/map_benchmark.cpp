@@ -0,0 +1,96 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/shared/datafile.h>
+#include <engine/storage.h>
+
+// resaves every map in maps/ and reports how long writing took
+// usage: map_benchmark [threads] [compression level] [runs]
+
+static IStorage *s_pStorage = 0;
+static int s_NumThreads = CDataFileWriter::DEFAULT_THREADS;
+static int s_CompressionLevel = CDataFileWriter::COMPRESSION_DEFAULT;
+static int s_NumRuns = 5;
+static int s_NumMaps = 0;
+static int64 s_TotalTime = 0;
+static unsigned s_TotalSize = 0;
+
+int MaplistCallback(const char *pName, int IsDir, int DirType, void *pUser)
+{
+	int l = str_length(pName);
+	if(l < 4 || IsDir || str_comp(pName+l-4, ".map") != 0)
+		return 0;
+
+	char aBuf[128];
+	str_format(aBuf, sizeof(aBuf), "maps/%s", pName);
+
+	CDataFileReader DataFile;
+	if(!DataFile.Open(s_pStorage, aBuf, DirType))
+		return 0;
+
+	// decompress everything up front so only the writer is measured
+	for(int i = 0; i < DataFile.NumData(); i++)
+		DataFile.GetData(i);
+
+	int64 BestTime = -1;
+	for(int Run = 0; Run < s_NumRuns; Run++)
+	{
+		CDataFileWriter Writer;
+		if(!Writer.Open(s_pStorage, "map_benchmark.map", s_CompressionLevel, s_NumThreads))
+		{
+			dbg_msg("map_benchmark", "failed to open output file");
+			return 1;
+		}
+
+		int64 StartTime = time_get();
+		for(int i = 0; i < DataFile.NumItems(); i++)
+		{
+			int Type, ID;
+			void *pItem = DataFile.GetItem(i, &Type, &ID);
+			Writer.AddItem(Type, ID, DataFile.GetItemSize(i), pItem);
+		}
+		for(int i = 0; i < DataFile.NumData(); i++)
+			Writer.AddData(DataFile.GetUncompressedDataSize(i), DataFile.GetData(i));
+		Writer.Finish();
+		int64 Time = time_get()-StartTime;
+
+		if(BestTime < 0 || Time < BestTime)
+			BestTime = Time;
+	}
+	DataFile.Close();
+
+	IOHANDLE File = s_pStorage->OpenFile("map_benchmark.map", IOFLAG_READ, IStorage::TYPE_SAVE);
+	unsigned Size = File ? io_length(File) : 0;
+	if(File)
+		io_close(File);
+
+	dbg_msg("map_benchmark", "%-24s %8u bytes %8.2f ms", pName, Size, BestTime*1000.0/time_freq());
+	s_NumMaps++;
+	s_TotalTime += BestTime;
+	s_TotalSize += Size;
+	return 0;
+}
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+
+	s_pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+	if(!s_pStorage)
+		return -1;
+
+	if(argc > 1)
+		s_NumThreads = str_toint(argv[1]);
+	if(argc > 2)
+		s_CompressionLevel = str_toint(argv[2]);
+	if(argc > 3)
+		s_NumRuns = max(str_toint(argv[3]), 1);
+
+	dbg_msg("map_benchmark", "threads=%d level=%d runs=%d", s_NumThreads, s_CompressionLevel, s_NumRuns);
+	s_pStorage->ListDirectory(IStorage::TYPE_ALL, "maps", MaplistCallback, 0);
+	s_pStorage->RemoveFile("map_benchmark.map", IStorage::TYPE_SAVE);
+
+	dbg_msg("map_benchmark", "%d maps, %u bytes, %.2f ms total", s_NumMaps, s_TotalSize, s_TotalTime*1000.0/time_freq());
+	return 0;
+}
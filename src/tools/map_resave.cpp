@@ -13,14 +13,16 @@ int main(int argc, const char **argv)
 	CDataFileReader DataFile;
 	CDataFileWriter df;
 
-	if(!pStorage || argc != 3)
+	if(!pStorage || argc < 3 || argc > 4)
 		return -1;
 
+	int CompressionLevel = argc == 4 ? str_toint(argv[3]) : CDataFileWriter::COMPRESSION_DEFAULT;
+
 	str_format(aFileName, sizeof(aFileName), "%s", argv[2]);
 
 	if(!DataFile.Open(pStorage, argv[1], IStorage::TYPE_ALL))
 		return -1;
-	if(!df.Open(pStorage, aFileName))
+	if(!df.Open(pStorage, aFileName, CompressionLevel))
 		return -1;
 
 	// add all items
@@ -35,7 +37,7 @@ int main(int argc, const char **argv)
 	for(Index = 0; Index < DataFile.NumData(); Index++)
 	{
 		pPtr = DataFile.GetData(Index);
-		Size = DataFile.GetDataSize(Index);
+		Size = DataFile.GetUncompressedDataSize(Index);
 		df.AddData(Size, pPtr);
 	}
 